@@ -0,0 +1,141 @@
+/**
+ * @file acpi.c
+ * @author Robert McKay
+ * @brief Finds the interrupt controllers and processors through the ACPI MADT.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "acpi.h"
+#include "buffer.h"
+#include "scheduler.h"
+#include "cpu.h"
+
+unsigned int cpu_count;
+unsigned char cpu_apic_ids[MAX_CPUS];
+unsigned int lapic_address;
+unsigned int ioapic_address;
+unsigned int isa_irq_gsi[ISA_IRQS];
+unsigned short isa_irq_flags[ISA_IRQS];
+
+/**
+ * @brief Compares a fixed length signature.
+ *
+ * @param found The signature in memory.
+ * @param expected The expected signature.
+ * @param length Number of characters to compare.
+ * @return int TRUE if the signatures match, FALSE otherwise.
+ */
+INIT static int signature_matches(char* found, char* expected, int length) {
+    for (int i = 0; i < length; i++) {
+        if (found[i] != expected[i]) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+INIT int init_acpi() {
+    rsdp_t* rsdp;
+    madt_t* madt;
+
+    /* identity mapping and no overrides until the MADT says otherwise */
+    cpu_count = 0;
+    lapic_address = DEFAULT_LAPIC_ADDRESS;
+    ioapic_address = 0;
+    for (int i = 0; i < ISA_IRQS; i++) {
+        isa_irq_gsi[i] = i;
+        isa_irq_flags[i] = 0;
+    }
+
+    /* the RSDP is in the first KB of the EBDA or in the BIOS area; the
+       compiler assumes nothing is in the first page, so it does not see
+       where the pointer to the EBDA is read from */
+    unsigned short* ebda_pointer = (unsigned short*)EBDA_POINTER;
+    asm ("" : "+r" (ebda_pointer));
+    unsigned int ebda = *ebda_pointer << 4;
+    rsdp = find_rsdp(ebda, ebda + EBDA_SEARCH_SIZE);
+    if (rsdp == NULL) {
+        rsdp = find_rsdp(BIOS_AREA_START, BIOS_AREA_END);
+    }
+    if (rsdp == NULL) {
+        return FALSE;
+    }
+    madt = (madt_t*)find_table(rsdp, "APIC");
+    if (madt == NULL) {
+        return FALSE;
+    }
+    parse_madt(madt);
+    return ioapic_address != 0 && cpu_count != 0;
+}
+
+INIT rsdp_t* find_rsdp(unsigned int start, unsigned int end) {
+    for (unsigned int addr = start; addr < end; addr += RSDP_ALIGN) {
+        rsdp_t* rsdp = (rsdp_t*)addr;
+        if (signature_matches(rsdp->signature, "RSD PTR ", 8) == TRUE &&
+            checksum(rsdp, sizeof(rsdp_t)) == 0) {
+            return rsdp;
+        }
+    }
+    return NULL;
+}
+
+INIT sdt_header_t* find_table(rsdp_t* rsdp, char* signature) {
+    sdt_header_t* rsdt = (sdt_header_t*)rsdp->rsdt_address;
+    if (checksum(rsdt, rsdt->length) != 0) {
+        return NULL;
+    }
+    unsigned int* entries = (unsigned int*)(rsdt + 1);
+    int num_entries = (rsdt->length - sizeof(sdt_header_t)) / sizeof(unsigned int);
+    for (int i = 0; i < num_entries; i++) {
+        sdt_header_t* table = (sdt_header_t*)entries[i];
+        if (signature_matches(table->signature, signature, 4) == TRUE &&
+            checksum(table, table->length) == 0) {
+            return table;
+        }
+    }
+    return NULL;
+}
+
+INIT void parse_madt(madt_t* madt) {
+    unsigned char* next = (unsigned char*)madt + sizeof(madt_t);
+    unsigned char* end = (unsigned char*)madt + madt->header.length;
+
+    /* entries follow the fixed fields, each must fit in the table */
+    lapic_address = madt->lapic_address;
+    while (next + sizeof(madt_entry_t) <= end) {
+        madt_entry_t* entry = (madt_entry_t*)next;
+        if (entry->length < sizeof(madt_entry_t) || next + entry->length > end) {
+            break;
+        }
+        if (entry->type == MADT_LAPIC) {
+            madt_lapic_t* lapic = (madt_lapic_t*)entry;
+            if ((lapic->flags & MADT_LAPIC_ENABLED) && cpu_count < MAX_CPUS) {
+                cpu_apic_ids[cpu_count] = lapic->apic_id;
+                cpu_count++;
+            }
+        } else if (entry->type == MADT_IOAPIC) {
+            madt_ioapic_t* ioapic = (madt_ioapic_t*)entry;
+            if (ioapic->gsi_base == 0) {
+                ioapic_address = ioapic->address;
+            }
+        } else if (entry->type == MADT_ISO) {
+            madt_iso_t* iso = (madt_iso_t*)entry;
+            if (iso->bus == 0 && iso->source < ISA_IRQS) {
+                isa_irq_gsi[iso->source] = iso->gsi;
+                isa_irq_flags[iso->source] = iso->flags;
+            }
+        }
+        next += entry->length;
+    }
+}
+
+INIT unsigned char checksum(void* table, unsigned int length) {
+    unsigned char sum = 0;
+    unsigned char* bytes = (unsigned char*)table;
+    for (unsigned int i = 0; i < length; i++) {
+        sum += bytes[i];
+    }
+    return sum;
+}
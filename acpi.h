@@ -0,0 +1,200 @@
+/**
+ * @file acpi.h
+ * @author Robert McKay
+ * @brief Declares structures for locating the ACPI MADT (interrupt controllers).
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef ACPI_H
+#define ACPI_H
+
+#define MAX_CPUS 8
+#define ISA_IRQS 16
+
+/* regions searched for the root system description pointer */
+#define EBDA_POINTER 0x40e
+#define EBDA_SEARCH_SIZE 1024
+#define BIOS_AREA_START 0xe0000
+#define BIOS_AREA_END 0x100000
+#define RSDP_ALIGN 16
+
+/* madt entry types */
+#define MADT_LAPIC 0
+#define MADT_IOAPIC 1
+#define MADT_ISO 2
+#define MADT_LAPIC_ENABLED 0x1
+
+/* interrupt source override flags */
+#define ISO_POLARITY_MASK 0x3
+#define ISO_ACTIVE_LOW 0x3
+#define ISO_TRIGGER_MASK 0xc
+#define ISO_LEVEL 0xc
+
+/* defaults used by the legacy PC platform */
+#define DEFAULT_LAPIC_ADDRESS 0xfee00000
+#define DEFAULT_IOAPIC_ADDRESS 0xfec00000
+
+/**
+ * @brief Root system description pointer (ACPI 1.0 part).
+ *
+ */
+struct rsdp_s {
+    char signature[8];
+    unsigned char checksum;
+    char oem_id[6];
+    unsigned char revision;
+    unsigned int rsdt_address;
+} __attribute__ ((packed));
+
+/**
+ * @brief Header shared by all system description tables.
+ *
+ */
+struct sdt_header_s {
+    char signature[4];
+    unsigned int length;
+    unsigned char revision;
+    unsigned char checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    unsigned int oem_revision;
+    unsigned int creator_id;
+    unsigned int creator_revision;
+} __attribute__ ((packed));
+
+/**
+ * @brief Multiple APIC description table.
+ *
+ */
+struct madt_s {
+    struct sdt_header_s header;
+    unsigned int lapic_address;
+    unsigned int flags;
+} __attribute__ ((packed));
+
+/**
+ * @brief Header of a variable length MADT entry.
+ *
+ */
+struct madt_entry_s {
+    unsigned char type;
+    unsigned char length;
+} __attribute__ ((packed));
+
+/**
+ * @brief MADT entry describing a processor's local APIC.
+ *
+ */
+struct madt_lapic_s {
+    struct madt_entry_s entry;
+    unsigned char processor_id;
+    unsigned char apic_id;
+    unsigned int flags;
+} __attribute__ ((packed));
+
+/**
+ * @brief MADT entry describing an I/O APIC.
+ *
+ */
+struct madt_ioapic_s {
+    struct madt_entry_s entry;
+    unsigned char ioapic_id;
+    unsigned char reserved;
+    unsigned int address;
+    unsigned int gsi_base;
+} __attribute__ ((packed));
+
+/**
+ * @brief MADT entry overriding the wiring of an ISA interrupt.
+ *
+ */
+struct madt_iso_s {
+    struct madt_entry_s entry;
+    unsigned char bus;
+    unsigned char source;
+    unsigned int gsi;
+    unsigned short flags;
+} __attribute__ ((packed));
+
+/**
+ * @brief Type definitions for the ACPI structures.
+ *
+ */
+typedef struct rsdp_s rsdp_t;
+typedef struct sdt_header_s sdt_header_t;
+typedef struct madt_s madt_t;
+typedef struct madt_entry_s madt_entry_t;
+typedef struct madt_lapic_s madt_lapic_t;
+typedef struct madt_ioapic_s madt_ioapic_t;
+typedef struct madt_iso_s madt_iso_t;
+
+/**
+ * @brief Number of enabled processors listed in the MADT.
+ *
+ */
+extern unsigned int cpu_count;
+
+/**
+ * @brief Local APIC id of each enabled processor.
+ *
+ */
+extern unsigned char cpu_apic_ids[MAX_CPUS];
+
+/**
+ * @brief Physical addresses of the local APIC and the first I/O APIC.
+ *
+ */
+extern unsigned int lapic_address;
+extern unsigned int ioapic_address;
+
+/**
+ * @brief Global system interrupt and override flags for each ISA IRQ.
+ *
+ */
+extern unsigned int isa_irq_gsi[ISA_IRQS];
+extern unsigned short isa_irq_flags[ISA_IRQS];
+
+/**
+ * @brief Locates and parses the MADT.
+ *
+ * @return int TRUE if a MADT with an I/O APIC was found, FALSE otherwise.
+ */
+int init_acpi();
+
+/**
+ * @brief Searches a memory range for the RSDP.
+ *
+ * @param start First address to search.
+ * @param end Address after the last byte to search.
+ * @return rsdp_t* Pointer to the RSDP or NULL.
+ */
+rsdp_t* find_rsdp(unsigned int start, unsigned int end);
+
+/**
+ * @brief Finds a table with the given signature through the RSDT.
+ *
+ * @param rsdp Pointer to the RSDP.
+ * @param signature Four character table signature.
+ * @return sdt_header_t* Pointer to the table or NULL.
+ */
+sdt_header_t* find_table(rsdp_t* rsdp, char* signature);
+
+/**
+ * @brief Records processors, the I/O APIC and ISA overrides from the MADT.
+ *
+ * @param madt Pointer to the MADT.
+ */
+void parse_madt(madt_t* madt);
+
+/**
+ * @brief Computes the byte sum of a table.
+ *
+ * @param table Start of the table.
+ * @param length Length of the table in bytes.
+ * @return unsigned char The sum, which is zero for a valid table.
+ */
+unsigned char checksum(void* table, unsigned int length);
+
+#endif
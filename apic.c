@@ -0,0 +1,201 @@
+/**
+ * @file apic.c
+ * @author Robert McKay
+ * @brief Implements local APIC, I/O APIC and APIC timer support.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "apic.h"
+#include "acpi.h"
+#include "clock.h"
+#include "cpu.h"
+#include "boot2.h"
+#include "buffer.h"
+#include "scheduler.h"
+#include "smp.h"
+#include "lock.h"
+
+volatile unsigned int* lapic_eoi;
+unsigned int timer_mode;
+
+/**
+ * @brief Cycles between two TSC deadlines.
+ *
+ */
+unsigned long long tsc_period;
+
+/**
+ * @brief APIC timer counts per milli second (divide by 16).
+ *
+ */
+unsigned int lapic_ticks_per_ms;
+
+/**
+ * @brief TRUE if the processor supports TSC-deadline mode.
+ *
+ */
+int tsc_deadline_supported;
+
+INIT int init_apic() {
+    unsigned int regs[4];
+    lapic_eoi = NULL;
+    timer_mode = TIMER_PIT;
+
+    /* the APIC is only usable with MSRs and firmware tables describing it */
+    cpuid(1, regs);
+    if ((regs[3] & CPUID_EDX_APIC) == 0 || (regs[3] & CPUID_EDX_MSR) == 0) {
+        return FALSE;
+    }
+    if (init_acpi() == FALSE) {
+        return FALSE;
+    }
+    tsc_deadline_supported = (regs[2] & CPUID_ECX_TSC_DEADLINE) != 0;
+
+    /* mask the 8259, it stays remapped so stray interrupts hit vectors 32-47 */
+    outportb(0x21, 0xff);
+    outportb(0xa1, 0xff);
+
+    enable_lapic();
+
+    /* mask every I/O APIC input before routing the ones we handle */
+    unsigned int entries = ((ioapic_read(IOAPIC_VERSION) >> 16) & 0xff) + 1;
+    for (unsigned int i = 0; i < entries; i++) {
+        ioapic_write(IOAPIC_REDIRECTION + 2 * i, IOAPIC_MASKED);
+        ioapic_write(IOAPIC_REDIRECTION + 2 * i + 1, 0);
+    }
+    ioapic_route(IRQ_KEYBOARD, KEYBOARD_VECTOR, lapic_id(), FALSE);
+    lapic_eoi = (volatile unsigned int*)(lapic_address + LAPIC_EOI);
+
+    /* tick from the APIC timer, or keep the PIT through the I/O APIC */
+    if (init_lapic_timer() == FALSE) {
+        ioapic_route(IRQ_TIMER, TIMER_VECTOR, lapic_id(), FALSE);
+    }
+    return TRUE;
+}
+
+void enable_lapic() {
+    wrmsr(IA32_APIC_BASE, rdmsr(IA32_APIC_BASE) | APIC_BASE_ENABLE);
+    lapic_write(LAPIC_TPR, 0);
+    lapic_write(LAPIC_LVT_ERROR, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | SPURIOUS_VECTOR);
+}
+
+int init_lapic_timer() {
+    if (tsc_khz == 0) {
+        return FALSE;
+    }
+    if (tsc_deadline_supported) {
+        tsc_period = div_u64((unsigned long long)tsc_khz * tick_us, 1000);
+        lapic_write(LAPIC_LVT_TIMER, TIMER_VECTOR | LAPIC_TIMER_TSC_DEADLINE);
+        asm volatile ("mfence" : : : "memory");
+        this_cpu()->next_deadline = rdtsc() + tsc_period;
+        wrmsr(IA32_TSC_DEADLINE, this_cpu()->next_deadline);
+        timer_mode = TIMER_TSC_DEADLINE;
+    } else {
+        if (lapic_ticks_per_ms == 0) {
+            lapic_ticks_per_ms = calibrate_lapic_timer();
+        }
+        lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_DIVIDE_16);
+        lapic_write(LAPIC_LVT_TIMER, TIMER_VECTOR | LAPIC_TIMER_PERIODIC);
+        lapic_write(LAPIC_TIMER_INITIAL, div_u64((unsigned long long)lapic_ticks_per_ms * tick_us, 1000));
+        timer_mode = TIMER_LAPIC;
+    }
+
+    /* stop PIT channel 0: mode 0 waits for a count that never comes */
+    outportb(PIT_COMMAND, 0x30);
+    return TRUE;
+}
+
+unsigned int calibrate_lapic_timer() {
+    unsigned long long end;
+    lapic_write(LAPIC_TIMER_DIVIDE, LAPIC_DIVIDE_16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_TIMER_INITIAL, 0xffffffff);
+    end = rdtsc() + (unsigned long long)tsc_khz * LAPIC_CALIBRATE_MS;
+    while (rdtsc() < end);
+    unsigned int elapsed = 0xffffffff - lapic_read(LAPIC_TIMER_CURRENT);
+    lapic_write(LAPIC_TIMER_INITIAL, 0);
+    return elapsed / LAPIC_CALIBRATE_MS;
+}
+
+HOT void lapic_rearm() {
+    cpu_t* cpu = this_cpu();
+    unsigned long long now = rdtsc();
+    cpu->next_deadline += tsc_period;
+    if (cpu->next_deadline <= now) {
+        cpu->next_deadline = now + tsc_period;
+    }
+    wrmsr(IA32_TSC_DEADLINE, cpu->next_deadline);
+}
+
+unsigned int lapic_read(unsigned int reg) {
+    return *(volatile unsigned int*)(lapic_address + reg);
+}
+
+void lapic_write(unsigned int reg, unsigned int value) {
+    *(volatile unsigned int*)(lapic_address + reg) = value;
+}
+
+unsigned int lapic_id() {
+    return lapic_read(LAPIC_ID) >> 24;
+}
+
+void send_ipi(unsigned int apic_id, unsigned int vector) {
+    send_icr(apic_id, vector);
+}
+
+void send_init(unsigned int apic_id) {
+    send_icr(apic_id, ICR_INIT);
+}
+
+void send_startup(unsigned int apic_id, unsigned int page) {
+    send_icr(apic_id, ICR_STARTUP | page);
+}
+
+void send_icr(unsigned int apic_id, unsigned int command) {
+    /* an interrupt between the two writes could send its own IPI */
+    unsigned int flags = irq_save();
+    lapic_write(LAPIC_ICR_HIGH, apic_id << 24);
+    lapic_write(LAPIC_ICR_LOW, command);
+    while (lapic_read(LAPIC_ICR_LOW) & ICR_PENDING) {
+        asm volatile ("pause");
+    }
+    irq_restore(flags);
+}
+
+unsigned int ioapic_read(unsigned int reg) {
+    *(volatile unsigned int*)(ioapic_address + IOAPIC_REGSEL) = reg;
+    return *(volatile unsigned int*)(ioapic_address + IOAPIC_WINDOW);
+}
+
+void ioapic_write(unsigned int reg, unsigned int value) {
+    *(volatile unsigned int*)(ioapic_address + IOAPIC_REGSEL) = reg;
+    *(volatile unsigned int*)(ioapic_address + IOAPIC_WINDOW) = value;
+}
+
+void ioapic_route(unsigned int irq, unsigned int vector,
+                  unsigned int apic_id, int masked) {
+    unsigned int gsi = isa_irq_gsi[irq];
+    unsigned int low = vector;
+    if ((isa_irq_flags[irq] & ISO_POLARITY_MASK) == ISO_ACTIVE_LOW) {
+        low |= IOAPIC_ACTIVE_LOW;
+    }
+    if ((isa_irq_flags[irq] & ISO_TRIGGER_MASK) == ISO_LEVEL) {
+        low |= IOAPIC_LEVEL;
+    }
+    if (masked == TRUE) {
+        low |= IOAPIC_MASKED;
+    }
+    ioapic_write(IOAPIC_REDIRECTION + 2 * gsi + 1, apic_id << 24);
+    ioapic_write(IOAPIC_REDIRECTION + 2 * gsi, low);
+}
+
+void pic_eoi() {
+    asm volatile ("outb %%al, $0x20" : : "a" (0x20));
+}
+
+void apic_eoi() {
+    *lapic_eoi = 0;
+}
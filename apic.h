@@ -0,0 +1,214 @@
+/**
+ * @file apic.h
+ * @author Robert McKay
+ * @brief Declares the local APIC, I/O APIC and APIC timer drivers.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef APIC_H
+#define APIC_H
+
+/* model specific registers */
+#define IA32_APIC_BASE 0x1b
+#define IA32_TSC_DEADLINE 0x6e0
+#define APIC_BASE_ENABLE 0x800
+
+/* local APIC register offsets */
+#define LAPIC_ID 0x20
+#define LAPIC_TPR 0x80
+#define LAPIC_EOI 0xb0
+#define LAPIC_SVR 0xf0
+#define LAPIC_ICR_LOW 0x300
+#define LAPIC_ICR_HIGH 0x310
+#define LAPIC_LVT_TIMER 0x320
+#define LAPIC_LVT_ERROR 0x370
+#define LAPIC_TIMER_INITIAL 0x380
+#define LAPIC_TIMER_CURRENT 0x390
+#define LAPIC_TIMER_DIVIDE 0x3e0
+
+/* local APIC register values */
+#define LAPIC_SVR_ENABLE 0x100
+#define LAPIC_LVT_MASKED 0x10000
+#define LAPIC_TIMER_PERIODIC 0x20000
+#define LAPIC_TIMER_TSC_DEADLINE 0x40000
+#define LAPIC_DIVIDE_16 0x3
+
+/* interrupt command register values */
+#define ICR_INIT 0x4500
+#define ICR_STARTUP 0x4600
+#define ICR_PENDING 0x1000
+
+/* I/O APIC registers */
+#define IOAPIC_REGSEL 0x0
+#define IOAPIC_WINDOW 0x10
+#define IOAPIC_VERSION 0x1
+#define IOAPIC_REDIRECTION 0x10
+#define IOAPIC_ACTIVE_LOW 0x2000
+#define IOAPIC_LEVEL 0x8000
+#define IOAPIC_MASKED 0x10000
+
+/* interrupt vectors */
+#define TIMER_VECTOR 32
+#define KEYBOARD_VECTOR 33
+#define RESCHED_VECTOR 0xf0
+#define SPURIOUS_VECTOR 0xff
+
+/* legacy interrupt lines */
+#define IRQ_TIMER 0
+#define IRQ_KEYBOARD 1
+
+/* sources of the scheduling tick (values used by dispatch in boot2.S) */
+#define TIMER_PIT 0
+#define TIMER_LAPIC 1
+#define TIMER_TSC_DEADLINE 2
+
+/* length of the APIC timer calibration in milli seconds */
+#define LAPIC_CALIBRATE_MS 10
+
+/**
+ * @brief Address of the local APIC EOI register, 0 while the 8259 is in use.
+ * The EOI macro in boot2.S selects the controller with it.
+ *
+ */
+extern volatile unsigned int* lapic_eoi;
+
+/**
+ * @brief Source of the scheduling tick (TIMER_PIT, TIMER_LAPIC or
+ * TIMER_TSC_DEADLINE).
+ *
+ */
+extern unsigned int timer_mode;
+
+/**
+ * @brief Switches interrupt delivery from the 8259 to the local and I/O APIC
+ * and moves the scheduling tick to the APIC timer. Leaves the 8259 and PIT
+ * running if the processor or the firmware tables do not support it.
+ *
+ * @return int TRUE if the APIC is in use, FALSE if the 8259 is still in use.
+ */
+int init_apic();
+
+/**
+ * @brief Enables the local APIC of the calling processor.
+ *
+ */
+void enable_lapic();
+
+/**
+ * @brief Starts the scheduling tick on the local APIC timer of the calling
+ * processor, using TSC-deadline mode when it is supported.
+ *
+ * @return int TRUE if the APIC timer was started, FALSE otherwise.
+ */
+int init_lapic_timer();
+
+/**
+ * @brief Measures the APIC timer rate against the TSC.
+ *
+ * @return unsigned int APIC timer counts per milli second (divide by 16).
+ */
+unsigned int calibrate_lapic_timer();
+
+/**
+ * @brief Programs the calling processor's next TSC deadline.
+ * Called from dispatch each tick.
+ *
+ */
+void lapic_rearm();
+
+/**
+ * @brief Reads a local APIC register.
+ *
+ * @param reg Offset of the register.
+ * @return unsigned int The register value.
+ */
+unsigned int lapic_read(unsigned int reg);
+
+/**
+ * @brief Writes a local APIC register.
+ *
+ * @param reg Offset of the register.
+ * @param value The value to write.
+ */
+void lapic_write(unsigned int reg, unsigned int value);
+
+/**
+ * @brief Returns the local APIC id of the calling processor.
+ *
+ * @return unsigned int The APIC id.
+ */
+unsigned int lapic_id();
+
+/**
+ * @brief Sends a fixed interrupt to another processor.
+ *
+ * @param apic_id Local APIC id of the destination.
+ * @param vector The vector to deliver.
+ */
+void send_ipi(unsigned int apic_id, unsigned int vector);
+
+/**
+ * @brief Sends an INIT IPI to another processor.
+ *
+ * @param apic_id Local APIC id of the destination.
+ */
+void send_init(unsigned int apic_id);
+
+/**
+ * @brief Sends a startup IPI to another processor.
+ *
+ * @param apic_id Local APIC id of the destination.
+ * @param page Physical page number of the real mode start up code.
+ */
+void send_startup(unsigned int apic_id, unsigned int page);
+
+/**
+ * @brief Writes the interrupt command register and waits for delivery.
+ *
+ * @param apic_id Local APIC id of the destination.
+ * @param command Low word of the command.
+ */
+void send_icr(unsigned int apic_id, unsigned int command);
+
+/**
+ * @brief Reads an I/O APIC register.
+ *
+ * @param reg Index of the register.
+ * @return unsigned int The register value.
+ */
+unsigned int ioapic_read(unsigned int reg);
+
+/**
+ * @brief Writes an I/O APIC register.
+ *
+ * @param reg Index of the register.
+ * @param value The value to write.
+ */
+void ioapic_write(unsigned int reg, unsigned int value);
+
+/**
+ * @brief Routes an ISA interrupt through the I/O APIC.
+ *
+ * @param irq The ISA interrupt line.
+ * @param vector The IDT vector to deliver.
+ * @param apic_id Local APIC id of the destination processor.
+ * @param masked TRUE to leave the line masked.
+ */
+void ioapic_route(unsigned int irq, unsigned int vector,
+                  unsigned int apic_id, int masked);
+
+/**
+ * @brief Signals end of interrupt to the 8259.
+ *
+ */
+void pic_eoi();
+
+/**
+ * @brief Signals end of interrupt to the local APIC.
+ *
+ */
+void apic_eoi();
+
+#endif
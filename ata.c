@@ -0,0 +1,435 @@
+/**
+ * @file ata.c
+ * @author Robert McKay
+ * @brief Implements the ATA disk driver for the primary IDE channel.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "ata.h"
+#include "apic.h"
+#include "boot2.h"
+#include "buffer.h"
+#include "clock.h"
+#include "cpu.h"
+#include "defer.h"
+#include "pci.h"
+#include "smp.h"
+
+unsigned int ata_sectors;
+unsigned int ata_commands;
+unsigned int ata_merged;
+
+/**
+ * @brief Protects the request queue and the command in progress.
+ *
+ */
+spinlock_t ata_lock;
+
+/**
+ * @brief Requests waiting for the drive, sorted by sector.
+ *
+ */
+ata_request_t* ata_queue;
+
+/**
+ * @brief Sector after the last command, where the next one starts looking
+ * (the queue is served in one direction, like an elevator).
+ *
+ */
+unsigned int ata_position;
+
+/**
+ * @brief Processes waiting for their requests.
+ *
+ */
+queue_t ata_waiters;
+
+/**
+ * @brief Requests of the command in progress, NULL if the drive is idle.
+ *
+ */
+ata_request_t* ata_active;
+unsigned int ata_active_write;
+unsigned int ata_active_dma;
+
+/**
+ * @brief Set by the top half when the command in progress is over.
+ *
+ */
+volatile unsigned int ata_finished;
+volatile unsigned int ata_failed;
+
+/**
+ * @brief Position of the next sector of a PIO command, and the number of
+ * sectors still to move.
+ *
+ */
+ata_request_t* pio_request;
+unsigned int pio_offset;
+unsigned int pio_left;
+
+/**
+ * @brief Bus master registers of the primary channel, 0 if there are none.
+ *
+ */
+unsigned int bm_base;
+
+/**
+ * @brief Transfer mode of the next command.
+ *
+ */
+unsigned int ata_mode;
+
+/**
+ * @brief Descriptor table of the DMA command in progress. The table must
+ * not cross a 64 KB boundary, its alignment keeps it inside one.
+ *
+ */
+ata_prd_t ata_prdt[ATA_PRD_MAX] __attribute__ ((aligned (sizeof(ata_prd_t) * ATA_PRD_MAX)));
+
+/**
+ * @brief Waits for the drive to drop BSY.
+ *
+ * @return unsigned char The last status read, 0xff if it stayed busy.
+ */
+static unsigned char ata_wait_ready() {
+    unsigned long long end = rdtsc() + div_u64((unsigned long long)tsc_khz * ATA_IDENTIFY_TIMEOUT_US, 1000);
+    unsigned char status;
+    do {
+        status = inportb(ATA_IO + ATA_STATUS);
+        if ((status & ATA_STATUS_BSY) == 0) {
+            return status;
+        }
+    } while (rdtsc() < end);
+    return 0xff;
+}
+
+/**
+ * @brief Counts the descriptors a buffer needs.
+ *
+ * @param buffer Start of the buffer.
+ * @param bytes Length of the buffer.
+ * @return unsigned int Number of 64 KB regions the buffer touches.
+ */
+static unsigned int prd_count(unsigned char* buffer, unsigned int bytes) {
+    unsigned int start = (unsigned int)buffer;
+    return (start + bytes - 1) / ATA_DMA_BOUNDARY - start / ATA_DMA_BOUNDARY + 1;
+}
+
+/**
+ * @brief Fills the descriptor table from the buffers of a command.
+ *
+ * @param batch Requests of the command.
+ */
+static void build_prdt(ata_request_t* batch) {
+    unsigned int index = 0;
+    for (ata_request_t* request = batch; request != NULL; request = request->next) {
+        unsigned int address = (unsigned int)request->buffer;
+        unsigned int left = request->count * ATA_SECTOR_SIZE;
+        while (left > 0) {
+            unsigned int bytes = ATA_DMA_BOUNDARY - address % ATA_DMA_BOUNDARY;
+            if (bytes > left) {
+                bytes = left;
+            }
+
+            /* a count of 0 means 64 KB */
+            ata_prdt[index].address = address;
+            ata_prdt[index].count = bytes & 0xffff;
+            address += bytes;
+            left -= bytes;
+            index++;
+        }
+    }
+    ata_prdt[index - 1].count |= ATA_PRD_END;
+}
+
+/**
+ * @brief Moves the next sector of a PIO command.
+ *
+ */
+static void pio_sector() {
+    unsigned char* buffer = pio_request->buffer + pio_offset;
+    if (ata_active_write) {
+        outportsw(ATA_IO + ATA_DATA, buffer, ATA_SECTOR_SIZE / 2);
+    } else {
+        inportsw(ATA_IO + ATA_DATA, buffer, ATA_SECTOR_SIZE / 2);
+    }
+    pio_left--;
+    pio_offset += ATA_SECTOR_SIZE;
+    if (pio_offset == pio_request->count * ATA_SECTOR_SIZE) {
+        pio_request = pio_request->next;
+        pio_offset = 0;
+    }
+}
+
+/**
+ * @brief Sends the next command if the drive is idle: the first request at
+ * or after ata_position (wrapping to the lowest sector), merged with the
+ * requests that continue it in the same direction. Called with ata_lock
+ * held.
+ *
+ */
+static void ata_start() {
+    ata_request_t** link = &ata_queue;
+    if (ata_active != NULL || ata_queue == NULL) {
+        return;
+    }
+    while (*link != NULL && (*link)->lba < ata_position) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL) {
+        link = &ata_queue;
+    }
+
+    ata_request_t* first = *link;
+    ata_request_t* last = first;
+    unsigned int sectors = first->count;
+    unsigned int prds = prd_count(first->buffer, first->count * ATA_SECTOR_SIZE);
+    *link = first->next;
+    while (*link != NULL) {
+        ata_request_t* next = *link;
+        unsigned int next_prds = prd_count(next->buffer, next->count * ATA_SECTOR_SIZE);
+        if (next->lba != first->lba + sectors || next->write != first->write
+            || sectors + next->count > ATA_MAX_SECTORS
+            || prds + next_prds > ATA_PRD_MAX) {
+            break;
+        }
+        *link = next->next;
+        last->next = next;
+        last = next;
+        sectors += next->count;
+        prds += next_prds;
+        ata_merged++;
+    }
+    last->next = NULL;
+
+    ata_active = first;
+    ata_active_write = first->write;
+    ata_active_dma = ata_mode == ATA_MODE_DMA;
+    ata_finished = FALSE;
+    ata_failed = FALSE;
+    ata_position = first->lba + sectors;
+    ata_commands++;
+
+    outportb(ATA_IO + ATA_DRIVE, ATA_DRIVE_MASTER | ((first->lba >> 24) & 0x0f));
+    outportb(ATA_IO + ATA_SECTOR_COUNT, sectors & 0xff);
+    outportb(ATA_IO + ATA_LBA_LOW, first->lba & 0xff);
+    outportb(ATA_IO + ATA_LBA_MID, (first->lba >> 8) & 0xff);
+    outportb(ATA_IO + ATA_LBA_HIGH, (first->lba >> 16) & 0xff);
+
+    if (ata_active_dma) {
+        unsigned char direction = ata_active_write ? 0 : BM_READ;
+        build_prdt(first);
+        outportl(bm_base + BM_PRDT, (unsigned int)ata_prdt);
+        outportb(bm_base + BM_COMMAND, direction);
+        outportb(bm_base + BM_STATUS, BM_INTERRUPT | BM_ERROR);
+        outportb(ATA_IO + ATA_COMMAND,
+                 ata_active_write ? ATA_CMD_WRITE_DMA : ATA_CMD_READ_DMA);
+        outportb(bm_base + BM_COMMAND, direction | BM_START);
+        return;
+    }
+
+    pio_request = first;
+    pio_offset = 0;
+    pio_left = sectors;
+    if (ata_active_write) {
+        /* the first sector is written without an interrupt */
+        outportb(ATA_IO + ATA_COMMAND, ATA_CMD_WRITE_SECTORS);
+        while ((ata_wait_ready() & ATA_STATUS_DRQ) == 0);
+        pio_sector();
+    } else {
+        outportb(ATA_IO + ATA_COMMAND, ATA_CMD_READ_SECTORS);
+    }
+}
+
+INIT int init_ata() {
+    unsigned short identify[ATA_ID_WORDS];
+    pci_address_t controller;
+
+    init_lock(&ata_lock, "ata");
+    init_queue(&ata_waiters, "ata waiters");
+    register_lock_stat(&ata_lock.stat);
+    ata_queue = NULL;
+    ata_active = NULL;
+    ata_position = 0;
+    ata_sectors = 0;
+    ata_mode = ATA_MODE_PIO;
+    bm_base = 0;
+
+    /* identify the master drive with the interrupt masked */
+    outportb(ATA_CONTROL, ATA_CONTROL_NIEN);
+    outportb(ATA_IO + ATA_DRIVE, ATA_DRIVE_MASTER);
+    outportb(ATA_IO + ATA_SECTOR_COUNT, 0);
+    outportb(ATA_IO + ATA_LBA_LOW, 0);
+    outportb(ATA_IO + ATA_LBA_MID, 0);
+    outportb(ATA_IO + ATA_LBA_HIGH, 0);
+    outportb(ATA_IO + ATA_COMMAND, ATA_CMD_IDENTIFY);
+    unsigned char status = inportb(ATA_IO + ATA_STATUS);
+    if (status == 0 || status == 0xff) {
+        return FALSE;
+    }
+    status = ata_wait_ready();
+    if (status == 0xff || (status & ATA_STATUS_ERR)
+        || inportb(ATA_IO + ATA_LBA_MID) != 0 || inportb(ATA_IO + ATA_LBA_HIGH) != 0) {
+        /* no drive, or an ATAPI drive */
+        return FALSE;
+    }
+    while ((inportb(ATA_IO + ATA_STATUS) & (ATA_STATUS_DRQ | ATA_STATUS_ERR)) == 0);
+    inportsw(ATA_IO + ATA_DATA, identify, ATA_ID_WORDS);
+    ata_sectors = identify[ATA_ID_SECTORS] | ((unsigned int)identify[ATA_ID_SECTORS + 1] << 16);
+
+    /* bus master registers of the primary channel are the first eight */
+    if (pci_find_class(PCI_CLASS_STORAGE, PCI_SUBCLASS_IDE, &controller) == TRUE) {
+        unsigned int bar = pci_read(controller, PCI_BAR4);
+        if (bar & PCI_BAR_IO) {
+            bm_base = bar & PCI_BAR_IO_MASK;
+            pci_write(controller, PCI_COMMAND, pci_read(controller, PCI_COMMAND)
+                      | PCI_COMMAND_IO | PCI_COMMAND_BUS_MASTER);
+        }
+    }
+
+    if (lapic_eoi != NULL) {
+        ioapic_route(IRQ_ATA, ATA_VECTOR, lapic_id(), FALSE);
+    } else {
+        /* unmask the cascade on the master and IRQ 14 on the slave */
+        outportb(0x21, inportb(0x21) & ~(1 << 2));
+        outportb(0xa1, inportb(0xa1) & ~(1 << (IRQ_ATA - 8)));
+    }
+    register_bottom_half(BH_ATA, ata_bottom_half);
+    outportb(ATA_CONTROL, 0);
+    return TRUE;
+}
+
+int ata_set_mode(unsigned int mode) {
+    if (mode == ATA_MODE_DMA && bm_base == 0) {
+        return FALSE;
+    }
+    ata_mode = mode;
+    return TRUE;
+}
+
+int ata_submit(ata_request_t* request) {
+    if (request->count == 0 || request->count > ATA_MAX_SECTORS
+        || request->lba >= ata_sectors || request->count > ata_sectors - request->lba) {
+        return FALSE;
+    }
+    request->done = FALSE;
+    request->error = FALSE;
+    request->waiter = NULL;
+
+    /* after requests for the same sector, so they are served in order */
+    unsigned int flags = acquire_irqsave(&ata_lock);
+    ata_request_t** link = &ata_queue;
+    while (*link != NULL && (*link)->lba <= request->lba) {
+        link = &(*link)->next;
+    }
+    request->next = *link;
+    *link = request;
+    ata_start();
+    release_irqrestore(&ata_lock, flags);
+    return TRUE;
+}
+
+int ata_wait(ata_request_t* request) {
+    unsigned int flags = acquire_irqsave(&ata_lock);
+    while (request->done == FALSE) {
+        request->waiter = current_process();
+        block_process((unsigned int)&ata_waiters, (unsigned int)&ata_lock);
+        acquire(&ata_lock);
+    }
+    release_irqrestore(&ata_lock, flags);
+    return request->error == FALSE;
+}
+
+int ata_transfer(unsigned int lba, unsigned int count, void* buffer, unsigned int write) {
+    ata_request_t request;
+    request.lba = lba;
+    request.count = count;
+    request.buffer = buffer;
+    request.write = write;
+    request.complete = NULL;
+    request.data = NULL;
+    if (ata_submit(&request) == FALSE) {
+        return FALSE;
+    }
+    return ata_wait(&request);
+}
+
+void ata_interrupt() {
+    unsigned char status;
+
+    if (ata_active == NULL || ata_finished == TRUE) {
+        /* not ours, reading the status clears the drive's request */
+        inportb(ATA_IO + ATA_STATUS);
+    } else if (ata_active_dma) {
+        unsigned char bm = inportb(bm_base + BM_STATUS);
+        if (bm & BM_INTERRUPT) {
+            outportb(bm_base + BM_COMMAND, 0);
+            outportb(bm_base + BM_STATUS, BM_INTERRUPT | BM_ERROR);
+            status = inportb(ATA_IO + ATA_STATUS);
+            ata_failed = (bm & BM_ERROR) || (status & (ATA_STATUS_ERR | ATA_STATUS_DF));
+            ata_finished = TRUE;
+        }
+    } else {
+        status = inportb(ATA_IO + ATA_STATUS);
+        if (status & (ATA_STATUS_ERR | ATA_STATUS_DF)) {
+            ata_failed = TRUE;
+            ata_finished = TRUE;
+        } else if (ata_active_write) {
+            /* the interrupt reports the sector just written */
+            if (pio_left == 0) {
+                ata_finished = TRUE;
+            } else {
+                pio_sector();
+            }
+        } else if (status & ATA_STATUS_DRQ) {
+            pio_sector();
+            ata_finished = pio_left == 0;
+        }
+    }
+    if (ata_finished == TRUE) {
+        raise_bottom_half(BH_ATA);
+    }
+
+    /* the slave 8259 needs its own EOI, the master gets one on exit */
+    if (lapic_eoi == NULL) {
+        outportb(0xa0, 0x20);
+    }
+}
+
+void ata_bottom_half() {
+    ata_request_t* completed = NULL;
+    ata_request_t* request;
+    ata_request_t* next;
+
+    unsigned int flags = acquire_irqsave(&ata_lock);
+    if (ata_active == NULL || ata_finished == FALSE) {
+        release_irqrestore(&ata_lock, flags);
+        return;
+    }
+    request = ata_active;
+    ata_active = NULL;
+    while (request != NULL) {
+        /* a waiter may reuse its request once done is set */
+        next = request->next;
+        request->error = ata_failed;
+        if (request->complete != NULL) {
+            request->next = completed;
+            completed = request;
+        }
+        request->done = TRUE;
+        if (request->waiter != NULL && remove_process(&ata_waiters, request->waiter) == TRUE) {
+            make_ready(request->waiter);
+        }
+        request = next;
+    }
+    ata_start();
+    release_irqrestore(&ata_lock, flags);
+
+    for (request = completed; request != NULL; request = next) {
+        next = request->next;
+        request->complete(request);
+    }
+}
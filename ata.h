@@ -0,0 +1,203 @@
+/**
+ * @file ata.h
+ * @author Robert McKay
+ * @brief Declares the ATA disk driver for the primary IDE channel, with
+ * interrupt driven PIO and bus master DMA and a sorted request queue.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef ATA_H
+#define ATA_H
+
+#include "scheduler.h"
+
+/* primary channel ports */
+#define ATA_IO 0x1f0
+#define ATA_CONTROL 0x3f6
+
+/* task file registers, offsets from ATA_IO */
+#define ATA_DATA 0
+#define ATA_ERROR 1
+#define ATA_SECTOR_COUNT 2
+#define ATA_LBA_LOW 3
+#define ATA_LBA_MID 4
+#define ATA_LBA_HIGH 5
+#define ATA_DRIVE 6
+#define ATA_STATUS 7
+#define ATA_COMMAND 7
+
+/* bits of the status register */
+#define ATA_STATUS_ERR 0x01
+#define ATA_STATUS_DRQ 0x08
+#define ATA_STATUS_DF 0x20
+#define ATA_STATUS_BSY 0x80
+
+/* drive register: master, LBA addressing */
+#define ATA_DRIVE_MASTER 0xe0
+
+/* control register: interrupts disabled */
+#define ATA_CONTROL_NIEN 0x02
+
+/* commands */
+#define ATA_CMD_READ_SECTORS 0x20
+#define ATA_CMD_WRITE_SECTORS 0x30
+#define ATA_CMD_READ_DMA 0xc8
+#define ATA_CMD_WRITE_DMA 0xca
+#define ATA_CMD_FLUSH_CACHE 0xe7
+#define ATA_CMD_IDENTIFY 0xec
+
+/* words of the identify data */
+#define ATA_ID_WORDS 256
+#define ATA_ID_SECTORS 60
+
+/* sector size and the most sectors one command moves (LBA28) */
+#define ATA_SECTOR_SIZE 512
+#define ATA_MAX_SECTORS 256
+
+/* bus master registers, offsets from BAR4 */
+#define BM_COMMAND 0
+#define BM_STATUS 2
+#define BM_PRDT 4
+
+/* bits of the bus master registers */
+#define BM_START 0x01
+#define BM_READ 0x08
+#define BM_ACTIVE 0x01
+#define BM_ERROR 0x02
+#define BM_INTERRUPT 0x04
+
+/* physical region descriptors, each within one 64 KB region */
+#define ATA_PRD_MAX 32
+#define ATA_PRD_END 0x80000000
+#define ATA_DMA_BOUNDARY 0x10000
+
+/* PCI class of an IDE controller */
+#define PCI_CLASS_STORAGE 0x01
+#define PCI_SUBCLASS_IDE 0x01
+
+/* legacy interrupt line and vector of the primary channel (the 8259
+   delivers IRQ 14 at 40 + 6) */
+#define IRQ_ATA 14
+#define ATA_VECTOR 46
+
+/* transfer modes */
+#define ATA_MODE_PIO 0
+#define ATA_MODE_DMA 1
+
+/* polling limit while identifying the drive */
+#define ATA_IDENTIFY_TIMEOUT_US 100000
+
+/**
+ * @brief A disk request. Requests waiting for the drive are kept sorted by
+ * sector, and neighbouring requests in the same direction are sent to the
+ * drive as one command.
+ *
+ */
+struct ata_request_s {
+    unsigned int lba;
+    unsigned int count;
+    unsigned char* buffer;
+    unsigned int write;
+    volatile unsigned int done;
+    int error;
+    pcb_t* waiter;
+    void (*complete)(struct ata_request_s*);
+    void* data;
+    struct ata_request_s* next;
+};
+
+/**
+ * @brief Type definition for a disk request.
+ *
+ */
+typedef struct ata_request_s ata_request_t;
+
+/**
+ * @brief Physical region descriptor read by the bus master.
+ *
+ */
+struct ata_prd_s {
+    unsigned int address;
+    unsigned int count;
+} __attribute__ ((packed));
+
+/**
+ * @brief Type definition for a physical region descriptor.
+ *
+ */
+typedef struct ata_prd_s ata_prd_t;
+
+/**
+ * @brief Sectors on the drive, 0 if there is none.
+ *
+ */
+extern unsigned int ata_sectors;
+
+/**
+ * @brief Commands sent to the drive and requests merged into them.
+ *
+ */
+extern unsigned int ata_commands;
+extern unsigned int ata_merged;
+
+/**
+ * @brief Identifies the master drive of the primary channel, finds the
+ * bus master registers of the IDE controller and routes IRQ 14.
+ *
+ * @return int TRUE if a drive was found.
+ */
+int init_ata();
+
+/**
+ * @brief Selects PIO or DMA transfers. Takes effect with the next command.
+ *
+ * @param mode ATA_MODE_PIO or ATA_MODE_DMA.
+ * @return int TRUE, or FALSE if DMA was asked for and the controller has
+ * no bus master registers.
+ */
+int ata_set_mode(unsigned int mode);
+
+/**
+ * @brief Queues a request without waiting for it. Its complete function
+ * runs in a bottom half once the transfer is over.
+ *
+ * @param request The request, count at most ATA_MAX_SECTORS.
+ * @return int TRUE if queued, FALSE if it is out of range.
+ */
+int ata_submit(ata_request_t* request);
+
+/**
+ * @brief Waits for a submitted request to finish.
+ *
+ * @param request The request.
+ * @return int TRUE if the transfer succeeded.
+ */
+int ata_wait(ata_request_t* request);
+
+/**
+ * @brief Reads or writes sectors and waits for the transfer.
+ *
+ * @param lba First sector.
+ * @param count Number of sectors, at most ATA_MAX_SECTORS.
+ * @param buffer The data.
+ * @param write TRUE to write, FALSE to read.
+ * @return int TRUE if the transfer succeeded.
+ */
+int ata_transfer(unsigned int lba, unsigned int count, void* buffer, unsigned int write);
+
+/**
+ * @brief Top half of the disk interrupt: acknowledges the drive and, in
+ * PIO mode, moves the next sector. Called by ata_enter in boot2.S.
+ *
+ */
+void ata_interrupt();
+
+/**
+ * @brief Completes the finished command's requests and starts the next.
+ *
+ */
+void ata_bottom_half();
+
+#endif
@@ -0,0 +1,346 @@
+/**
+ * @file bcache.c
+ * @author Robert McKay
+ * @brief Implements the LRU block cache in front of the disk driver.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "bcache.h"
+#include "boot2.h"
+#include "buffer.h"
+#include "pmm.h"
+#include "cpu.h"
+
+unsigned int bcache_hits;
+unsigned int bcache_misses;
+unsigned int bcache_readaheads;
+unsigned int bcache_writebacks;
+
+/**
+ * @brief The buffers.
+ *
+ */
+buf_t bufs[BCACHE_BUFFERS];
+
+/**
+ * @brief Hash chains of the buffers by block number.
+ *
+ */
+buf_t* bcache_hash[BCACHE_HASH];
+
+/**
+ * @brief Most and least recently used buffers.
+ *
+ */
+buf_t* lru_head;
+buf_t* lru_tail;
+
+/**
+ * @brief Blocks on the disk.
+ *
+ */
+unsigned int bcache_blocks;
+
+/**
+ * @brief Block read last, to notice sequential reads.
+ *
+ */
+unsigned int last_block;
+
+/**
+ * @brief Protects the buffers. Taken with interrupts disabled, the disk
+ * bottom half completes buffers.
+ *
+ */
+spinlock_t bcache_lock;
+
+/**
+ * @brief Processes waiting for a buffer's I/O or for a free buffer.
+ *
+ */
+queue_t bcache_waiters;
+
+/**
+ * @brief Finds a block's buffer. Called with bcache_lock held.
+ *
+ * @param block The block.
+ * @return buf_t* The buffer, or NULL if the block is not cached.
+ */
+static buf_t* lookup(unsigned int block) {
+    buf_t* buf = bcache_hash[block % BCACHE_HASH];
+    while (buf != NULL && buf->block != block) {
+        buf = buf->hash_next;
+    }
+    return buf;
+}
+
+/**
+ * @brief Moves a buffer to the most recently used end of the list.
+ *
+ * @param buf The buffer.
+ */
+static void touch(buf_t* buf) {
+    if (lru_head == buf) {
+        return;
+    }
+    buf->lru_prev->lru_next = buf->lru_next;
+    if (buf->lru_next != NULL) {
+        buf->lru_next->lru_prev = buf->lru_prev;
+    } else {
+        lru_tail = buf->lru_prev;
+    }
+    buf->lru_prev = NULL;
+    buf->lru_next = lru_head;
+    lru_head->lru_prev = buf;
+    lru_head = buf;
+}
+
+/**
+ * @brief Gives a buffer to another block.
+ *
+ * @param buf The buffer.
+ * @param block The block, or BCACHE_NO_BLOCK.
+ */
+static void rehash(buf_t* buf, unsigned int block) {
+    if (buf->block != BCACHE_NO_BLOCK) {
+        buf_t** link = &bcache_hash[buf->block % BCACHE_HASH];
+        while (*link != buf) {
+            link = &(*link)->hash_next;
+        }
+        *link = buf->hash_next;
+    }
+    buf->block = block;
+    buf->flags = 0;
+    buf->hash_next = NULL;
+    if (block != BCACHE_NO_BLOCK) {
+        buf->hash_next = bcache_hash[block % BCACHE_HASH];
+        bcache_hash[block % BCACHE_HASH] = buf;
+    }
+}
+
+/**
+ * @brief Wakes every process waiting on the cache.
+ *
+ */
+static void wake_waiters() {
+    pcb_t* pcb;
+    while ((pcb = dequeue_process(&bcache_waiters)) != NULL) {
+        make_ready(pcb);
+    }
+}
+
+/**
+ * @brief Sleeps until the cache changes. Called with bcache_lock held,
+ * returns with it held.
+ *
+ */
+static void wait_cache() {
+    block_process((unsigned int)&bcache_waiters, (unsigned int)&bcache_lock);
+    acquire(&bcache_lock);
+}
+
+/**
+ * @brief Marks a buffer's I/O finished. Runs in the disk bottom half.
+ *
+ * @param request The buffer's request.
+ */
+static void bcache_complete(ata_request_t* request) {
+    buf_t* buf = request->data;
+    unsigned int flags = acquire_irqsave(&bcache_lock);
+    if (request->error) {
+        buf->flags |= BUF_ERROR;
+    } else if (request->write == FALSE) {
+        buf->flags |= BUF_VALID;
+    }
+    buf->flags &= ~BUF_BUSY;
+    wake_waiters();
+    release_irqrestore(&bcache_lock, flags);
+}
+
+/**
+ * @brief Starts reading or writing a buffer. A write clears the dirty flag
+ * first, so a change made while it is in flight is written again later.
+ *
+ * @param buf The buffer.
+ * @param write TRUE to write it.
+ */
+static void start_io(buf_t* buf, unsigned int write) {
+    buf->flags |= BUF_BUSY;
+    if (write) {
+        buf->flags &= ~BUF_DIRTY;
+        bcache_writebacks++;
+    }
+    buf->request.lba = buf->block * BCACHE_SECTORS;
+    buf->request.count = BCACHE_SECTORS;
+    buf->request.buffer = buf->data;
+    buf->request.write = write;
+    buf->request.complete = bcache_complete;
+    buf->request.data = buf;
+    if (ata_submit(&buf->request) == FALSE) {
+        buf->flags = (buf->flags & ~BUF_BUSY) | BUF_ERROR;
+    }
+}
+
+/**
+ * @brief Finds the least recently used buffer nobody holds or is moving.
+ * Dirty buffers passed over are written back if allowed.
+ *
+ * @param write_back TRUE to start writing back dirty buffers.
+ * @return buf_t* A clean buffer, or NULL if there is none now.
+ */
+static buf_t* find_victim(int write_back) {
+    for (buf_t* buf = lru_tail; buf != NULL; buf = buf->lru_prev) {
+        if (buf->refs != 0 || (buf->flags & BUF_BUSY)) {
+            continue;
+        }
+        if ((buf->flags & BUF_DIRTY) == 0) {
+            return buf;
+        }
+        if (write_back) {
+            start_io(buf, TRUE);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Starts reading the blocks after a sequential read into clean
+ * buffers, without waiting.
+ *
+ * @param block The block just read.
+ */
+static void read_ahead(unsigned int block) {
+    for (unsigned int next = block + 1; next <= block + BCACHE_READAHEAD && next < bcache_blocks; next++) {
+        if (lookup(next) != NULL) {
+            continue;
+        }
+        buf_t* buf = find_victim(FALSE);
+        if (buf == NULL) {
+            return;
+        }
+        rehash(buf, next);
+        touch(buf);
+        start_io(buf, FALSE);
+        bcache_readaheads++;
+    }
+}
+
+INIT int init_bcache() {
+    init_lock(&bcache_lock, "block cache");
+    init_queue(&bcache_waiters, "block cache waiters");
+    register_lock_stat(&bcache_lock.stat);
+    bcache_blocks = ata_sectors / BCACHE_SECTORS;
+    last_block = BCACHE_NO_BLOCK;
+    lru_head = NULL;
+    lru_tail = NULL;
+    for (int i = 0; i < BCACHE_HASH; i++) {
+        bcache_hash[i] = NULL;
+    }
+    for (int i = 0; i < BCACHE_BUFFERS; i++) {
+        buf_t* buf = &bufs[i];
+        buf->data = (unsigned char*)alloc_page();
+        if (buf->data == NULL) {
+            return FALSE;
+        }
+        buf->block = BCACHE_NO_BLOCK;
+        buf->flags = 0;
+        buf->refs = 0;
+        buf->hash_next = NULL;
+        buf->lru_prev = lru_tail;
+        buf->lru_next = NULL;
+        if (lru_tail != NULL) {
+            lru_tail->lru_next = buf;
+        } else {
+            lru_head = buf;
+        }
+        lru_tail = buf;
+    }
+    return bcache_blocks != 0;
+}
+
+buf_t* bread(unsigned int block) {
+    buf_t* buf;
+    if (block >= bcache_blocks) {
+        return NULL;
+    }
+
+    unsigned int flags = acquire_irqsave(&bcache_lock);
+    while ((buf = lookup(block)) == NULL) {
+        buf = find_victim(TRUE);
+        if (buf != NULL) {
+            rehash(buf, block);
+            break;
+        }
+        wait_cache();
+    }
+    buf->refs++;
+    if ((buf->flags & (BUF_VALID | BUF_BUSY)) == 0) {
+        start_io(buf, FALSE);
+        bcache_misses++;
+    } else {
+        bcache_hits++;
+    }
+    if (last_block != BCACHE_NO_BLOCK && block == last_block + 1) {
+        read_ahead(block);
+    }
+    last_block = block;
+
+    while (buf->flags & BUF_BUSY) {
+        wait_cache();
+    }
+    if (buf->flags & BUF_ERROR) {
+        /* forget the block so the next read tries again */
+        buf->refs--;
+        rehash(buf, BCACHE_NO_BLOCK);
+        release_irqrestore(&bcache_lock, flags);
+        return NULL;
+    }
+    touch(buf);
+    release_irqrestore(&bcache_lock, flags);
+    return buf;
+}
+
+void bwrite(buf_t* buf) {
+    unsigned int flags = acquire_irqsave(&bcache_lock);
+    buf->flags |= BUF_DIRTY;
+    release_irqrestore(&bcache_lock, flags);
+}
+
+void brelse(buf_t* buf) {
+    unsigned int flags = acquire_irqsave(&bcache_lock);
+    buf->refs--;
+    if (buf->refs == 0) {
+        wake_waiters();
+    }
+    release_irqrestore(&bcache_lock, flags);
+}
+
+void bsync() {
+    unsigned int flags = acquire_irqsave(&bcache_lock);
+
+    /* queue every write first so the driver can sort and merge them */
+    for (int i = 0; i < BCACHE_BUFFERS; i++) {
+        if ((bufs[i].flags & (BUF_DIRTY | BUF_BUSY)) == BUF_DIRTY) {
+            start_io(&bufs[i], TRUE);
+        }
+    }
+    for (int i = 0; i < BCACHE_BUFFERS; i++) {
+        while (bufs[i].flags & BUF_BUSY) {
+            wait_cache();
+        }
+    }
+    release_irqrestore(&bcache_lock, flags);
+}
+
+void bcache_drop() {
+    unsigned int flags = acquire_irqsave(&bcache_lock);
+    for (int i = 0; i < BCACHE_BUFFERS; i++) {
+        if (bufs[i].refs == 0 && (bufs[i].flags & (BUF_DIRTY | BUF_BUSY)) == 0) {
+            rehash(&bufs[i], BCACHE_NO_BLOCK);
+        }
+    }
+    last_block = BCACHE_NO_BLOCK;
+    release_irqrestore(&bcache_lock, flags);
+}
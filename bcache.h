@@ -0,0 +1,110 @@
+/**
+ * @file bcache.h
+ * @author Robert McKay
+ * @brief Declares the LRU block cache in front of the disk driver, with
+ * read-ahead and write-back.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef BCACHE_H
+#define BCACHE_H
+
+#include "ata.h"
+
+/* cache geometry, each buffer is one page */
+#define BCACHE_BLOCK_SIZE 4096
+#define BCACHE_SECTORS (BCACHE_BLOCK_SIZE / ATA_SECTOR_SIZE)
+#define BCACHE_BUFFERS 64
+#define BCACHE_HASH 32
+
+/* blocks read ahead once reads turn out to be sequential */
+#define BCACHE_READAHEAD 8
+
+/* block number of an unused buffer */
+#define BCACHE_NO_BLOCK 0xffffffff
+
+/* buffer flags */
+#define BUF_VALID 0x1
+#define BUF_DIRTY 0x2
+#define BUF_BUSY 0x4
+#define BUF_ERROR 0x8
+
+/**
+ * @brief Structure for a cached block. Buffers are on a list from most to
+ * least recently used and on a hash chain by block number.
+ *
+ */
+struct buf_s {
+    unsigned int block;
+    volatile unsigned int flags;
+    unsigned int refs;
+    unsigned char* data;
+    struct buf_s* lru_prev;
+    struct buf_s* lru_next;
+    struct buf_s* hash_next;
+    ata_request_t request;
+};
+
+/**
+ * @brief Type definition for a cached block.
+ *
+ */
+typedef struct buf_s buf_t;
+
+/**
+ * @brief Cache statistics.
+ *
+ */
+extern unsigned int bcache_hits;
+extern unsigned int bcache_misses;
+extern unsigned int bcache_readaheads;
+extern unsigned int bcache_writebacks;
+
+/**
+ * @brief Allocates the buffers. Call after init_ata.
+ *
+ * @return int TRUE if the cache is usable.
+ */
+int init_bcache();
+
+/**
+ * @brief Returns a block's buffer with its data read, waiting for the disk
+ * on a miss. Reading the block after the last one read starts reads of
+ * the next BCACHE_READAHEAD blocks.
+ *
+ * @param block The block number.
+ * @return buf_t* The buffer, held until brelse, or NULL on a disk error.
+ */
+buf_t* bread(unsigned int block);
+
+/**
+ * @brief Marks a held buffer modified. It is written when it is evicted or
+ * on bsync.
+ *
+ * @param buf The buffer.
+ */
+void bwrite(buf_t* buf);
+
+/**
+ * @brief Releases a buffer returned by bread.
+ *
+ * @param buf The buffer.
+ */
+void brelse(buf_t* buf);
+
+/**
+ * @brief Writes every modified buffer and waits for the writes.
+ *
+ */
+void bsync();
+
+/**
+ * @brief Forgets every clean buffer nobody holds, so the next reads go to
+ * the disk.
+ *
+ */
+void bcache_drop();
+
+#endif
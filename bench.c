@@ -0,0 +1,1035 @@
+/**
+ * @file bench.c
+ * @author Robert McKay
+ * @brief Implements the in kernel benchmark suite (built with make bench).
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "bench.h"
+#include "apic.h"
+#include "ata.h"
+#include "bcache.h"
+#include "boot2.h"
+#include "buffer.h"
+#include "channel.h"
+#include "clock.h"
+#include "cpu.h"
+#include "defer.h"
+#include "elf.h"
+#include "fat.h"
+#include "fdc.h"
+#include "fpu.h"
+#include "ipc.h"
+#include "io.h"
+#include "keyboard.h"
+#include "lock.h"
+#include "multiboot.h"
+#include "mutex.h"
+#include "paging.h"
+#include "pmm.h"
+#include "slab.h"
+#include "process.h"
+#include "scheduler.h"
+#include "smp.h"
+#include "syscall.h"
+
+/**
+ * @brief End of the kernel image boot1 loads, where the bss starts, and
+ * bounds of the hot code at its start, set by the linker.
+ *
+ */
+extern char __bss_start[];
+extern char __hot_start[];
+extern char __hot_end[];
+
+/**
+ * @brief A counter alone on its cache line, so workers do not share lines.
+ *
+ */
+typedef struct {
+    volatile unsigned int count;
+    unsigned char padding[CACHE_LINE - sizeof(unsigned int)];
+} bench_counter_t;
+
+bench_counter_t bench_counters[BENCH_WORKERS];
+
+/**
+ * @brief Set while the counter workers should count.
+ *
+ */
+volatile unsigned int bench_running;
+
+/**
+ * @brief Next counter handed to a starting worker.
+ *
+ */
+volatile unsigned int bench_next_counter;
+
+/**
+ * @brief Worst release delay of each bench_edf process in micro seconds.
+ *
+ */
+unsigned int bench_rt_worst[BENCH_RT_TASKS];
+
+/**
+ * @brief Mailbox between the bench_ipc client and server.
+ *
+ */
+mailbox_t bench_mailbox;
+
+/**
+ * @brief Channel and message size used by bench_channel.
+ *
+ */
+channel_t* bench_channel_ring;
+unsigned int bench_message_size;
+
+/* message buffers of the bench_channel producer and consumer */
+unsigned char bench_produced[BENCH_CHANNEL_MAX_MESSAGE];
+unsigned char bench_consumed[BENCH_CHANNEL_MAX_MESSAGE];
+
+/* locks measured by bench_locks */
+spinlock_t bench_spinlock;
+ticket_lock_t bench_ticket_lock;
+mutex_t bench_mutex;
+
+/**
+ * @brief Counter the bench_mutex workers increment under bench_mutex.
+ *
+ */
+unsigned int bench_mutex_count;
+
+void p_bench() {
+    char running[] = "running benchmarks, " PROFILE " profile...";
+    char done[] = "benchmarks complete";
+    println(running);
+    new_line();
+    bench_boot();
+    bench_interrupt_overhead();
+    bench_irq_off();
+    bench_locks();
+    bench_mutex_contention();
+    bench_pages();
+    bench_tlb();
+    bench_slab();
+    bench_counter_throughput();
+    bench_spawn();
+    bench_switch();
+    bench_ipc();
+    bench_channel();
+    bench_disk();
+    bench_fat();
+    bench_elf();
+    bench_quanta();
+    bench_edf();
+    bench_syscall();
+    bench_fork();
+    bench_fpu();
+    bench_stacks();
+    bench_lock_stats();
+    println(done);
+    new_line();
+    while (TRUE);
+}
+
+void bench_report(char* name, unsigned int value, char* unit) {
+    char separator[] = ": ";
+    char space_char[] = " ";
+    char value_buf[11];
+    convert_num(value, value_buf);
+    println(name);
+    println(separator);
+    println(value_buf);
+    println(space_char);
+    println(unit);
+    new_line();
+}
+
+void bench_interrupt_overhead() {
+    unsigned long long start;
+    unsigned int pic_cycles;
+    unsigned int apic_cycles;
+    unsigned int rearm_cycles;
+
+    asm volatile ("cli");
+
+    /* 8259: an out instruction per interrupt */
+    start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        pic_eoi();
+    }
+    pic_cycles = div_u64(rdtsc() - start, BENCH_ITERATIONS);
+    bench_report("8259 EOI", pic_cycles, "cycles");
+
+    /* local APIC: a store to the EOI register */
+    if (lapic_eoi != NULL) {
+        start = rdtsc();
+        for (int i = 0; i < BENCH_ITERATIONS; i++) {
+            apic_eoi();
+        }
+        apic_cycles = div_u64(rdtsc() - start, BENCH_ITERATIONS);
+        bench_report("LAPIC EOI", apic_cycles, "cycles");
+    }
+
+    /* TSC-deadline: rewriting the pending deadline leaves it unchanged */
+    if (timer_mode == TIMER_TSC_DEADLINE) {
+        start = rdtsc();
+        for (int i = 0; i < BENCH_ITERATIONS; i++) {
+            wrmsr(IA32_TSC_DEADLINE, this_cpu()->next_deadline);
+        }
+        rearm_cycles = div_u64(rdtsc() - start, BENCH_ITERATIONS);
+        bench_report("TSC deadline rearm", rearm_cycles, "cycles");
+    }
+
+    asm volatile ("sti");
+}
+
+void bench_irq_off() {
+    unsigned long long start;
+    unsigned long long middle;
+    unsigned long long top_cycles = 0;
+    unsigned long long bottom_cycles = 0;
+
+    unsigned int flags;
+    char left_off[] = "keyboard IRQ off, interrupts left disabled";
+
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        flags = irq_save();
+        start = rdtsc();
+        kbd_handler(BENCH_SCANCODE);
+        middle = rdtsc();
+        kbd_bottom_half();
+        bottom_cycles += rdtsc() - middle;
+        top_cycles += middle - start;
+        this_cpu()->bh_pending = 0;
+        irq_restore(flags);
+        dequeue_char();
+    }
+
+    bench_report("keyboard IRQ off, whole handler",
+                 div_u64(top_cycles + bottom_cycles, BENCH_ITERATIONS), "cycles");
+    bench_report("keyboard IRQ off, top half",
+                 div_u64(top_cycles, BENCH_ITERATIONS), "cycles");
+
+    /* the rest of the suite sleeps on the timer */
+    flags = irq_save();
+    irq_restore(flags);
+    if ((flags & EFLAGS_IF) == 0) {
+        println(left_off);
+        new_line();
+        asm volatile ("sti");
+    }
+}
+
+void bench_pages() {
+    unsigned long long start;
+    unsigned int page;
+
+    start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        page = alloc_page();
+        free_page(page);
+    }
+    bench_report("page alloc/free, cached",
+                 div_u64(rdtsc() - start, BENCH_ITERATIONS), "cycles");
+
+    start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        page = alloc_pages(1);
+        free_pages(page, 1);
+    }
+    bench_report("page alloc/free, bitmap",
+                 div_u64(rdtsc() - start, BENCH_ITERATIONS), "cycles");
+}
+
+void bench_tlb() {
+    unsigned int physical;
+    unsigned int window = kernel_top + LARGE_PAGE_SIZE;
+    unsigned int mapped = 0;
+    unsigned long long start;
+
+    if (kernel_directory == NULL) {
+        return;
+    }
+    physical = alloc_pages(BENCH_TLB_PAGES);
+    if (physical == NULL) {
+        return;
+    }
+
+    /* alias the same physical pages with 4 KB pages above the identity map */
+    while (mapped < BENCH_TLB_PAGES
+           && map_page(kernel_directory, window + mapped * PAGE_SIZE,
+                       physical + mapped * PAGE_SIZE, PAGE_WRITE)) {
+        mapped++;
+    }
+    if (mapped == BENCH_TLB_PAGES) {
+        bench_report("tlb, 4 MB global pages",
+                     bench_touch_pages(physical, FALSE), "cycles per read");
+        bench_report("tlb, 4 MB global pages after flush",
+                     bench_touch_pages(physical, TRUE), "cycles per read");
+        bench_report("tlb, 4 KB pages",
+                     bench_touch_pages(window, FALSE), "cycles per read");
+        bench_report("tlb, 4 KB pages after flush",
+                     bench_touch_pages(window, TRUE), "cycles per read");
+    }
+    while (mapped > 0) {
+        mapped--;
+        unmap_page(kernel_directory, window + mapped * PAGE_SIZE);
+    }
+    free_pages(physical, BENCH_TLB_PAGES);
+
+    start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        flush_tlb();
+    }
+    bench_report("tlb flush",
+                 div_u64(rdtsc() - start, BENCH_ITERATIONS), "cycles");
+}
+
+unsigned int bench_touch_pages(unsigned int base, int flush) {
+    unsigned long long cycles = 0;
+    unsigned long long start;
+    volatile unsigned int* word;
+
+    for (int pass = 0; pass < BENCH_TLB_PASSES; pass++) {
+        if (flush) {
+            flush_tlb();
+        }
+        start = rdtsc();
+        for (unsigned int i = 0; i < BENCH_TLB_PAGES; i++) {
+            /* a different cache line in each page avoids set conflicts */
+            word = (unsigned int*)(base + i * PAGE_SIZE + (i % 64) * CACHE_LINE);
+            (void)*word;
+        }
+        cycles += rdtsc() - start;
+    }
+    return div_u64(cycles, BENCH_TLB_PAGES * BENCH_TLB_PASSES);
+}
+
+void bench_slab() {
+    unsigned long long start;
+    void* object;
+    cache_t* cache;
+
+    /* the first cache (pcbs) has a slab with free objects */
+    start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        object = cache_alloc(caches[0]);
+        cache_free(caches[0], object);
+    }
+    bench_report("slab alloc/free",
+                 div_u64(rdtsc() - start, BENCH_ITERATIONS), "cycles");
+
+    for (unsigned int i = 0; i < cache_count; i++) {
+        cache = caches[i];
+        bench_report(cache->name, cache->in_use, "objects in use");
+        bench_report(cache->name, cache->slabs, "slabs");
+        bench_report(cache->name, slab_fragmentation(cache), "% fragmentation");
+    }
+}
+
+void bench_locks() {
+    unsigned long long start;
+    unsigned int flags;
+
+    init_lock(&bench_spinlock, "bench spinlock");
+    init_ticket_lock(&bench_ticket_lock, "bench ticket lock");
+
+    start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        acquire(&bench_spinlock);
+        release(&bench_spinlock);
+    }
+    bench_report("spinlock acquire/release",
+                 div_u64(rdtsc() - start, BENCH_ITERATIONS), "cycles");
+
+    start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        acquire_ticket(&bench_ticket_lock);
+        release_ticket(&bench_ticket_lock);
+    }
+    bench_report("ticket lock acquire/release",
+                 div_u64(rdtsc() - start, BENCH_ITERATIONS), "cycles");
+
+    start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        flags = acquire_irqsave(&bench_spinlock);
+        release_irqrestore(&bench_spinlock, flags);
+    }
+    bench_report("irq save spinlock acquire/release",
+                 div_u64(rdtsc() - start, BENCH_ITERATIONS), "cycles");
+
+    /* the screen used the irq save spinlock before the mutex */
+    init_mutex(&bench_mutex, "bench mutex");
+    start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        mutex_lock(&bench_mutex);
+        mutex_unlock(&bench_mutex);
+    }
+    bench_report("mutex lock/unlock",
+                 div_u64(rdtsc() - start, BENCH_ITERATIONS), "cycles");
+}
+
+void bench_mutex_contention() {
+    unsigned int cycles;
+    unsigned int worst = 0;
+
+    init_mutex(&bench_mutex, "bench mutex");
+    register_lock_stat(&bench_mutex.stat);
+    bench_mutex_count = 0;
+    for (int i = 0; i < BENCH_WORKERS; i++) {
+        start_process(new_process((unsigned int)p_bench_mutex, SMALL_STACK_SIZE));
+    }
+    while (wait_process(&cycles) != -1) {
+        if (cycles > worst) {
+            worst = cycles;
+        }
+    }
+    bench_report("contended mutex lock/unlock", worst, "cycles");
+    bench_report("mutex waits spent spinning", bench_mutex.spins, "");
+    bench_report("mutex waits spent sleeping", bench_mutex.sleeps, "");
+    if (bench_mutex_count != BENCH_WORKERS * BENCH_ITERATIONS) {
+        bench_report("mutex increments lost",
+                     BENCH_WORKERS * BENCH_ITERATIONS - bench_mutex_count, "");
+    }
+}
+
+void p_bench_mutex() {
+    unsigned long long start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        mutex_lock(&bench_mutex);
+        bench_mutex_count++;
+        mutex_unlock(&bench_mutex);
+    }
+    exit_process(div_u64(rdtsc() - start, BENCH_ITERATIONS));
+}
+
+void bench_lock_stats() {
+    lock_stat_t* stat;
+    for (unsigned int i = 0; i < lock_stat_count; i++) {
+        stat = lock_stats[i];
+        if (stat->contended == 0) {
+            continue;
+        }
+        bench_report(stat->name, stat->contended, "contended");
+        bench_report(stat->name, div_u64(stat->wait_cycles, stat->contended),
+                     "cycles per wait");
+    }
+    if (lock_stats_dropped != 0) {
+        bench_report("lock stats", lock_stats_dropped, "not reported");
+    }
+}
+
+void bench_counter_throughput() {
+    unsigned int end;
+    unsigned int total = 0;
+
+    bench_next_counter = 0;
+    bench_running = TRUE;
+    for (int i = 0; i < BENCH_WORKERS; i++) {
+        bench_counters[i].count = 0;
+    }
+
+    for (int i = 0; i < BENCH_WORKERS; i++) {
+        create_process((unsigned int)p_bench_counter, SMALL_STACK_SIZE);
+    }
+
+    end = uptime_ms() + BENCH_RUN_MS;
+    while (uptime_ms() < end) {
+        asm volatile ("hlt");
+    }
+    bench_running = FALSE;
+    while (wait_process(NULL) != -1);
+
+    for (int i = 0; i < BENCH_WORKERS; i++) {
+        total += bench_counters[i].count;
+    }
+    bench_report("processors", cpus_online, "online");
+    bench_report("counter throughput", total / BENCH_RUN_MS, "K/s");
+}
+
+void p_bench_counter() {
+    unsigned int index = __sync_fetch_and_add(&bench_next_counter, 1);
+    volatile unsigned int* count = &bench_counters[index].count;
+    while (bench_running) {
+        (*count)++;
+    }
+}
+
+void bench_spawn() {
+    unsigned long long start;
+    unsigned int cycles;
+    unsigned int code;
+
+    start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        create_process((unsigned int)p_bench_child, SMALL_STACK_SIZE);
+        wait_process(&code);
+    }
+    cycles = div_u64(rdtsc() - start, BENCH_ITERATIONS);
+    bench_report("spawn/exit/wait", cycles, "cycles");
+    if (tsc_khz != 0 && cycles != 0) {
+        bench_report("spawn throughput", tsc_khz / cycles * 1000, "processes/s");
+    }
+    bench_report("processes", process_count, "live");
+}
+
+void p_bench_child() {
+}
+
+void bench_switch() {
+    unsigned long long start;
+
+    /* alone on its ready queue each switch dequeues the same process */
+    start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        yield();
+    }
+    bench_report("voluntary switch", div_u64(rdtsc() - start, BENCH_ITERATIONS), "cycles");
+
+    start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        asm volatile ("int %0" : : "i" (RESCHED_VECTOR) : "memory");
+    }
+    bench_report("interrupt switch", div_u64(rdtsc() - start, BENCH_ITERATIONS), "cycles");
+}
+
+void bench_ipc() {
+    unsigned int handoffs = ipc_handoffs;
+    unsigned int cycles;
+    unsigned int cpu = this_cpu()->id;
+
+    init_mailbox(&bench_mailbox, "bench mailbox");
+
+    /* both ends on this processor, so every message is a handoff */
+    start_process_on(new_process((unsigned int)p_bench_server, SMALL_STACK_SIZE), cpu);
+    start_process_on(new_process((unsigned int)p_bench_client, SMALL_STACK_SIZE), cpu);
+    while (wait_process(&cycles) != -1) {
+        if (cycles != EXIT_SUCCESS) {
+            bench_report("ipc round trip, one processor", cycles, "cycles");
+        }
+    }
+    bench_report("ipc handoffs", ipc_handoffs - handoffs, "");
+
+    if (cpus_online > 1) {
+        start_process_on(new_process((unsigned int)p_bench_server, SMALL_STACK_SIZE),
+                         (cpu + 1) % cpus_online);
+        start_process_on(new_process((unsigned int)p_bench_client, SMALL_STACK_SIZE), cpu);
+        while (wait_process(&cycles) != -1) {
+            if (cycles != EXIT_SUCCESS) {
+                bench_report("ipc round trip, two processors", cycles, "cycles");
+            }
+        }
+    }
+}
+
+void p_bench_server() {
+    message_t message;
+    pcb_t* client = receive(&bench_mailbox, &message);
+    while (message.words[0] != BENCH_IPC_STOP) {
+        message.words[1] = message.words[0] + 1;
+        client = reply_receive(client, &message, &bench_mailbox, &message);
+    }
+    reply(client, &message);
+}
+
+void p_bench_client() {
+    message_t message;
+    unsigned long long start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        message.words[0] = i;
+        call(&bench_mailbox, &message);
+    }
+    unsigned int cycles = div_u64(rdtsc() - start, BENCH_ITERATIONS);
+    message.words[0] = BENCH_IPC_STOP;
+    call(&bench_mailbox, &message);
+    exit_process(cycles);
+}
+
+void bench_channel() {
+    unsigned int sizes[BENCH_CHANNEL_SIZES] = {16, 64, 256, 1024, BENCH_CHANNEL_MAX_MESSAGE};
+    char names[BENCH_CHANNEL_SIZES][24] = {"channel 16 B", "channel 64 B", "channel 256 B",
+                        "channel 1024 B", "channel 4096 B"};
+    unsigned int cpu = this_cpu()->id;
+    unsigned int errors;
+
+    bench_channel_ring = open_channel("bench", 0);
+    if (bench_channel_ring == NULL) {
+        return;
+    }
+    for (int i = 0; i < BENCH_CHANNEL_SIZES; i++) {
+        bench_message_size = sizes[i];
+        unsigned long long start = clock_ns();
+        start_process_on(new_process((unsigned int)p_bench_consumer, SMALL_STACK_SIZE), cpu);
+        start_process_on(new_process((unsigned int)p_bench_producer, SMALL_STACK_SIZE),
+                         (cpu + 1) % cpus_online);
+        while (wait_process(&errors) != -1) {
+            if (errors != EXIT_SUCCESS) {
+                bench_report("channel messages out of order", errors, "");
+            }
+        }
+
+        /* bytes per micro second is MB/s */
+        unsigned int us = div_u64(clock_ns() - start, 1000);
+        bench_report(names[i], BENCH_CHANNEL_BYTES / (us == 0 ? 1 : us), "MB/s");
+    }
+}
+
+void p_bench_producer() {
+    unsigned int count = BENCH_CHANNEL_BYTES / bench_message_size;
+    for (unsigned int i = 0; i < count; i++) {
+        *(unsigned int*)bench_produced = i;
+        channel_write(bench_channel_ring, bench_produced, bench_message_size);
+    }
+    exit_process(EXIT_SUCCESS);
+}
+
+void p_bench_consumer() {
+    unsigned int count = BENCH_CHANNEL_BYTES / bench_message_size;
+    unsigned int errors = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        channel_read(bench_channel_ring, bench_consumed, bench_message_size);
+        if (*(unsigned int*)bench_consumed != i) {
+            errors++;
+        }
+    }
+    exit_process(errors);
+}
+
+void bench_disk() {
+    unsigned int modes[] = {ATA_MODE_PIO, ATA_MODE_DMA};
+    char sequential[][24] = {"disk sequential PIO", "disk sequential DMA"};
+    char random[][24] = {"disk random PIO", "disk random DMA"};
+    char batch[][24] = {"disk random batch PIO", "disk random batch DMA"};
+    unsigned int blocks = ata_sectors / BCACHE_SECTORS;
+    unsigned int hits = bcache_hits;
+    unsigned int misses = bcache_misses;
+    unsigned int readaheads = bcache_readaheads;
+    unsigned int commands = ata_commands;
+    unsigned int merged = ata_merged;
+
+    if (blocks < BENCH_DISK_BLOCKS) {
+        return;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (ata_set_mode(modes[i]) == FALSE) {
+            continue;
+        }
+        bcache_drop();
+        unsigned long long start = clock_ns();
+        for (unsigned int block = 0; block < BENCH_DISK_BLOCKS; block++) {
+            buf_t* buf = bread(block);
+            if (buf != NULL) {
+                brelse(buf);
+            }
+        }
+        bench_report(sequential[i], bench_kb_per_second(BENCH_DISK_BLOCKS * BCACHE_BLOCK_SIZE, start), "KB/s");
+
+        bcache_drop();
+        unsigned int seed = BENCH_DISK_SEED;
+        start = clock_ns();
+        for (unsigned int j = 0; j < BENCH_DISK_BLOCKS; j++) {
+            seed = seed * 1103515245 + 12345;
+            buf_t* buf = bread((seed >> 8) % blocks);
+            if (buf != NULL) {
+                brelse(buf);
+            }
+        }
+        bench_report(random[i], bench_kb_per_second(BENCH_DISK_BLOCKS * BCACHE_BLOCK_SIZE, start), "KB/s");
+
+        /* many requests at once, so the driver sorts and merges them */
+        start = clock_ns();
+        bench_disk_batch(seed, blocks);
+        bench_report(batch[i], bench_kb_per_second(BENCH_DISK_BLOCKS * BCACHE_BLOCK_SIZE, start), "KB/s");
+    }
+    ata_set_mode(ATA_MODE_DMA);
+    bench_report("block cache hits", bcache_hits - hits, "");
+    bench_report("block cache misses", bcache_misses - misses, "");
+    bench_report("blocks read ahead", bcache_readaheads - readaheads, "");
+    bench_report("disk commands", ata_commands - commands, "");
+    bench_report("disk requests merged", ata_merged - merged, "");
+}
+
+void bench_disk_batch(unsigned int seed, unsigned int blocks) {
+    ata_request_t requests[BENCH_DISK_BATCH];
+    unsigned int buffer = alloc_pages(BENCH_DISK_BATCH);
+    if (buffer == NULL) {
+        return;
+    }
+    for (int round = 0; round < BENCH_DISK_BLOCKS / BENCH_DISK_BATCH; round++) {
+        for (int i = 0; i < BENCH_DISK_BATCH; i++) {
+            seed = seed * 1103515245 + 12345;
+            requests[i].lba = (seed >> 8) % blocks * BCACHE_SECTORS;
+            requests[i].count = BCACHE_SECTORS;
+            requests[i].buffer = (unsigned char*)buffer + i * PAGE_SIZE;
+            requests[i].write = FALSE;
+            requests[i].complete = NULL;
+            requests[i].data = NULL;
+            ata_submit(&requests[i]);
+        }
+        for (int i = 0; i < BENCH_DISK_BATCH; i++) {
+            ata_wait(&requests[i]);
+        }
+    }
+    free_pages(buffer, BENCH_DISK_BATCH);
+}
+
+void bench_fat() {
+    char passes[][24] = {"fat read cold", "fat read cached"};
+    unsigned int buffer = alloc_page();
+    unsigned int tracks = fdc_track_reads;
+    unsigned int walks = fat_chain_walks;
+    unsigned int hits = fat_dcache_hits;
+    unsigned int misses = fat_dcache_misses;
+
+    if (buffer == NULL) {
+        return;
+    }
+    for (int i = 0; i < 2; i++) {
+        unsigned int bytes = 0;
+        int count;
+        unsigned long long start = clock_ns();
+        int fd = fat_open(BENCH_FAT_FILE);
+        if (fd == FAT_ERROR) {
+            free_page(buffer);
+            return;
+        }
+        while ((count = fat_read(fd, (void*)buffer, BENCH_FAT_CHUNK)) > 0) {
+            bytes += count;
+        }
+        fat_close(fd);
+        bench_report(passes[i], bench_kb_per_second(bytes, start), "KB/s");
+    }
+    free_page(buffer);
+    bench_report("floppy tracks read", fdc_track_reads - tracks, "");
+    bench_report("fat chain walks", fat_chain_walks - walks, "");
+    bench_report("fat lookup cache hits", fat_dcache_hits - hits, "");
+    bench_report("fat lookup cache misses", fat_dcache_misses - misses, "");
+}
+
+void bench_boot() {
+    unsigned long long now = rdtsc();
+    unsigned int image = (unsigned int)__bss_start - KERNEL_BASE;
+    if (tsc_khz == 0) {
+        return;
+    }
+    bench_report("boot, kernel image", image / 1024, "KB");
+    bench_report("boot, hot text", (unsigned int)(__hot_end - __hot_start), "bytes");
+    bench_report("boot, init text pages freed", init_pages_freed, "");
+    if (boot_image_size != 0) {
+        bench_report("boot, lz4 image read by boot1", boot_image_size / 1024, "KB");
+        bench_report("boot, reset to unpack (boot1)", div_u64(boot_unpack_tsc, tsc_khz), "ms");
+        bench_report("boot, lz4 unpack", div_u64((boot_tsc - boot_unpack_tsc) * 1000, tsc_khz), "us");
+    }
+    bench_report(multiboot_booted ? "boot, reset to kernel (multiboot)"
+                 : boot_image_size != 0 ? "boot, reset to kernel (boot1, lz4)"
+                                        : "boot, reset to kernel (boot1)",
+                 div_u64(boot_tsc, tsc_khz), "ms");
+    bench_report("boot, kernel to first process", div_u64(now - boot_tsc, tsc_khz), "ms");
+}
+
+void bench_elf() {
+    unsigned int faults = elf_faults;
+    unsigned int hits = elf_shared_hits;
+    unsigned int reads = elf_pages_read;
+    unsigned int failed = 0;
+    unsigned int code;
+    unsigned long long start;
+
+    /* the first instance reads the headers and the shared pages */
+    start = rdtsc();
+    pcb_t* pcb = new_elf_process(BENCH_ELF_PROGRAM);
+    if (pcb == NULL) {
+        return;
+    }
+    image_t* image = pcb->image;
+    unsigned int shared = image->shared_pages;
+    start_process(pcb);
+    while (wait_process(&code) != -1) {
+        failed += code != EXIT_SUCCESS;
+    }
+    bench_report("elf spawn/exit/wait, cold", div_u64(rdtsc() - start, 1), "cycles");
+
+    start = rdtsc();
+    for (int i = 0; i < BENCH_ELF_INSTANCES; i++) {
+        start_process(new_elf_process(BENCH_ELF_PROGRAM));
+    }
+    while (wait_process(&code) != -1) {
+        failed += code != EXIT_SUCCESS;
+    }
+    bench_report("elf spawn/exit/wait, cached",
+                 div_u64(rdtsc() - start, BENCH_ELF_INSTANCES), "cycles");
+
+    /* every fault not on a shared page mapped a private one */
+    unsigned int private = elf_faults - faults - (elf_shared_hits - hits)
+                           - (image->shared_pages - shared);
+    bench_report("elf page faults", elf_faults - faults, "");
+    bench_report("elf pages read", elf_pages_read - reads, "");
+    bench_report("elf shared page hits", elf_shared_hits - hits, "");
+    bench_report("elf shared pages", image->shared_pages, "resident");
+    bench_report("elf private pages", private / (BENCH_ELF_INSTANCES + 1), "per instance");
+    bench_report("elf instances failed", failed, "");
+}
+
+unsigned int bench_kb_per_second(unsigned int bytes, unsigned long long start) {
+    unsigned int us = div_u64(clock_ns() - start, 1000);
+    if (us == 0) {
+        us = 1;
+    }
+    return div_u64((unsigned long long)bytes * (US_PER_SEC / 1024), us);
+}
+
+void bench_quanta() {
+    unsigned int quantum;
+
+    bench_running = TRUE;
+    create_process((unsigned int)p_bench_hog, SMALL_STACK_SIZE);
+    create_process((unsigned int)p_bench_yielder, SMALL_STACK_SIZE);
+    delay_us(BENCH_QUANTA_MS * 1000);
+    bench_running = FALSE;
+    while (wait_process(&quantum) != -1) {
+        bench_report("final quantum", quantum, "us");
+    }
+    bench_report("tick", tick_us, "us");
+}
+
+void p_bench_hog() {
+    while (bench_running);
+    exit_process(current_process()->quantum);
+}
+
+void p_bench_yielder() {
+    while (bench_running) {
+        yield();
+    }
+    exit_process(current_process()->quantum);
+}
+
+void bench_edf() {
+    unsigned int misses = deadline_misses;
+    unsigned int admitted = 0;
+    unsigned int jitter = 0;
+    pcb_t* pcb;
+
+    bench_next_counter = 0;
+    for (int i = 0; i < BENCH_RT_TASKS; i++) {
+        bench_rt_worst[i] = 0;
+    }
+
+    /* compete with a CPU bound process on every processor */
+    bench_running = TRUE;
+    for (unsigned int i = 0; i < cpus_online; i++) {
+        create_process((unsigned int)p_bench_hog, SMALL_STACK_SIZE);
+    }
+    for (int i = 0; i < BENCH_RT_TASKS; i++) {
+        pcb = new_process((unsigned int)p_bench_rt, SMALL_STACK_SIZE);
+        if (pcb == NULL) {
+            break;
+        }
+        if (set_realtime(pcb, BENCH_RT_PERIOD_US, BENCH_RT_BUDGET_US) == TRUE) {
+            admitted++;
+        }
+        start_process(pcb);
+    }
+    bench_report("real-time tasks admitted", admitted, "");
+
+    /* a process needing a whole processor never fits */
+    pcb = new_process((unsigned int)p_bench_child, SMALL_STACK_SIZE);
+    if (pcb != NULL) {
+        bench_report("overload admitted", set_realtime(pcb, BENCH_RT_PERIOD_US,
+                     BENCH_RT_PERIOD_US), "");
+        start_process(pcb);
+    }
+
+    delay_us(BENCH_RT_PERIODS * BENCH_RT_PERIOD_US);
+    bench_running = FALSE;
+    while (wait_process(NULL) != -1);
+    for (int i = 0; i < BENCH_RT_TASKS; i++) {
+        if (bench_rt_worst[i] > jitter) {
+            jitter = bench_rt_worst[i];
+        }
+    }
+    bench_report("worst release jitter", jitter, "us");
+    bench_report("deadline misses", deadline_misses - misses, "");
+}
+
+void p_bench_rt() {
+    pcb_t* pcb = current_process();
+    unsigned int index = __sync_fetch_and_add(&bench_next_counter, 1);
+    if (pcb->rt_period == 0) {
+        return;
+    }
+    for (int i = 0; i < BENCH_RT_PERIODS; i++) {
+        wait_period();
+        unsigned int late = div_u64(clock_ns() - pcb->rt_release, 1000);
+        if (late > bench_rt_worst[index]) {
+            bench_rt_worst[index] = late;
+        }
+        delay_us(BENCH_RT_BUDGET_US / 2);
+    }
+}
+
+void bench_syscall() {
+    unsigned int cycles;
+
+    if (create_user_process((unsigned int)p_bench_syscall_int, SMALL_STACK_SIZE) == EXIT_SUCCESS
+        && wait_process(&cycles) != -1) {
+        bench_report("null system call, int 0x80", cycles, "cycles");
+    }
+    if (sysenter_enabled
+        && create_user_process((unsigned int)p_bench_syscall_fast, SMALL_STACK_SIZE) == EXIT_SUCCESS
+        && wait_process(&cycles) != -1) {
+        bench_report("null system call, sysenter", cycles, "cycles");
+    }
+}
+
+void p_bench_syscall_int() {
+    unsigned long long start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        syscall_int(SYS_NULL, 0, 0, 0);
+    }
+    sys_exit(div_u64(rdtsc() - start, BENCH_ITERATIONS));
+}
+
+void p_bench_syscall_fast() {
+    unsigned long long start = rdtsc();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        syscall_fast(SYS_NULL, 0, 0, 0);
+    }
+    sys_exit(div_u64(rdtsc() - start, BENCH_ITERATIONS));
+}
+
+void bench_fork() {
+    unsigned int* parent;
+    unsigned int* child;
+    unsigned int* children[BENCH_FORK_ROUNDS];
+    unsigned int mapped = 0;
+    unsigned int page;
+    unsigned int pages;
+    unsigned int copies;
+    unsigned int cycles;
+    unsigned long long start;
+
+    if (kernel_directory == NULL || (parent = new_directory()) == NULL) {
+        return;
+    }
+
+    /* a warm parent, every page written */
+    while (mapped < BENCH_FORK_PAGES) {
+        page = alloc_page();
+        if (page == NULL || map_page(parent, USER_BASE + mapped * PAGE_SIZE, page,
+                                     PAGE_USER | PAGE_WRITE) == FALSE) {
+            if (page != NULL) {
+                free_page(page);
+            }
+            free_directory(parent);
+            return;
+        }
+        mapped++;
+    }
+
+    for (int copy = FALSE; copy <= TRUE; copy++) {
+        pages = fork_pages;
+        start = rdtsc();
+        for (int i = 0; i < BENCH_FORK_ROUNDS; i++) {
+            children[i] = fork_directory(parent, copy);
+        }
+        cycles = div_u64(rdtsc() - start, BENCH_FORK_ROUNDS);
+        pages = (fork_pages - pages) / BENCH_FORK_ROUNDS;
+        for (int i = 0; i < BENCH_FORK_ROUNDS; i++) {
+            if (children[i] != NULL) {
+                free_directory(children[i]);
+            }
+        }
+        bench_report(copy ? "fork, full copy" : "fork, copy-on-write", cycles, "cycles");
+        bench_report(copy ? "fork memory, full copy" : "fork memory, copy-on-write",
+                     pages * (PAGE_SIZE / 1024), "KB");
+    }
+
+    /* the child copies every page, then the parent is the last sharer */
+    child = fork_directory(parent, FALSE);
+    if (child != NULL) {
+        copies = cow_copies;
+        start = rdtsc();
+        for (unsigned int i = 0; i < mapped; i++) {
+            unshare_page(child, USER_BASE + i * PAGE_SIZE);
+        }
+        bench_report("first write after fork, copied",
+                     div_u64(rdtsc() - start, mapped), "cycles");
+        start = rdtsc();
+        for (unsigned int i = 0; i < mapped; i++) {
+            unshare_page(parent, USER_BASE + i * PAGE_SIZE);
+        }
+        bench_report("first write after fork, last sharer",
+                     div_u64(rdtsc() - start, mapped), "cycles");
+        bench_report("pages copied on write", cow_copies - copies, "");
+        free_directory(child);
+    }
+    free_directory(parent);
+
+    if (create_user_process((unsigned int)p_bench_fork, SMALL_STACK_SIZE) == EXIT_SUCCESS
+        && wait_process(&cycles) != -1) {
+        bench_report("fork system call", cycles, "cycles");
+    }
+}
+
+void p_bench_fork() {
+    unsigned long long start = rdtsc();
+    for (int i = 0; i < BENCH_FORK_CHILDREN; i++) {
+        if (sys_fork() == 0) {
+            sys_exit(EXIT_SUCCESS);
+        }
+    }
+    sys_exit(div_u64(rdtsc() - start, BENCH_FORK_CHILDREN));
+}
+
+void bench_fpu() {
+    unsigned int traps = fpu_traps;
+    unsigned int switches = fpu_switches;
+    unsigned int errors = 0;
+    unsigned int code;
+
+    bench_next_counter = 0;
+    for (int i = 0; i < BENCH_FPU_PROCESSES; i++) {
+        create_process((unsigned int)p_bench_fpu, SMALL_STACK_SIZE);
+    }
+    while (wait_process(&code) != -1) {
+        if (code != EXIT_SUCCESS) {
+            errors++;
+        }
+    }
+    bench_report("fpu traps", fpu_traps - traps, "");
+    bench_report("fpu state switches", fpu_switches - switches, "");
+    bench_report("fpu state errors", errors, "processes");
+}
+
+void p_bench_fpu() {
+    double step = (__sync_fetch_and_add(&bench_next_counter, 1) + 1) * 0.25;
+    volatile double sum = 0.0;
+    for (int i = 0; i < BENCH_FPU_STEPS; i++) {
+        sum += step;
+    }
+    if (sum != step * BENCH_FPU_STEPS) {
+        exit_process(EXIT_FAILURE);
+    }
+}
+
+void bench_stacks() {
+    pcb_t* pcb;
+    unsigned int flags = acquire_irqsave(&process_lock);
+    for (pcb = process_table; pcb != NULL; pcb = pcb->table_next) {
+        if (pcb->stack == NULL) {
+            continue;
+        }
+        bench_report("pid", pcb->pid, "");
+        bench_report("  stack size", pcb->stack_size, "bytes");
+        bench_report("  stack high water", stack_high_water(pcb), "bytes");
+        if (stack_overflowed(pcb)) {
+            bench_report("  stack guard", STACK_GUARD_SIZE, "bytes overwritten");
+        }
+    }
+    release_irqrestore(&process_lock, flags);
+    bench_report("stack overflows", stack_overflows, "exited processes");
+}
@@ -0,0 +1,395 @@
+/**
+ * @file bench.h
+ * @author Robert McKay
+ * @brief Declares the in kernel benchmark suite (built with make bench).
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#define BENCH_ITERATIONS 1000
+
+/* build profile, set by the Makefile */
+#ifndef PROFILE
+#define PROFILE "debug"
+#endif
+
+/* counter throughput benchmark */
+#define BENCH_WORKERS 4
+#define BENCH_RUN_MS 1000
+
+/* tlb benchmark: pages touched per pass and passes */
+#define BENCH_TLB_PAGES 256
+#define BENCH_TLB_PASSES 16
+
+/* fpu benchmark: processes sharing the FPU and additions each makes */
+#define BENCH_FPU_PROCESSES (2 * BENCH_WORKERS)
+#define BENCH_FPU_STEPS 4000000
+
+/* quanta benchmark: how long the hog and the yielder run */
+#define BENCH_QUANTA_MS 200
+
+/* edf benchmark: real-time tasks, their period and budget in micro
+   seconds, and how many periods they run */
+#define BENCH_RT_TASKS 8
+#define BENCH_RT_PERIOD_US 5000
+#define BENCH_RT_BUDGET_US 1000
+#define BENCH_RT_PERIODS 40
+
+/* ipc benchmark: message telling the server to stop */
+#define BENCH_IPC_STOP 0xffffffff
+
+/* channel benchmark: bytes moved at each message size, largest message */
+#define BENCH_CHANNEL_BYTES 0x400000
+#define BENCH_CHANNEL_MAX_MESSAGE 4096
+#define BENCH_CHANNEL_SIZES 5
+
+/* disk benchmark: blocks read per pattern, requests submitted together,
+   seed of the random block numbers */
+#define BENCH_DISK_BLOCKS 256
+#define BENCH_DISK_BATCH 16
+#define BENCH_DISK_SEED 12345
+
+/* fat benchmark: file make install copies to the floppy, bytes per read */
+#define BENCH_FAT_FILE "/bench.bin"
+#define BENCH_FAT_CHUNK 4096
+
+/* elf benchmark: program make install copies to the floppy, instances run
+   after the first */
+#define BENCH_ELF_PROGRAM "/hello.elf"
+#define BENCH_ELF_INSTANCES 4
+
+/* fork benchmark: private pages of the parent address space, forks timed
+   per mode, and children forked by a ring 3 process */
+#define BENCH_FORK_PAGES 64
+#define BENCH_FORK_ROUNDS 8
+#define BENCH_FORK_CHILDREN 8
+
+/* scancode of the a key, used to drive the keyboard handler */
+#define BENCH_SCANCODE 0x1e
+
+/**
+ * @brief Process that runs every benchmark and prints the results.
+ *
+ */
+void p_bench();
+
+/**
+ * @brief Prints one benchmark result on its own line.
+ *
+ * @param name Name of the measurement.
+ * @param value The measured value.
+ * @param unit Unit of the value.
+ */
+void bench_report(char* name, unsigned int value, char* unit);
+
+/**
+ * @brief Measures the cycles each interrupt controller adds to an interrupt:
+ * the 8259 EOI, the local APIC EOI and the TSC deadline rearm.
+ *
+ */
+void bench_interrupt_overhead();
+
+/**
+ * @brief Measures the cycles the keyboard interrupt keeps interrupts
+ * disabled: the whole handler before bottom halves, and the top half alone
+ * now that the rest runs with interrupts enabled. Interrupts are enabled
+ * again on return, and reported if they were not.
+ *
+ */
+void bench_irq_off();
+
+/**
+ * @brief Measures allocating and freeing a page through the processor's
+ * page cache and directly from the bitmap.
+ *
+ */
+void bench_pages();
+
+/**
+ * @brief Measures allocating and freeing an object from a slab cache and
+ * prints the statistics of every cache.
+ *
+ */
+void bench_slab();
+
+/**
+ * @brief Measures page-crossing reads of the same memory through the
+ * identity map's global 4 MB pages and through 4 KB pages mapped above
+ * the user stacks, with and without a TLB flush before each pass.
+ *
+ */
+void bench_tlb();
+
+/**
+ * @brief Reads one word from each of BENCH_TLB_PAGES consecutive pages,
+ * BENCH_TLB_PASSES times.
+ *
+ * @param base Address of the first page.
+ * @param flush TRUE to flush the TLB before each pass.
+ * @return unsigned int Average cycles per read.
+ */
+unsigned int bench_touch_pages(unsigned int base, int flush);
+
+/**
+ * @brief Measures an uncontended acquire and release of each lock type.
+ *
+ */
+void bench_locks();
+
+/**
+ * @brief Runs BENCH_WORKERS processes taking one mutex and reports the
+ * slowest one's cycles per lock/unlock and how many waits spun or slept.
+ *
+ */
+void bench_mutex_contention();
+
+/**
+ * @brief Worker process for bench_mutex_contention. Increments a shared
+ * counter BENCH_ITERATIONS times under the mutex and exits with its
+ * average cycles per lock/unlock.
+ *
+ */
+void p_bench_mutex();
+
+/**
+ * @brief Prints the contention counters of every kernel lock that was
+ * contended while the benchmarks ran.
+ *
+ */
+void bench_lock_stats();
+
+/**
+ * @brief Runs BENCH_WORKERS counting processes for BENCH_RUN_MS and reports
+ * their combined rate, which should scale with the number of processors.
+ *
+ */
+void bench_counter_throughput();
+
+/**
+ * @brief Worker process for bench_counter_throughput. Increments its own
+ * counter while the benchmark is running, then exits.
+ *
+ */
+void p_bench_counter();
+
+/**
+ * @brief Measures creating a process, letting it exit and reaping it with
+ * wait_process, then checks that no process is left behind.
+ *
+ */
+void bench_spawn();
+
+/**
+ * @brief Measures a voluntary switch through yield against the interrupt
+ * style switch taken by dispatch, entered with the reschedule vector.
+ *
+ */
+void bench_switch();
+
+/**
+ * @brief Measures the round trip of call and reply_receive between a
+ * client and a server on one processor (direct handoff) and on two.
+ *
+ */
+void bench_ipc();
+
+/**
+ * @brief Server process for bench_ipc. Answers calls until told to stop.
+ *
+ */
+void p_bench_server();
+
+/**
+ * @brief Client process for bench_ipc. Makes BENCH_ITERATIONS calls, stops
+ * the server and exits with the average cycles per round trip.
+ *
+ */
+void p_bench_client();
+
+/**
+ * @brief Streams BENCH_CHANNEL_BYTES through a channel at several message
+ * sizes, with the producer and consumer on different processors when there
+ * are two, and reports the throughput of each in MB/s.
+ *
+ */
+void bench_channel();
+
+/**
+ * @brief Producer process for bench_channel. Writes bench_message_size
+ * byte messages, each starting with its sequence number.
+ *
+ */
+void p_bench_producer();
+
+/**
+ * @brief Consumer process for bench_channel. Reads the messages back and
+ * exits with the number that arrived out of order.
+ *
+ */
+void p_bench_consumer();
+
+/**
+ * @brief Reads BENCH_DISK_BLOCKS blocks in PIO and DMA mode through the
+ * block cache, sequentially (with read-ahead) and at random, and straight
+ * from the driver in batches of BENCH_DISK_BATCH random requests, and
+ * reports each throughput in KB/s. Needs a disk of at least
+ * BENCH_DISK_BLOCKS blocks.
+ *
+ */
+void bench_disk();
+
+/**
+ * @brief Reads BENCH_DISK_BLOCKS random blocks, submitting
+ * BENCH_DISK_BATCH requests before waiting for any.
+ *
+ * @param seed Seed of the block numbers.
+ * @param blocks Blocks on the disk.
+ */
+void bench_disk_batch(unsigned int seed, unsigned int blocks);
+
+/**
+ * @brief Reads BENCH_FAT_FILE through the FAT12 file system twice, the
+ * second time with its directory entry cached, and reports the throughput
+ * of each pass and the floppy tracks read. Skipped if the file is missing.
+ *
+ */
+void bench_fat();
+
+/**
+ * @brief Reports the size of the kernel image and its hot text, the INIT
+ * pages freed, the milliseconds from reset (the TSC starts at 0) to
+ * kernel_entry, spent in the BIOS and boot1 or the Multiboot loader, and
+ * from kernel_entry to the first process. For an LZ4
+ * compressed kernel, also the size boot1 read, the time to the unlz4 stub
+ * and the time it took to unpack. Called first by p_bench.
+ * 
+ */
+void bench_boot();
+
+/**
+ * @brief Spawns BENCH_ELF_PROGRAM once with its image not yet loaded, then
+ * BENCH_ELF_INSTANCES more times, and reports the cycles from spawn to
+ * exit of each, the pages faulted in, read and shared, and the private
+ * pages per instance. Skipped if the program is missing.
+ *
+ */
+void bench_elf();
+
+/**
+ * @brief Converts bytes moved since a start time to KB/s.
+ *
+ * @param bytes Bytes moved.
+ * @param start clock_ns when the transfer started.
+ * @return unsigned int Throughput in KB/s.
+ */
+unsigned int bench_kb_per_second(unsigned int bytes, unsigned long long start);
+
+/**
+ * @brief Runs a CPU bound process and one that keeps yielding for
+ * BENCH_QUANTA_MS and reports the quantum each adapted to.
+ *
+ */
+void bench_quanta();
+
+/**
+ * @brief CPU bound process for bench_quanta. Spins while the benchmark runs
+ * and exits with its quantum.
+ *
+ */
+void p_bench_hog();
+
+/**
+ * @brief Yielding process for bench_quanta. Yields while the benchmark runs
+ * and exits with its quantum.
+ *
+ */
+void p_bench_yielder();
+
+/**
+ * @brief Runs BENCH_RT_TASKS periodic real-time processes against a CPU
+ * bound process on every processor. Reports how many were admitted,
+ * whether a process needing most of a processor is still admitted, the
+ * worst delay from a release to the job running and the deadline misses.
+ *
+ */
+void bench_edf();
+
+/**
+ * @brief Real-time process for bench_edf. Each period it records how late
+ * it started and works for half its budget. Returns at once if it was not
+ * admitted.
+ *
+ */
+void p_bench_rt();
+
+/**
+ * @brief Measures a null system call from a ring 3 process through the
+ * int 0x80 gate and through SYSENTER/SYSEXIT.
+ *
+ */
+void bench_syscall();
+
+/**
+ * @brief Ring 3 process for bench_syscall. Makes BENCH_ITERATIONS null
+ * calls with int 0x80 and exits with the average cycles per call.
+ *
+ */
+void p_bench_syscall_int();
+
+/**
+ * @brief Ring 3 process for bench_syscall. Makes BENCH_ITERATIONS null
+ * calls with SYSENTER and exits with the average cycles per call.
+ *
+ */
+void p_bench_syscall_fast();
+
+/**
+ * @brief Forks an address space of BENCH_FORK_PAGES written pages with
+ * copy-on-write and with a full copy and reports the cycles and memory per
+ * fork, the cost of the first write to a page after a fork, and the cycles
+ * per sys_fork of a ring 3 process.
+ * 
+ */
+void bench_fork();
+
+/**
+ * @brief Ring 3 process for bench_fork. Forks BENCH_FORK_CHILDREN children
+ * that exit at once and exits with the cycles per fork.
+ * 
+ */
+void p_bench_fork();
+
+/**
+ * @brief Runs BENCH_FPU_PROCESSES floating point processes, at least two
+ * per processor, and reports the device not available traps and state
+ * switches they caused and how many ended with a wrong result.
+ *
+ */
+void bench_fpu();
+
+/**
+ * @brief Worker process for bench_fpu. Adds its own step BENCH_FPU_STEPS
+ * times across preemptions and exits with EXIT_FAILURE if the sum is wrong.
+ *
+ */
+void p_bench_fpu();
+
+/**
+ * @brief Prints the stack size and high-water mark of every live process,
+ * flags any whose guard region was written, and the number of exited
+ * processes that overflowed.
+ *
+ */
+void bench_stacks();
+
+/**
+ * @brief Child process for bench_spawn. Returns at once.
+ *
+ */
+void p_bench_child();
+
+#endif
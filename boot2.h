@@ -7,14 +7,35 @@
         k_print - moves a given string to video memory.
         k_scroll - scrolls video memory up by one row.
         kbd_enter - interrupt handler for keyboard.
-        default_handler - default interrupt handler.
+        ata_enter - interrupt handler for the primary IDE channel.
+        fdc_enter - interrupt handler for the floppy disk controller.
+        fpu_enter - device not available handler, switches the FPU state.
+        page_fault_enter - page fault handler.
+        spurious_handler - local APIC spurious interrupt handler.
+        resched_enter - reschedule IPI handler.
         lidtr - loads the IDT.
+        lgdtr - loads the GDT and reloads the segment registers.
         outportb - writes given byte to specified port.
+        inportb - reads a byte from the specified port.
         go - dequeues the next process and jumps to it.
-        dispatch - enqueues the current process and calls go.
-        kbd_block - blocks a process waiting on keyboard input.
+        switch_process - voluntary switch, saves the callee saved registers.
+        switch_to - voluntary switch to a given process.
+        switch_start - first return address of a new process.
+        dispatch - enqueues the current process and switches to the next.
+        block_process - blocks the current process on a queue.
+        exit_switch - leaves the stack of an exiting process and calls go.
+        syscall_enter - int 0x80 system call entry point.
+        sysenter_entry - SYSENTER system call entry point.
+        syscall_int - makes a system call from user mode with int 0x80.
+        syscall_fast - makes a system call from user mode with SYSENTER.
         init_timer_dev - initializes the timer interval.
 
+    Labels:
+        exception_stubs - entry points of exceptions 0-31.
+        ap_trampoline - start of the application processor start up code.
+        ap_gdtr - gdt register image inside the start up code.
+        ap_trampoline_end - end of the application processor start up code.
+
     Author: Robert McKay (except for k_scroll)
     Since: 11/26/2021
 
@@ -47,11 +68,47 @@ extern void k_scroll();
 -----------------------------------------------------------------------------*/
 extern void kbd_enter();
 
-/*----------------------------- default_handler -------------------------------
-    Default interrupt handler.
+/*--------------------------------- ata_enter ---------------------------------
+    Disk interrupt handler for the primary IDE channel.
+    Defined in boot2.S
+-----------------------------------------------------------------------------*/
+extern void ata_enter();
+
+/*--------------------------------- fdc_enter ---------------------------------
+    Interrupt handler for the floppy disk controller.
+    Defined in boot2.S
+-----------------------------------------------------------------------------*/
+extern void fdc_enter();
+
+/*----------------------------- exception_stubs -------------------------------
+    Entry points of exceptions 0-31, indexed by vector.
+    Defined in boot2.S
+-----------------------------------------------------------------------------*/
+extern unsigned int exception_stubs[];
+
+/*-------------------------------- fpu_enter ----------------------------------
+    Device not available handler, loads the current process's FPU state.
+    Defined in boot2.S
+-----------------------------------------------------------------------------*/
+extern void fpu_enter();
+
+/*----------------------------- page_fault_enter ------------------------------
+    Page fault handler, calls page_fault in paging.c.
+    Defined in boot2.S
+-----------------------------------------------------------------------------*/
+extern void page_fault_enter();
+
+/*---------------------------- spurious_handler -------------------------------
+    Local APIC spurious interrupt handler.
+    Defined in boot2.S
+-----------------------------------------------------------------------------*/
+extern void spurious_handler();
+
+/*------------------------------ resched_enter --------------------------------
+    Reschedule IPI handler.
     Defined in boot2.S
 -----------------------------------------------------------------------------*/
-extern void default_handler();
+extern void resched_enter();
 
 /*----------------------------------- lidtr -----------------------------------
     Loads the idt.
@@ -62,6 +119,15 @@ extern void default_handler();
 -----------------------------------------------------------------------------*/
 extern void lidtr(unsigned int idtr);
 
+/*----------------------------------- lgdtr -----------------------------------
+    Loads the gdt and reloads the segment registers.
+    Defined in boot2.S
+
+    Paremeters:
+        gdtr - address of struct with limit and gdt address
+-----------------------------------------------------------------------------*/
+extern void lgdtr(unsigned int gdtr);
+
 /*---------------------------------- outportb ---------------------------------
     Writes a given byte to the specified port address.
     Defined in boot2.S
@@ -72,28 +138,153 @@ extern void lidtr(unsigned int idtr);
 -----------------------------------------------------------------------------*/
 extern void outportb(unsigned short port, unsigned char value);
 
+/*---------------------------------- inportb ----------------------------------
+    Reads a byte from the specified port address.
+    Defined in boot2.S
+
+    Paremeters:
+        port - address of the port to read from.
+
+    Returns: the byte read from the port.
+-----------------------------------------------------------------------------*/
+extern unsigned char inportb(unsigned short port);
+
 /*----------------------------------- go --------------------------------------
-    Dequeue the next process, restore its state, and jump to it.
+    Dequeue the next process, restore its state, and jump to it. Does not
+    return.
+-----------------------------------------------------------------------------*/
+extern void go() __attribute__ ((noreturn));
+
+/*---------------------------- switch_process ---------------------------------
+    Voluntary context switch. Saves the callee saved registers of the current
+    process, which the caller has already queued, runs the next process and
+    returns when the current process runs again. Call with interrupts
+    disabled.
+    Defined in boot2.S
+-----------------------------------------------------------------------------*/
+extern void switch_process();
+
+/*------------------------------- switch_to -----------------------------------
+    Direct handoff to a process blocked on this processor, which keeps the
+    slice the caller gave it. Call with interrupts disabled.
+    Defined in boot2.S
+
+    Paremeters:
+        pcb - address of the pcb to run
 -----------------------------------------------------------------------------*/
-extern void go();
+extern void switch_to(unsigned int pcb);
+
+/*----------------------------- switch_start ----------------------------------
+    Return address in the switch frame of a new process. Pops the initial
+    interrupt frame built by init_stack or init_user_stack.
+    Defined in boot2.S
+-----------------------------------------------------------------------------*/
+extern void switch_start();
 
 /*------------------------------- dispatch ------------------------------------
-    Save state and enqueue current process, call go.
+    Save state and enqueue current process, switch to the next process.
 -----------------------------------------------------------------------------*/
 extern void dispatch();
 
-/*------------------------------ kbd_block ------------------------------------
-    Block a process waiting on keyboard input.
+/*---------------------------- block_process ----------------------------------
+    Block the current process on a queue. Releases the given lock once the
+    process is on the queue, so a wakeup cannot be missed.
+    Defined in boot2.S
+
+    Paremeters:
+        queue - address of the queue to wait on
+        lock - address of the spinlock held by the caller
+-----------------------------------------------------------------------------*/
+extern void block_process(unsigned int queue, unsigned int lock);
+
+/*----------------------------- exit_switch -----------------------------------
+    Switch from an exiting process to this processor's stack, retire the
+    process and run the next one. Does not return.
+    Defined in boot2.S
+
+    Paremeters:
+        pcb - address of the exiting process's pcb
+-----------------------------------------------------------------------------*/
+extern void exit_switch(unsigned int pcb);
+
+/*---------------------------- syscall_enter ----------------------------------
+    int 0x80 system call entry point, returns with iret.
+    Defined in boot2.S
+-----------------------------------------------------------------------------*/
+extern void syscall_enter();
+
+/*---------------------------- sysenter_entry ---------------------------------
+    SYSENTER system call entry point, returns with SYSEXIT unless the process
+    was switched out during the call.
+    Defined in boot2.S
+-----------------------------------------------------------------------------*/
+extern void sysenter_entry();
+
+/*------------------------------ syscall_int ----------------------------------
+    Makes a system call with int 0x80. Callable from user mode.
+    Defined in boot2.S
+
+    Paremeters:
+        number - the system call number (eax)
+        arg1, arg2, arg3 - the arguments (ebx, esi, edi)
+
+    Returns: the result of the call.
+-----------------------------------------------------------------------------*/
+extern unsigned int syscall_int(unsigned int number, unsigned int arg1,
+                                unsigned int arg2, unsigned int arg3);
+
+/*------------------------------ syscall_fast ---------------------------------
+    Makes a system call with SYSENTER. Callable from user mode only, since
+    SYSEXIT always returns to ring 3.
+    Defined in boot2.S
+
+    Paremeters:
+        number - the system call number (eax)
+        arg1, arg2, arg3 - the arguments (ebx, esi, edi)
+
+    Returns: the result of the call.
 -----------------------------------------------------------------------------*/
-extern void kbd_block();
+extern unsigned int syscall_fast(unsigned int number, unsigned int arg1,
+                                 unsigned int arg2, unsigned int arg3);
 
 /*---------------------------- init_timer_dev ---------------------------------
     Initialize the timer interval device.
 
     Parameters: 
-        interval - the interval in milli seconds for the timer.
+        count - PIT counter reload value, PIT_FREQUENCY / count interrupts
+                per second (max 0xffff).
 -----------------------------------------------------------------------------*/
-extern void init_timer_dev(unsigned int interval);
+extern void init_timer_dev(unsigned int count);
 
+/*------------------------------- ap_trampoline -------------------------------
+    Real mode start up code for the application processors, copied below
+    1 MB by init_smp. ap_gdtr is patched with the BSP's gdt register.
+-----------------------------------------------------------------------------*/
+extern char ap_trampoline[];
+extern char ap_gdtr[];
+extern char ap_trampoline_end[];
+
+/*------------------------------ boot_stack_top -------------------------------
+    Top of the stack main runs on, reused by the BSP for exit_switch.
+-----------------------------------------------------------------------------*/
+extern char boot_stack_top[];
+
+/*--------------------------------- boot_tsc ----------------------------------
+    TSC read at kernel_entry, the cycles since reset spent in the BIOS and
+    the loader (boot1 or a Multiboot loader).
+-----------------------------------------------------------------------------*/
+extern unsigned long long boot_tsc;
+
+/*------------------------------ boot_unpack_tsc ------------------------------
+    TSC when the unlz4 stub started unpacking an LZ4 compressed kernel, the
+    end of boot1's floppy reads. 0 if the kernel was not compressed.
+-----------------------------------------------------------------------------*/
+extern unsigned long long boot_unpack_tsc;
+
+/*------------------------------ boot_image_size ------------------------------
+    Bytes of the compressed image boot1 read, 0 if the kernel was not
+    compressed.
+-----------------------------------------------------------------------------*/
+extern unsigned int boot_image_size;
 
 #endif
\ No newline at end of file
@@ -11,14 +11,28 @@
 #include "scheduler.h"
 #include "process.h"
 #include "boot2.h"
+#include "lock.h"
+#include "cpu.h"
 
 /* global variables for keyboard buffer */
 char kbd_buffer[BUFFER_SIZE];
 int kbd_buf_head = EMPTY;
 int kbd_buf_tail = EMPTY;
 
+/* protects the buffer and the blocked queue waiting on it */
+spinlock_t kbd_lock;
+
+INIT void init_buffer() {
+    kbd_buf_head = EMPTY;
+    kbd_buf_tail = EMPTY;
+    init_lock(&kbd_lock, "keyboard buffer");
+    register_lock_stat(&kbd_lock.stat);
+}
+
 int enqueue_char(char value) {
+    unsigned int flags = acquire_irqsave(&kbd_lock);
     if (is_full() == TRUE) {
+        release_irqrestore(&kbd_lock, flags);
         return FALSE;
     }
     if (kbd_buf_head == EMPTY) {
@@ -26,13 +40,21 @@ int enqueue_char(char value) {
     }
     kbd_buf_tail = (kbd_buf_tail + 1) % BUFFER_SIZE;
     kbd_buffer[kbd_buf_tail] = value;
+
+    /* wake a reader, it cannot block again until the lock is released */
+    pcb_t* pcb = dequeue_process(&blocked_queue);
+    if (pcb != NULL) {
+        make_ready(pcb);
+    }
+    release_irqrestore(&kbd_lock, flags);
     return TRUE;
 }
 
 char dequeue_char() {
-    asm volatile ("cli");
+    unsigned int flags = acquire_irqsave(&kbd_lock);
     while (is_empty() == TRUE) {
-        kbd_block();
+        block_process((unsigned int)&blocked_queue, (unsigned int)&kbd_lock);
+        acquire(&kbd_lock);
     }
     char head = kbd_buffer[kbd_buf_head];
     if (kbd_buf_head == kbd_buf_tail) {
@@ -41,7 +63,7 @@ char dequeue_char() {
     } else {
         kbd_buf_head = (kbd_buf_head + 1) % BUFFER_SIZE;
     }
-    asm volatile ("sti");
+    release_irqrestore(&kbd_lock, flags);
     return head;
 }
 
@@ -17,7 +17,14 @@
 #define EMPTY -1
 
 /**
- * @brief Enqueues a char to the keyboard buffer.
+ * @brief Initializes the keyboard buffer and its lock.
+ * 
+ */
+void init_buffer();
+
+/**
+ * @brief Enqueues a char to the keyboard buffer and wakes a process blocked
+ * waiting for input.
  * 
  * @param value the char to add to the buffer.
  * @return int 1 (TRUE) if char added to buffer, 0 (FALSE) otherwise.
@@ -25,7 +32,8 @@
 int enqueue_char(char value);
 
 /**
- * @brief Dequeues a char from the keyboard buffer.
+ * @brief Dequeues a char from the keyboard buffer, blocking until one is
+ * available.
  * 
  * @return char the element in the front of the buffer or 0 if buffer empty.
  */
@@ -0,0 +1,230 @@
+/**
+ * @file channel.c
+ * @author Robert McKay
+ * @brief Implements named single producer, single consumer ring channels.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "channel.h"
+#include "boot2.h"
+#include "buffer.h"
+#include "io.h"
+#include "pmm.h"
+#include "cpu.h"
+
+/**
+ * @brief The channel table, a channel is in use once its buffer is set.
+ *
+ */
+channel_t channels[MAX_CHANNELS];
+
+/**
+ * @brief Protects the channel table while a channel is opened.
+ *
+ */
+spinlock_t channel_table_lock;
+
+/**
+ * @brief Copies bytes with rep movsb.
+ *
+ * @param destination Where to copy to.
+ * @param source Where to copy from.
+ * @param count Number of bytes.
+ */
+static inline void copy_bytes(void* destination, void* source, unsigned int count) {
+    asm volatile ("rep movsb"
+                  : "+D" (destination), "+S" (source), "+c" (count)
+                  : : "memory");
+}
+
+/**
+ * @brief Compares a channel name with a string.
+ *
+ * @param name The channel's name.
+ * @param other The string.
+ * @return int TRUE if they are equal.
+ */
+static int same_name(char* name, char* other) {
+    int i = 0;
+    while (i < CHANNEL_NAME_SIZE - 1 && name[i] == other[i] && name[i] != NULL_TERMINATOR) {
+        i++;
+    }
+    return i == CHANNEL_NAME_SIZE - 1 || name[i] == other[i];
+}
+
+/**
+ * @brief Wakes the other end if it waits on the channel. The caller has
+ * just moved head or tail.
+ *
+ * @param channel The channel.
+ * @param bit CHANNEL_READER_WAITING or CHANNEL_WRITER_WAITING.
+ * @param queue The queue the other end waits on.
+ */
+static void wake_end(channel_t* channel, unsigned int bit, queue_t* queue) {
+    /* the waiter sets its bit before checking head and tail again */
+    __sync_synchronize();
+    if ((channel->waiting & bit) == 0) {
+        return;
+    }
+    unsigned int flags = acquire_irqsave(&channel->lock);
+    pcb_t* pcb = NULL;
+    if (channel->waiting & bit) {
+        channel->waiting &= ~bit;
+        pcb = dequeue_process(queue);
+    }
+    release_irqrestore(&channel->lock, flags);
+    if (pcb != NULL) {
+        make_ready(pcb);
+    }
+}
+
+/**
+ * @brief Waits until the ring has data (reader) or room (writer).
+ *
+ * @param channel The channel.
+ * @param bit CHANNEL_READER_WAITING or CHANNEL_WRITER_WAITING.
+ * @param queue The queue to wait on.
+ */
+static void wait_end(channel_t* channel, unsigned int bit, queue_t* queue) {
+    unsigned int flags = acquire_irqsave(&channel->lock);
+    channel->waiting |= bit;
+    __sync_synchronize();
+
+    /* the other end may have moved before it could see the bit */
+    unsigned int used = channel->head - channel->tail;
+    if ((bit == CHANNEL_READER_WAITING && used != 0)
+        || (bit == CHANNEL_WRITER_WAITING && used != channel->size)) {
+        channel->waiting &= ~bit;
+        release_irqrestore(&channel->lock, flags);
+        return;
+    }
+    block_process((unsigned int)queue, (unsigned int)&channel->lock);
+    irq_restore(flags);
+}
+
+INIT void init_channels() {
+    init_lock(&channel_table_lock, "channel table");
+    register_lock_stat(&channel_table_lock.stat);
+    for (int i = 0; i < MAX_CHANNELS; i++) {
+        channels[i].buffer = NULL;
+    }
+}
+
+channel_t* open_channel(char* name, unsigned int pages) {
+    channel_t* channel = NULL;
+    unsigned int size = 1;
+    int i;
+
+    unsigned int flags = acquire_irqsave(&channel_table_lock);
+    for (i = 0; i < MAX_CHANNELS; i++) {
+        if (channels[i].buffer != NULL && same_name(channels[i].name, name)) {
+            release_irqrestore(&channel_table_lock, flags);
+            return &channels[i];
+        }
+        if (channels[i].buffer == NULL && channel == NULL) {
+            channel = &channels[i];
+        }
+    }
+    if (channel == NULL) {
+        release_irqrestore(&channel_table_lock, flags);
+        return NULL;
+    }
+
+    /* a power of two size lets head and tail wrap freely */
+    if (pages == 0) {
+        pages = CHANNEL_DEFAULT_PAGES;
+    }
+    if (pages > CHANNEL_MAX_PAGES) {
+        pages = CHANNEL_MAX_PAGES;
+    }
+    while (size < pages) {
+        size <<= 1;
+    }
+    unsigned int buffer = alloc_pages(size);
+    if (buffer == NULL) {
+        release_irqrestore(&channel_table_lock, flags);
+        return NULL;
+    }
+
+    for (i = 0; i < CHANNEL_NAME_SIZE - 1 && name[i] != NULL_TERMINATOR; i++) {
+        channel->name[i] = name[i];
+    }
+    channel->name[i] = NULL_TERMINATOR;
+    channel->head = 0;
+    channel->tail = 0;
+    channel->waiting = 0;
+    channel->size = size * PAGE_SIZE;
+    init_lock(&channel->lock, channel->name);
+    init_queue(&channel->readers, channel->name);
+    init_queue(&channel->writers, channel->name);
+    channel->buffer = (unsigned char*)buffer;
+    release_irqrestore(&channel_table_lock, flags);
+    return channel;
+}
+
+unsigned int channel_try_write(channel_t* channel, void* data, unsigned int length) {
+    unsigned int head = channel->head;
+    unsigned int room = channel->size - (head - channel->tail);
+    if (length > room) {
+        length = room;
+    }
+    if (length == 0) {
+        return 0;
+    }
+
+    /* copy up to the end of the buffer, then wrap */
+    unsigned int offset = head & (channel->size - 1);
+    unsigned int first = channel->size - offset;
+    if (first > length) {
+        first = length;
+    }
+    copy_bytes(channel->buffer + offset, data, first);
+    copy_bytes(channel->buffer, (unsigned char*)data + first, length - first);
+
+    /* publish the data (stores are not reordered with older stores) */
+    channel->head = head + length;
+    wake_end(channel, CHANNEL_READER_WAITING, &channel->readers);
+    return length;
+}
+
+unsigned int channel_try_read(channel_t* channel, void* data, unsigned int length) {
+    unsigned int tail = channel->tail;
+    unsigned int used = channel->head - tail;
+    if (length > used) {
+        length = used;
+    }
+    if (length == 0) {
+        return 0;
+    }
+
+    unsigned int offset = tail & (channel->size - 1);
+    unsigned int first = channel->size - offset;
+    if (first > length) {
+        first = length;
+    }
+    copy_bytes(data, channel->buffer + offset, first);
+    copy_bytes((unsigned char*)data + first, channel->buffer, length - first);
+
+    /* hand the room back to the producer */
+    channel->tail = tail + length;
+    wake_end(channel, CHANNEL_WRITER_WAITING, &channel->writers);
+    return length;
+}
+
+void channel_write(channel_t* channel, void* data, unsigned int length) {
+    unsigned int done = channel_try_write(channel, data, length);
+    while (done < length) {
+        wait_end(channel, CHANNEL_WRITER_WAITING, &channel->writers);
+        done += channel_try_write(channel, (unsigned char*)data + done, length - done);
+    }
+}
+
+void channel_read(channel_t* channel, void* data, unsigned int length) {
+    unsigned int done = channel_try_read(channel, data, length);
+    while (done < length) {
+        wait_end(channel, CHANNEL_READER_WAITING, &channel->readers);
+        done += channel_try_read(channel, (unsigned char*)data + done, length - done);
+    }
+}
@@ -0,0 +1,113 @@
+/**
+ * @file channel.h
+ * @author Robert McKay
+ * @brief Declares named single producer, single consumer ring channels.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include "cpu.h"
+#include "scheduler.h"
+
+/* channel table limits */
+#define MAX_CHANNELS 8
+#define CHANNEL_NAME_SIZE 16
+
+/* ring sizes in pages, rounded up to a power of two */
+#define CHANNEL_DEFAULT_PAGES 16
+#define CHANNEL_MAX_PAGES 256
+
+/* bits of waiting */
+#define CHANNEL_READER_WAITING 0x1
+#define CHANNEL_WRITER_WAITING 0x2
+
+/**
+ * @brief Structure for a channel. The producer only writes head and the
+ * consumer only writes tail, each on its own cache line, so the fast path
+ * takes no lock and makes no system call. The lock and wait queues are only
+ * used when the ring is empty or full.
+ *
+ */
+struct channel_s {
+    volatile unsigned int head;
+    unsigned char head_padding[CACHE_LINE - sizeof(unsigned int)];
+    volatile unsigned int tail;
+    unsigned char tail_padding[CACHE_LINE - sizeof(unsigned int)];
+    volatile unsigned int waiting;
+    unsigned char* buffer;
+    unsigned int size;
+    char name[CHANNEL_NAME_SIZE];
+    spinlock_t lock;
+    queue_t readers;
+    queue_t writers;
+} __attribute__ ((aligned (CACHE_LINE)));
+
+/**
+ * @brief Type definition for a channel.
+ *
+ */
+typedef struct channel_s channel_t;
+
+/**
+ * @brief Initializes the channel table.
+ *
+ */
+void init_channels();
+
+/**
+ * @brief Returns the channel with the given name, creating it with a ring
+ * of at least the given number of pages if it does not exist yet. Both
+ * ends open the channel by name.
+ *
+ * @param name Name of the channel, at most CHANNEL_NAME_SIZE - 1 characters.
+ * @param pages Size of the ring in pages if the channel is created, 0 for
+ * CHANNEL_DEFAULT_PAGES.
+ * @return channel_t* The channel, or NULL if the table or memory is full.
+ */
+channel_t* open_channel(char* name, unsigned int pages);
+
+/**
+ * @brief Copies as much of the data into the ring as fits without waiting.
+ * Only the producer may call it.
+ *
+ * @param channel The channel.
+ * @param data The data.
+ * @param length Length of the data in bytes.
+ * @return unsigned int Bytes written.
+ */
+unsigned int channel_try_write(channel_t* channel, void* data, unsigned int length);
+
+/**
+ * @brief Copies as much data out of the ring as is there, up to length,
+ * without waiting. Only the consumer may call it.
+ *
+ * @param channel The channel.
+ * @param data Receives the data.
+ * @param length Most bytes to read.
+ * @return unsigned int Bytes read.
+ */
+unsigned int channel_try_read(channel_t* channel, void* data, unsigned int length);
+
+/**
+ * @brief Writes all of the data, waiting while the ring is full.
+ *
+ * @param channel The channel.
+ * @param data The data.
+ * @param length Length of the data in bytes.
+ */
+void channel_write(channel_t* channel, void* data, unsigned int length);
+
+/**
+ * @brief Reads exactly length bytes, waiting while the ring is empty.
+ *
+ * @param channel The channel.
+ * @param data Receives the data.
+ * @param length Bytes to read.
+ */
+void channel_read(channel_t* channel, void* data, unsigned int length);
+
+#endif
@@ -0,0 +1,125 @@
+/**
+ * @file clock.c
+ * @author Robert McKay
+ * @brief Implements a monotonic clock from the timer tick and the TSC.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "clock.h"
+#include "cpu.h"
+#include "boot2.h"
+
+volatile unsigned long long tick_count CACHE_ALIGNED;
+unsigned int tick_us;
+unsigned int tsc_khz;
+
+/**
+ * @brief TSC value when the clock was initialized.
+ *
+ */
+unsigned long long tsc_base;
+
+/**
+ * @brief Nanoseconds per cycle as a fixed point number (NS_SHIFT bits).
+ *
+ */
+unsigned int ns_mult;
+
+INIT void init_clock(unsigned int interval) {
+    unsigned int regs[4];
+    tick_count = 0;
+    tsc_khz = 0;
+    cpuid(1, regs);
+    if (regs[3] & CPUID_EDX_TSC) {
+        tsc_khz = calibrate_tsc();
+    }
+    if (tsc_khz != 0) {
+        ns_mult = div_u64((unsigned long long)NS_PER_MS << NS_SHIFT, tsc_khz);
+        tsc_base = rdtsc();
+    }
+    unsigned int count = div_u64((unsigned long long)interval * PIT_FREQUENCY, US_PER_SEC);
+    if (interval < TICK_MIN_US) {
+        count = div_u64((unsigned long long)TICK_MIN_US * PIT_FREQUENCY, US_PER_SEC);
+    }
+    if (count > PIT_MAX_COUNT) {
+        count = PIT_MAX_COUNT;
+    }
+
+    /* the tick is whatever the counter can express */
+    tick_us = div_u64((unsigned long long)count * US_PER_SEC, PIT_FREQUENCY);
+    init_timer_dev(count);
+}
+
+INIT unsigned int calibrate_tsc() {
+    unsigned int count = PIT_FREQUENCY / 1000 * CALIBRATE_MS;
+    unsigned long long start;
+    unsigned long long end;
+
+    /* raise the channel 2 gate with the speaker disconnected */
+    outportb(PIT_GATE, (inportb(PIT_GATE) & ~PIT_SPEAKER) | PIT_GATE2);
+
+    /* channel 2, lobyte/hibyte, mode 0 (interrupt on terminal count) */
+    outportb(PIT_COMMAND, 0xb0);
+    outportb(PIT_CHANNEL2, count & 0xff);
+    outportb(PIT_CHANNEL2, count >> 8);
+
+    /* count cycles until the output goes high */
+    start = rdtsc();
+    while ((inportb(PIT_GATE) & PIT_OUT2) == 0);
+    end = rdtsc();
+
+    /* cycles * (PIT_FREQUENCY / count) / 1000 */
+    return div_u64((end - start) * PIT_FREQUENCY, count * 1000);
+}
+
+unsigned long long ticks() {
+    volatile unsigned int* words = (volatile unsigned int*)&tick_count;
+    unsigned int high;
+    unsigned int low;
+    do {
+        high = words[1];
+        low = words[0];
+    } while (high != words[1]);
+    return ((unsigned long long)high << 32) | low;
+}
+
+unsigned long long clock_ns() {
+    if (tsc_khz == 0) {
+        return ticks() * tick_us * 1000;
+    }
+    return cycles_to_ns(rdtsc() - tsc_base);
+}
+
+unsigned int uptime_ms() {
+    return div_u64(clock_ns(), NS_PER_MS);
+}
+
+void delay_us(unsigned int us) {
+    unsigned long long end = rdtsc() + div_u64((unsigned long long)tsc_khz * us, 1000);
+    while (rdtsc() < end) {
+        asm volatile ("pause");
+    }
+}
+
+unsigned long long cycles_to_ns(unsigned long long cycles) {
+    unsigned int high = cycles >> 32;
+    unsigned int low = cycles;
+    return (((unsigned long long)high * ns_mult) << (32 - NS_SHIFT))
+         + (((unsigned long long)low * ns_mult) >> NS_SHIFT);
+}
+
+unsigned long long div_u64(unsigned long long dividend, unsigned int divisor) {
+    unsigned int high = dividend >> 32;
+    unsigned int low = dividend;
+    unsigned int quotient_high = high / divisor;
+    unsigned int remainder = high % divisor;
+    unsigned int quotient_low;
+
+    /* remainder < divisor, so the second division cannot overflow */
+    asm ("divl %4"
+         : "=a" (quotient_low), "=d" (remainder)
+         : "a" (low), "d" (remainder), "rm" (divisor));
+    return ((unsigned long long)quotient_high << 32) | quotient_low;
+}
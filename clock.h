@@ -0,0 +1,118 @@
+/**
+ * @file clock.h
+ * @author Robert McKay
+ * @brief Declares the monotonic clock backed by the timer tick and the TSC.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef CLOCK_H
+#define CLOCK_H
+
+/* programmable interval timer ports */
+#define PIT_CHANNEL2 0x42
+#define PIT_COMMAND 0x43
+#define PIT_GATE 0x61
+
+/* bits of the channel 2 gate port */
+#define PIT_GATE2 0x01
+#define PIT_SPEAKER 0x02
+#define PIT_OUT2 0x20
+
+/* programmable interval timer constants */
+#define PIT_FREQUENCY 1193182
+#define PIT_MAX_COUNT 0xffff
+#define CALIBRATE_MS 50
+
+/* scheduling tick in micro seconds, and the shortest the PIT runs at */
+#define TICK_US 1000
+#define TICK_MIN_US 100
+
+/* fixed point shift used to convert cycles to nanoseconds */
+#define NS_SHIFT 22
+#define NS_PER_MS 1000000
+#define US_PER_SEC 1000000
+
+/**
+ * @brief Number of timer interrupts since the timer was started.
+ * Incremented by dispatch in boot2.S.
+ *
+ */
+extern volatile unsigned long long tick_count;
+
+/**
+ * @brief Length of one timer tick in micro seconds.
+ *
+ */
+extern unsigned int tick_us;
+
+/**
+ * @brief TSC frequency in kHz measured against PIT channel 2, 0 if no TSC.
+ *
+ */
+extern unsigned int tsc_khz;
+
+/**
+ * @brief Calibrates the TSC and starts the timer tick.
+ *
+ * @param interval The tick interval in micro seconds, at least TICK_MIN_US
+ * and at most what the 16 bit PIT counter allows (about 54.9 ms).
+ */
+void init_clock(unsigned int interval);
+
+/**
+ * @brief Measures the TSC frequency by timing a PIT channel 2 countdown.
+ *
+ * @return unsigned int The TSC frequency in kHz.
+ */
+unsigned int calibrate_tsc();
+
+/**
+ * @brief Reads the tick counter without tearing the 64 bit value.
+ *
+ * @return unsigned long long The number of ticks since boot.
+ */
+unsigned long long ticks();
+
+/**
+ * @brief Nanoseconds elapsed since the clock was initialized.
+ *
+ * @return unsigned long long Monotonic time in nanoseconds.
+ */
+unsigned long long clock_ns();
+
+/**
+ * @brief Milli seconds elapsed since the clock was initialized.
+ *
+ * @return unsigned int Uptime in milli seconds.
+ */
+unsigned int uptime_ms();
+
+/**
+ * @brief Busy waits for the given number of micro seconds using the TSC.
+ *
+ * @param us Micro seconds to wait.
+ */
+void delay_us(unsigned int us);
+
+/**
+ * @brief Converts a number of TSC cycles to nanoseconds.
+ *
+ * @param cycles The cycle count to convert.
+ * @return unsigned long long The equivalent number of nanoseconds.
+ */
+unsigned long long cycles_to_ns(unsigned long long cycles);
+
+/**
+ * @brief Divides a 64 bit value by a 32 bit value.
+ * The kernel is not linked with libgcc, so 64 bit division must go through
+ * this helper.
+ *
+ * @param dividend The value to divide.
+ * @param divisor The value to divide by.
+ * @return unsigned long long The quotient.
+ */
+unsigned long long div_u64(unsigned long long dividend, unsigned int divisor);
+
+#endif
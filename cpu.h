@@ -0,0 +1,224 @@
+/**
+ * @file cpu.h
+ * @author Robert McKay
+ * @brief Inline wrappers for processor instructions used by the kernel.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef CPU_H
+#define CPU_H
+
+/* size of a cache line in bytes */
+#define CACHE_LINE 64
+
+/* code placement (see kernel.ld): HOT functions are grouped with the
+   interrupt and switch paths of boot2.S, INIT functions run only before the
+   first process and their pages are freed by free_init_text */
+#define HOT __attribute__ ((hot, section (".text.hot")))
+#define INIT __attribute__ ((cold, section (".init.text")))
+
+/* places a variable user code reads with the code (see kernel.ld), the
+   kernel's other data is not mapped for user mode */
+#define USER_READ __attribute__ ((section (".user.data")))
+
+/* starts a variable or type on its own cache line */
+#define CACHE_ALIGNED __attribute__ ((aligned (CACHE_LINE)))
+
+/* cpuid feature bits (leaf 1, edx) */
+#define CPUID_EDX_PSE (1 << 3)
+#define CPUID_EDX_TSC (1 << 4)
+#define CPUID_EDX_MSR (1 << 5)
+#define CPUID_EDX_APIC (1 << 9)
+#define CPUID_EDX_SEP (1 << 11)
+#define CPUID_EDX_PGE (1 << 13)
+#define CPUID_EDX_FXSR (1 << 24)
+#define CPUID_EDX_SSE (1 << 25)
+
+/* cpuid feature bits (leaf 1, ecx) */
+#define CPUID_ECX_TSC_DEADLINE (1 << 24)
+
+/* control register bits */
+#define CR0_MP 0x2
+#define CR0_EM 0x4
+#define CR0_TS 0x8
+#define CR0_NE 0x20
+#define CR0_WP 0x10000
+#define CR0_PG 0x80000000
+#define CR4_PSE 0x10
+#define CR4_PGE 0x80
+#define CR4_OSFXSR 0x200
+#define CR4_OSXMMEXCPT 0x400
+
+/* interrupt enable flag in eflags */
+#define EFLAGS_IF 0x200
+
+/**
+ * @brief Reads the time stamp counter.
+ *
+ * @return unsigned long long The number of cycles since reset.
+ */
+static inline unsigned long long rdtsc() {
+    unsigned long long tsc;
+    asm volatile ("rdtsc" : "=A" (tsc));
+    return tsc;
+}
+
+/**
+ * @brief Executes the cpuid instruction for the given leaf.
+ *
+ * @param leaf The value loaded into eax.
+ * @param regs Array receiving eax, ebx, ecx and edx in that order.
+ */
+static inline void cpuid(unsigned int leaf, unsigned int regs[4]) {
+    asm volatile ("cpuid"
+                  : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+                  : "a" (leaf), "c" (0));
+}
+
+/**
+ * @brief Reads a model specific register.
+ *
+ * @param msr The register number.
+ * @return unsigned long long The register contents.
+ */
+static inline unsigned long long rdmsr(unsigned int msr) {
+    unsigned long long value;
+    asm volatile ("rdmsr" : "=A" (value) : "c" (msr));
+    return value;
+}
+
+/**
+ * @brief Writes a model specific register.
+ *
+ * @param msr The register number.
+ * @param value The value to write.
+ */
+static inline void wrmsr(unsigned int msr, unsigned long long value) {
+    asm volatile ("wrmsr" : : "c" (msr), "A" (value));
+}
+
+/**
+ * @brief Reads control register 0.
+ *
+ * @return unsigned int The register contents.
+ */
+static inline unsigned int read_cr0() {
+    unsigned int value;
+    asm volatile ("mov %%cr0, %0" : "=r" (value));
+    return value;
+}
+
+/**
+ * @brief Writes control register 0.
+ *
+ * @param value The value to write.
+ */
+static inline void write_cr0(unsigned int value) {
+    asm volatile ("mov %0, %%cr0" : : "r" (value) : "memory");
+}
+
+/**
+ * @brief Reads control register 3 (the page directory base).
+ *
+ * @return unsigned int The register contents.
+ */
+static inline unsigned int read_cr3() {
+    unsigned int value;
+    asm volatile ("mov %%cr3, %0" : "=r" (value));
+    return value;
+}
+
+/**
+ * @brief Writes control register 3, flushing non-global TLB entries.
+ *
+ * @param value The value to write.
+ */
+static inline void write_cr3(unsigned int value) {
+    asm volatile ("mov %0, %%cr3" : : "r" (value) : "memory");
+}
+
+/**
+ * @brief Reads control register 4.
+ *
+ * @return unsigned int The register contents.
+ */
+static inline unsigned int read_cr4() {
+    unsigned int value;
+    asm volatile ("mov %%cr4, %0" : "=r" (value));
+    return value;
+}
+
+/**
+ * @brief Writes control register 4.
+ *
+ * @param value The value to write.
+ */
+static inline void write_cr4(unsigned int value) {
+    asm volatile ("mov %0, %%cr4" : : "r" (value) : "memory");
+}
+
+/**
+ * @brief Invalidates the calling processor's TLB entry for an address.
+ *
+ * @param address The virtual address.
+ */
+static inline void invlpg(unsigned int address) {
+    asm volatile ("invlpg (%0)" : : "r" (address) : "memory");
+}
+
+/**
+ * @brief Reads a double word from an I/O port.
+ *
+ * @param port The port.
+ * @return unsigned int The value read.
+ */
+static inline unsigned int inportl(unsigned short port) {
+    unsigned int value;
+    asm volatile ("inl %1, %0" : "=a" (value) : "Nd" (port));
+    return value;
+}
+
+/**
+ * @brief Writes a double word to an I/O port.
+ *
+ * @param port The port.
+ * @param value The value to write.
+ */
+static inline void outportl(unsigned short port, unsigned int value) {
+    asm volatile ("outl %0, %1" : : "a" (value), "Nd" (port));
+}
+
+/**
+ * @brief Reads words from an I/O port into memory with rep insw.
+ *
+ * @param port The port.
+ * @param buffer Where to store the words.
+ * @param count Number of words.
+ */
+static inline void inportsw(unsigned short port, void* buffer, unsigned int count) {
+    asm volatile ("rep insw" : "+D" (buffer), "+c" (count) : "d" (port) : "memory");
+}
+
+/**
+ * @brief Writes words from memory to an I/O port with rep outsw.
+ *
+ * @param port The port.
+ * @param buffer The words to write.
+ * @param count Number of words.
+ */
+static inline void outportsw(unsigned short port, void* buffer, unsigned int count) {
+    asm volatile ("rep outsw" : "+S" (buffer), "+c" (count) : "d" (port) : "memory");
+}
+
+/**
+ * @brief Loads the task register.
+ *
+ * @param selector Selector of the TSS descriptor.
+ */
+static inline void ltr(unsigned short selector) {
+    asm volatile ("ltr %0" : : "r" (selector));
+}
+
+#endif
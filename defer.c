@@ -0,0 +1,93 @@
+/**
+ * @file defer.c
+ * @author Robert McKay
+ * @brief Implements deferred interrupt work (bottom halves).
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "defer.h"
+#include "buffer.h"
+#include "cpu.h"
+#include "io.h"
+#include "smp.h"
+
+irq_stat_t irq_stats[BH_COUNT];
+
+/**
+ * @brief Functions run for each bottom half.
+ *
+ */
+void (*bh_handlers[BH_COUNT])();
+
+void register_bottom_half(unsigned int bh, void (*handler)()) {
+    bh_handlers[bh] = handler;
+}
+
+HOT void raise_bottom_half(unsigned int bh) {
+    this_cpu()->bh_pending |= 1 << bh;
+}
+
+HOT void run_bottom_halves() {
+    cpu_t* cpu = this_cpu();
+    unsigned int pending;
+
+    /* an interrupt that arrived during a bottom half leaves its work to it */
+    if (cpu->bh_active == TRUE) {
+        return;
+    }
+    cpu->bh_active = TRUE;
+
+    /* interrupts are off whenever pending is read or cleared */
+    while (cpu->bh_pending != 0) {
+        pending = cpu->bh_pending;
+        cpu->bh_pending = 0;
+        asm volatile ("sti");
+        for (unsigned int bh = 0; bh < BH_COUNT; bh++) {
+            if ((pending & (1 << bh)) && bh_handlers[bh] != NULL) {
+                bh_handlers[bh]();
+            }
+        }
+        asm volatile ("cli");
+    }
+    cpu->bh_active = FALSE;
+}
+
+HOT void irq_off_end(unsigned int bh, unsigned long long start) {
+    unsigned int cycles = rdtsc() - start;
+    irq_stat_t* stat = &irq_stats[bh];
+    stat->count++;
+    stat->cycles += cycles;
+    if (cycles > stat->max) {
+        stat->max = cycles;
+    }
+}
+
+int irq_ring_put(irq_ring_t* ring, unsigned char value) {
+    unsigned int tail = ring->tail;
+    if (tail - ring->head == IRQ_RING_SIZE) {
+        return FALSE;
+    }
+    ring->data[tail % IRQ_RING_SIZE] = value;
+    asm volatile ("" : : : "memory");
+    ring->tail = tail + 1;
+    return TRUE;
+}
+
+int irq_ring_get(irq_ring_t* ring, unsigned char* value) {
+    unsigned int head = ring->head;
+    if (head == ring->tail) {
+        return FALSE;
+    }
+    *value = ring->data[head % IRQ_RING_SIZE];
+    asm volatile ("" : : : "memory");
+    ring->head = head + 1;
+    return TRUE;
+}
+
+void default_bottom_half() {
+    char message[] = "Default handler triggered";
+    println(message);
+    new_line();
+}
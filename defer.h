@@ -0,0 +1,120 @@
+/**
+ * @file defer.h
+ * @author Robert McKay
+ * @brief Declares deferred interrupt work (bottom halves).
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef DEFER_H
+#define DEFER_H
+
+/* bottom half numbers, also the index of their interrupt statistics */
+#define BH_KEYBOARD 0
+#define BH_DEFAULT 1
+#define BH_ATA 2
+#define BH_FDC 3
+#define BH_COUNT 4
+
+/* entries in a raw interrupt ring (power of two) */
+#define IRQ_RING_SIZE 64
+
+/**
+ * @brief Single producer, single consumer ring of raw interrupt data.
+ * The interrupt handler only advances tail, its bottom half only head.
+ *
+ */
+struct irq_ring_s {
+    volatile unsigned int head;
+    volatile unsigned int tail;
+    unsigned char data[IRQ_RING_SIZE];
+};
+
+/**
+ * @brief Type definition for an interrupt ring.
+ *
+ */
+typedef struct irq_ring_s irq_ring_t;
+
+/**
+ * @brief Time an interrupt handler ran with interrupts disabled.
+ *
+ */
+struct irq_stat_s {
+    unsigned int count;
+    unsigned int max;
+    unsigned long long cycles;
+};
+
+/**
+ * @brief Type definition for interrupt statistics.
+ *
+ */
+typedef struct irq_stat_s irq_stat_t;
+
+/**
+ * @brief Cycles spent with interrupts disabled, indexed by bottom half.
+ *
+ */
+extern irq_stat_t irq_stats[BH_COUNT];
+
+/**
+ * @brief Registers the function run for a bottom half.
+ *
+ * @param bh The bottom half number.
+ * @param handler Function run with interrupts enabled.
+ */
+void register_bottom_half(unsigned int bh, void (*handler)());
+
+/**
+ * @brief Marks a bottom half pending on the calling processor.
+ * Called by interrupt handlers with interrupts disabled.
+ *
+ * @param bh The bottom half number.
+ */
+void raise_bottom_half(unsigned int bh);
+
+/**
+ * @brief Runs the pending bottom halves of the calling processor with
+ * interrupts enabled. Called with interrupts disabled on the way out of an
+ * interrupt and returns with them disabled. Does nothing if the interrupt
+ * arrived while bottom halves were already running.
+ *
+ */
+void run_bottom_halves();
+
+/**
+ * @brief Records how long an interrupt handler ran with interrupts disabled.
+ * Called from the interrupt handlers in boot2.S before they send EOI.
+ *
+ * @param bh Bottom half the interrupt belongs to.
+ * @param start TSC value on entry to the handler.
+ */
+void irq_off_end(unsigned int bh, unsigned long long start);
+
+/**
+ * @brief Adds a byte to an interrupt ring.
+ *
+ * @param ring The ring to add to.
+ * @param value The byte to add.
+ * @return int TRUE if the byte was added, FALSE if the ring is full.
+ */
+int irq_ring_put(irq_ring_t* ring, unsigned char value);
+
+/**
+ * @brief Removes the oldest byte from an interrupt ring.
+ *
+ * @param ring The ring to remove from.
+ * @param value Receives the byte.
+ * @return int TRUE if a byte was removed, FALSE if the ring is empty.
+ */
+int irq_ring_get(irq_ring_t* ring, unsigned char* value);
+
+/**
+ * @brief Bottom half of the default interrupt handler, prints its message.
+ *
+ */
+void default_bottom_half();
+
+#endif
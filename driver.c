@@ -15,32 +15,109 @@
 #include "buffer.h"
 #include "process.h"
 #include "scheduler.h"
+#include "clock.h"
+#include "apic.h"
+#include "bench.h"
+#include "smp.h"
+#include "defer.h"
+#include "pmm.h"
+#include "paging.h"
+#include "syscall.h"
+#include "channel.h"
+#include "pci.h"
+#include "ata.h"
+#include "fat.h"
+#include "fdc.h"
+#include "bcache.h"
+#include "elf.h"
 
 int main() {
     
     /* local variables */
     int retval;
-    int num_processes = 7; // controls how many processes get created
+    pcb_t* pcb;
     char init[] = "initializing processes...";
     char running[] = "running processes...";
     char failure[] = "failed to create process";
     char success[] = "process created";
-    unsigned int processes[] = {(unsigned int)p_idle, (unsigned int)p_keyboard,
-                                (unsigned int)p1, (unsigned int)p2, (unsigned int)p3, 
-                                (unsigned int)p4, (unsigned int)p5};
+    char rejected[] = "real-time admission failed";
+    char online[] = " processors online";
+    char memory[] = " KB of memory";
+    char disk[] = " KB disk";
+    char count_buf[11];
+#ifdef BENCH
+    int num_processes = 1; // controls how many processes get created
+    unsigned int processes[] = {(unsigned int)p_bench};
+    unsigned int stack_sizes[] = {DEFAULT_STACK_SIZE};
+    int user_mode[] = {FALSE};
+    unsigned int periods[] = {0};
+    unsigned int budgets[] = {0};
+    int output_rows = 0; // rows the processes print on
+#else
+    int num_processes = 3; // controls how many processes get created
+    unsigned int processes[] = {(unsigned int)p_keyboard, (unsigned int)p_loader,
+                                (unsigned int)p_worker};
+    unsigned int stack_sizes[] = {DEFAULT_STACK_SIZE, DEFAULT_STACK_SIZE, SMALL_STACK_SIZE};
+    int user_mode[] = {FALSE, FALSE, TRUE};
+    unsigned int periods[] = {0, 0, REFRESH_PERIOD_US};
+    unsigned int budgets[] = {0, 0, REFRESH_BUDGET_US};
+    int output_rows = WORKER_COUNT + 1; // rows the processes print on
+#endif
 
     /* initialzation */
+    init_bsp();
+    init_pmm();
+    init_processes();
     init_screen();
     initIDT();
     setupPIC();
-    init_timer_dev(10);
+    init_clock(TICK_US);
+    init_apic();
+    init_paging();
     init_queues();
+    init_buffer();
+    init_channels();
+    init_pci();
+    if (init_ata() == TRUE) {
+        init_bcache();
+    }
+    init_fdc();
+    init_fat();
+    init_elf();
+    register_bottom_half(BH_KEYBOARD, kbd_bottom_half);
+    register_bottom_half(BH_DEFAULT, default_bottom_half);
+    init_smp();
+    convert_num(cpus_online, count_buf);
+    println(count_buf);
+    println(online);
+    new_line();
+    convert_num(total_pages * (PAGE_SIZE / 1024), count_buf);
+    println(count_buf);
+    println(memory);
+    new_line();
+    if (ata_sectors != 0) {
+        convert_num(ata_sectors / (1024 / ATA_SECTOR_SIZE), count_buf);
+        println(count_buf);
+        println(disk);
+        new_line();
+    }
     println(init);
     new_line();
 
     /* create processes */
     for (int i = 0; i < num_processes; i++) {
-        if (create_process(processes[i]) == EXIT_SUCCESS) {
+        if (user_mode[i]) {
+            pcb = new_user_process(processes[i], stack_sizes[i]);
+        } else {
+            pcb = new_process(processes[i], stack_sizes[i]);
+        }
+        if (pcb != NULL && periods[i] != 0
+            && set_realtime(pcb, periods[i], budgets[i]) == FALSE) {
+            println(rejected);
+            new_line();
+        }
+        retval = start_process(pcb);
+        if (retval == EXIT_SUCCESS) {
             println(success);
         } else {
             println(failure);
@@ -52,18 +129,20 @@ int main() {
     new_line();
     println(running);
     new_line();
-    start_row = current_row + num_processes - 2; // set row for keyboard io
+    start_row = current_row + output_rows; // set row for keyboard io
+    free_init_text(); // every processor is running
     go();
 }
 
 void p_idle() {
-    asm volatile ("sti");
-    while (TRUE);
+    while (TRUE) {
+        asm volatile ("sti; hlt");
+    }
 }
 
 void p_keyboard() {
     char value;
-    char end = NULL_TERMINATOR;
+    char text[2] = {0, NULL_TERMINATOR};
     while(TRUE) {
         value = dequeue_char();
         if (value == NEWLINE) {
@@ -73,82 +152,39 @@ void p_keyboard() {
         } else if (value == TAB) {
             tab_over();
         } else {
-            println(&value);
+            text[0] = value;
+            println(text);
         }
     }
 }
 
-void p1() {
-    unsigned int count = 0;
-    char message[] = "process 1: ";
-    int row = current_row; // current_row defined in io.c
-    int column = string_size(message) + 2;
-    char count_buf[5];
-    println(message);
-    new_line();
-    while(TRUE) {
-        convert_num(count % 500, count_buf);
-        k_print(count_buf, string_size(count_buf), column, row);
-        count++;
-    }
-}
+void p_loader() {
+    char failure[] = "failed to load " DEMO_PROGRAM;
 
-void p2() {
-    unsigned int count = 0;
-    char message[] = "process 2: ";
-    int row = current_row; // current_row defined in io.c
-    int column = string_size(message) + 2;
-    char count_buf[5];
-    println(message);
-    new_line();
-    while(TRUE) {
-        convert_num(count % 500, count_buf);
-        k_print(count_buf, string_size(count_buf), column, row);
-        count++;
+    /* the program prints its own row, the keyboard rows start below it */
+    if (spawn(DEMO_PROGRAM) == EXIT_SUCCESS) {
+        wait_process(NULL);
+    } else {
+        println(failure);
+        new_line();
     }
 }
 
-void p3() {
+void p_worker() {
     unsigned int count = 0;
-    char message[] = "process 3: ";
-    int row = current_row; // current_row defined in io.c
-    int column = string_size(message) + 2;
-    char count_buf[5];
-    println(message);
-    new_line();
-    while(TRUE) {
-        convert_num(count % 500, count_buf);
-        k_print(count_buf, string_size(count_buf), column, row);
-        count++;
-    }
-}
+    char message[] = "process 1: ";
 
-void p4() {
-    unsigned int count = 0;
-    char message[] = "process 4: ";
-    int row = current_row; // current_row defined in io.c
-    int column = string_size(message) + 2;
-    char count_buf[5];
-    println(message);
-    new_line();
-    while(TRUE) {
-        convert_num(count % 500, count_buf);
-        k_print(count_buf, string_size(count_buf), column, row);
-        count++;
+    /* each child forks the next, the parent stops forking */
+    while (message[8] < '0' + WORKER_COUNT && sys_fork() == 0) {
+        message[8]++;
     }
-}
-
-void p5() {
-    unsigned int count = 0;
-    char message[] = "process 5: ";
-    int row = current_row; // current_row defined in io.c
+    int row = sys_println(message);
     int column = string_size(message) + 2;
     char count_buf[5];
-    println(message);
-    new_line();
     while(TRUE) {
         convert_num(count % 500, count_buf);
-        k_print(count_buf, string_size(count_buf), column, row);
+        sys_print(count_buf, string_size(count_buf), column, row);
         count++;
+        sys_wait_period();
     }
-}
\ No newline at end of file
+}
@@ -10,46 +10,42 @@
 #ifndef DRIVER_H
 #define DRIVER_H
 
-/**
- * @brief First process added to queue. Enables interrupts.
- * 
- */
-void p_idle();
+/* the example processes refresh their counters at 50 Hz as real-time
+   processes, in micro seconds */
+#define REFRESH_PERIOD_US 20000
+#define REFRESH_BUDGET_US 2000
 
-/**
- * @brief Process for keyboard i/o.
- * 
- */
-void p_keyboard();
+/* processes p_worker ends up as, counting itself */
+#define WORKER_COUNT 5
 
-/**
- * @brief Example process.
- * 
- */
-void p1();
+/* program p_loader runs from the floppy */
+#define DEMO_PROGRAM "/hello.elf"
 
 /**
- * @brief Example process.
+ * @brief Idle process of each processor. Runs when its ready queue is empty
+ * and halts until the next interrupt.
  * 
  */
-void p2();
+void p_idle();
 
 /**
- * @brief Example process.
+ * @brief Process for keyboard i/o.
  * 
  */
-void p3();
+void p_keyboard();
 
 /**
- * @brief Example process.
+ * @brief Loads DEMO_PROGRAM from the floppy and waits for it to exit.
+ * Reports a program that fails to load.
  * 
  */
-void p4();
+void p_loader();
 
 /**
- * @brief Example process.
+ * @brief Example user mode process, forks WORKER_COUNT - 1 copies of
+ * itself, then each prints through system calls once a period.
  * 
  */
-void p5();
+void p_worker();
 
 #endif
\ No newline at end of file
@@ -0,0 +1,362 @@
+/**
+ * @file elf.c
+ * @author Robert McKay
+ * @brief Implements the ELF32 program loader.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "elf.h"
+#include "buffer.h"
+#include "cpu.h"
+#include "io.h"
+#include "pmm.h"
+#include "scheduler.h"
+
+unsigned int elf_faults;
+unsigned int elf_pages_read;
+unsigned int elf_shared_hits;
+
+/**
+ * @brief The image cache.
+ *
+ */
+image_t images[ELF_MAX_IMAGES];
+unsigned int image_count;
+
+/**
+ * @brief Protects the image cache while an image is found or loaded.
+ *
+ */
+mutex_t elf_mutex;
+
+/**
+ * @brief Program headers of the file being loaded, kept off the small
+ * kernel stacks. Used with elf_mutex held.
+ *
+ */
+elf_phdr_t elf_headers[ELF_MAX_HEADERS];
+
+/**
+ * @brief Compares two paths.
+ *
+ * @param a First path.
+ * @param b Second path.
+ * @return int TRUE if they are equal.
+ */
+static int same_path(char* a, char* b) {
+    while (*a != NULL_TERMINATOR && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+/**
+ * @brief Finds the segment holding an address.
+ *
+ * @param image The image.
+ * @param address The address.
+ * @return segment_t* The segment, NULL if none holds it.
+ */
+static segment_t* find_segment(image_t* image, unsigned int address) {
+    for (unsigned int i = 0; i < image->segment_count; i++) {
+        segment_t* segment = &image->segments[i];
+        if (address >= segment->start && address < segment->end) {
+            return segment;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Frees an image's shared pages and closes its file.
+ *
+ * @param image The image.
+ */
+static void free_image(image_t* image) {
+    for (unsigned int i = 0; i < image->segment_count; i++) {
+        segment_t* segment = &image->segments[i];
+        if (segment->pages == NULL) {
+            continue;
+        }
+        for (unsigned int j = 0; j < (segment->end - segment->start) / PAGE_SIZE; j++) {
+            if (segment->pages[j] != NULL) {
+                free_page(segment->pages[j]);
+            }
+        }
+        free_page((unsigned int)segment->pages);
+    }
+    fat_close(image->fd);
+    image->path[0] = NULL_TERMINATOR;
+}
+
+/**
+ * @brief Adds a loadable segment to an image.
+ *
+ * @param image The image.
+ * @param header The segment's program header.
+ * @return int FALSE if the segment is invalid or out of memory.
+ */
+static int add_segment(image_t* image, elf_phdr_t* header) {
+    unsigned int end = header->vaddr + header->memsz;
+    if (image->segment_count == ELF_MAX_SEGMENTS || header->filesz > header->memsz
+        || header->vaddr < USER_BASE || end > USER_STACK_GUARD || end < header->vaddr) {
+        return FALSE;
+    }
+    segment_t* segment = &image->segments[image->segment_count];
+    segment->start = header->vaddr & PAGE_FRAME;
+    segment->end = (end + PAGE_SIZE - 1) & PAGE_FRAME;
+    segment->vaddr = header->vaddr;
+    segment->offset = header->offset;
+    segment->filesz = header->filesz;
+    segment->writable = (header->flags & ELF_PF_W) != 0;
+    segment->pages = NULL;
+
+    /* a page belongs to one segment, so it is either private or shared */
+    for (unsigned int i = 0; i < image->segment_count; i++) {
+        if (segment->start < image->segments[i].end && image->segments[i].start < segment->end) {
+            return FALSE;
+        }
+    }
+    if (segment->writable == FALSE) {
+        if ((segment->end - segment->start) / PAGE_SIZE > ELF_SEGMENT_PAGES) {
+            return FALSE;
+        }
+        segment->pages = (unsigned int*)alloc_page();
+        if (segment->pages == NULL) {
+            return FALSE;
+        }
+        for (int i = 0; i < ELF_SEGMENT_PAGES; i++) {
+            segment->pages[i] = NULL;
+        }
+    }
+    image->segment_count++;
+    return TRUE;
+}
+
+/**
+ * @brief Reads a program's headers into an image. Called with elf_mutex
+ * held.
+ *
+ * @param image The image.
+ * @param path Path of the file.
+ * @return int FALSE if the file is not a valid program.
+ */
+static int load_image(image_t* image, char* path) {
+    elf_header_t header;
+    elf_phdr_t* headers = elf_headers;
+
+    image->fd = fat_open(path);
+    image->segment_count = 0;
+    if (image->fd == FAT_ERROR) {
+        return FALSE;
+    }
+    if (fat_read(image->fd, &header, sizeof(header)) != sizeof(header)
+        || header.magic != ELF_MAGIC || header.class != ELF_CLASS_32
+        || header.data != ELF_DATA_LSB || header.type != ELF_TYPE_EXEC
+        || header.machine != ELF_MACHINE_386 || header.phentsize != sizeof(elf_phdr_t)
+        || header.phnum > ELF_MAX_HEADERS) {
+        free_image(image);
+        return FALSE;
+    }
+    int size = header.phnum * sizeof(elf_phdr_t);
+    if (fat_seek(image->fd, header.phoff) == FAT_ERROR
+        || fat_read(image->fd, headers, size) != size) {
+        free_image(image);
+        return FALSE;
+    }
+    for (unsigned int i = 0; i < header.phnum; i++) {
+        if (headers[i].type == ELF_PT_LOAD && headers[i].memsz != 0
+            && add_segment(image, &headers[i]) == FALSE) {
+            free_image(image);
+            return FALSE;
+        }
+    }
+    image->entry = header.entry;
+    if (find_segment(image, image->entry) == NULL) {
+        free_image(image);
+        return FALSE;
+    }
+
+    unsigned int i = 0;
+    while (path[i] != NULL_TERMINATOR) {
+        image->path[i] = path[i];
+        i++;
+    }
+    image->path[i] = NULL_TERMINATOR;
+    image->instances = 0;
+    image->shared_pages = 0;
+    return TRUE;
+}
+
+/**
+ * @brief Finds a program in the image cache, loading it if it is not
+ * there. Called with elf_mutex held.
+ *
+ * @param path Path of the file.
+ * @return image_t* The image, NULL if the file is not a valid program or
+ * every slot holds a running program.
+ */
+static image_t* get_image(char* path) {
+    image_t* image = NULL;
+    for (unsigned int i = 0; i < image_count; i++) {
+        if (same_path(images[i].path, path)) {
+            return &images[i];
+        }
+    }
+
+    /* use a free slot, or evict a program nothing runs */
+    if (image_count < ELF_MAX_IMAGES) {
+        image = &images[image_count];
+        init_mutex(&image->lock, "image");
+    } else {
+        for (unsigned int i = 0; i < image_count && image == NULL; i++) {
+            if (images[i].path[0] == NULL_TERMINATOR) {
+                image = &images[i];
+            } else if (images[i].instances == 0) {
+                free_image(&images[i]);
+                image = &images[i];
+            }
+        }
+    }
+    if (image == NULL || load_image(image, path) == FALSE) {
+        return NULL;
+    }
+    if (image == &images[image_count]) {
+        image_count++;
+    }
+    return image;
+}
+
+/**
+ * @brief Allocates a page and fills it with the part of a segment's file
+ * data it holds, the rest is zero. Called with the image's lock held.
+ *
+ * @param image The image.
+ * @param segment The segment.
+ * @param address Virtual address of the page.
+ * @return unsigned int The page, NULL on a read error or out of memory.
+ */
+static unsigned int read_page(image_t* image, segment_t* segment, unsigned int address) {
+    unsigned int* page = (unsigned int*)alloc_page();
+    if (page == NULL) {
+        return NULL;
+    }
+    for (unsigned int i = 0; i < PAGE_SIZE / sizeof(unsigned int); i++) {
+        page[i] = 0;
+    }
+
+    unsigned int low = address > segment->vaddr ? address : segment->vaddr;
+    unsigned int high = address + PAGE_SIZE;
+    if (high > segment->vaddr + segment->filesz) {
+        high = segment->vaddr + segment->filesz;
+    }
+    if (low < high) {
+        int length = high - low;
+        if (fat_seek(image->fd, segment->offset + (low - segment->vaddr)) == FAT_ERROR
+            || fat_read(image->fd, (unsigned char*)page + (low - address), length) != length) {
+            free_page((unsigned int)page);
+            return NULL;
+        }
+        elf_pages_read++;
+    }
+    return (unsigned int)page;
+}
+
+INIT void init_elf() {
+    init_mutex(&elf_mutex, "elf");
+    register_lock_stat(&elf_mutex.stat);
+    image_count = 0;
+}
+
+pcb_t* new_elf_process(char* path) {
+    if (kernel_directory == NULL || string_size(path) >= FAT_PATH_MAX) {
+        return NULL;
+    }
+    mutex_lock(&elf_mutex);
+    image_t* image = get_image(path);
+    if (image != NULL) {
+        __sync_fetch_and_add(&image->instances, 1);
+    }
+    mutex_unlock(&elf_mutex);
+    if (image == NULL) {
+        return NULL;
+    }
+
+    pcb_t* pcb = new_user_process(image->entry, DEFAULT_STACK_SIZE);
+    if (pcb == NULL) {
+        __sync_fetch_and_sub(&image->instances, 1);
+        return NULL;
+    }
+    pcb->image = image;
+    return pcb;
+}
+
+int spawn(char* path) {
+    return start_process(new_elf_process(path));
+}
+
+int elf_fault(pcb_t* pcb, unsigned int address) {
+    image_t* image = pcb->image;
+    segment_t* segment;
+    unsigned int page;
+    unsigned int flags = PAGE_USER;
+
+    if (image == NULL || (segment = find_segment(image, address)) == NULL) {
+        return FALSE;
+    }
+    address &= PAGE_FRAME;
+
+    mutex_lock(&image->lock);
+    if (segment->writable) {
+        page = read_page(image, segment, address);
+        flags |= PAGE_WRITE;
+    } else {
+        unsigned int index = (address - segment->start) / PAGE_SIZE;
+        page = segment->pages[index];
+        if (page != NULL) {
+            elf_shared_hits++;
+        } else {
+            page = read_page(image, segment, address);
+            segment->pages[index] = page;
+            image->shared_pages += page != NULL;
+        }
+        flags |= PAGE_SHARED;
+    }
+    if (page != NULL && map_page(pcb->directory, address, page, flags) == FALSE) {
+        if (segment->writable) {
+            free_page(page);
+        }
+        page = NULL;
+    }
+    elf_faults += page != NULL;
+    mutex_unlock(&image->lock);
+    return page != NULL;
+}
+
+unsigned int elf_page_flags(pcb_t* pcb, unsigned int address) {
+    segment_t* segment;
+    if (pcb == NULL || pcb->image == NULL || (segment = find_segment(pcb->image, address)) == NULL) {
+        return 0;
+    }
+    return segment->writable ? PAGE_USER | PAGE_WRITE : PAGE_USER;
+}
+
+void release_address_space(pcb_t* pcb) {
+    if (pcb->directory == NULL) {
+        return;
+    }
+
+    /* the exiting process's directory may still be loaded here */
+    if (read_cr3() == (unsigned int)pcb->directory) {
+        load_directory(NULL);
+    }
+    free_directory(pcb->directory);
+    pcb->directory = NULL;
+    if (pcb->image != NULL) {
+        __sync_fetch_and_sub(&pcb->image->instances, 1);
+        pcb->image = NULL;
+    }
+}
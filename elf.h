@@ -0,0 +1,198 @@
+/**
+ * @file elf.h
+ * @author Robert McKay
+ * @brief Declares the ELF32 program loader. Processes are created from
+ * files on the floppy, in their own user address space, with segments
+ * mapped lazily on page fault and read-only pages shared between every
+ * instance of a program.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef ELF_H
+#define ELF_H
+
+#include "fat.h"
+#include "mutex.h"
+#include "paging.h"
+#include "process.h"
+
+/* identification of a little endian, 32 bit, i386 executable */
+#define ELF_MAGIC 0x464c457f
+#define ELF_CLASS_32 1
+#define ELF_DATA_LSB 1
+#define ELF_TYPE_EXEC 2
+#define ELF_MACHINE_386 3
+
+/* program header type of a loadable segment and its flags */
+#define ELF_PT_LOAD 1
+#define ELF_PF_W 0x2
+
+/* limits */
+#define ELF_MAX_IMAGES 8
+#define ELF_MAX_SEGMENTS 8
+#define ELF_MAX_HEADERS 16
+#define ELF_SEGMENT_PAGES (PAGE_ENTRIES)
+
+/**
+ * @brief ELF file header.
+ *
+ */
+struct elf_header_s {
+    unsigned int magic;
+    unsigned char class;
+    unsigned char data;
+    unsigned char ident_version;
+    unsigned char pad[9];
+    unsigned short type;
+    unsigned short machine;
+    unsigned int version;
+    unsigned int entry;
+    unsigned int phoff;
+    unsigned int shoff;
+    unsigned int flags;
+    unsigned short ehsize;
+    unsigned short phentsize;
+    unsigned short phnum;
+    unsigned short shentsize;
+    unsigned short shnum;
+    unsigned short shstrndx;
+} __attribute__ ((packed));
+
+/**
+ * @brief Type definition for an ELF file header.
+ *
+ */
+typedef struct elf_header_s elf_header_t;
+
+/**
+ * @brief ELF program header.
+ *
+ */
+struct elf_phdr_s {
+    unsigned int type;
+    unsigned int offset;
+    unsigned int vaddr;
+    unsigned int paddr;
+    unsigned int filesz;
+    unsigned int memsz;
+    unsigned int flags;
+    unsigned int align;
+} __attribute__ ((packed));
+
+/**
+ * @brief Type definition for an ELF program header.
+ *
+ */
+typedef struct elf_phdr_s elf_phdr_t;
+
+/**
+ * @brief Loadable segment of a program. start and end are page aligned.
+ * Read-only segments keep the physical page of each of their pages once
+ * it was read, shared by every instance.
+ *
+ */
+struct segment_s {
+    unsigned int start;
+    unsigned int end;
+    unsigned int vaddr;
+    unsigned int offset;
+    unsigned int filesz;
+    unsigned int writable;
+    unsigned int* pages;
+};
+
+/**
+ * @brief Type definition for a segment.
+ *
+ */
+typedef struct segment_s segment_t;
+
+/**
+ * @brief Program file loaded by the loader. Images stay cached with their
+ * shared pages after the last instance exits, so it starts faster again.
+ *
+ */
+struct image_s {
+    char path[FAT_PATH_MAX];
+    int fd;
+    unsigned int entry;
+    unsigned int segment_count;
+    segment_t segments[ELF_MAX_SEGMENTS];
+    mutex_t lock;
+    unsigned int instances;
+    unsigned int shared_pages;
+};
+
+/**
+ * @brief Type definition for an image.
+ *
+ */
+typedef struct image_s image_t;
+
+/**
+ * @brief Page faults resolved, pages read from the file, and faults on
+ * read-only pages another instance had read already.
+ *
+ */
+extern unsigned int elf_faults;
+extern unsigned int elf_pages_read;
+extern unsigned int elf_shared_hits;
+
+/**
+ * @brief Initializes the image cache.
+ *
+ */
+void init_elf();
+
+/**
+ * @brief Creates a user process running a program file, without starting
+ * it. Only the headers are read, segments are read as they are touched.
+ * Must be called from a process.
+ *
+ * @param path Path of the file on the floppy.
+ * @return pcb_t* The process, NULL if the file is not a valid program or
+ * out of memory.
+ */
+pcb_t* new_elf_process(char* path);
+
+/**
+ * @brief Creates and starts a user process running a program file.
+ *
+ * @param path Path of the file on the floppy.
+ * @return int EXIT_SUCCESS (0) if successful, EXIT_FAILURE (1) otherwise.
+ */
+int spawn(char* path);
+
+/**
+ * @brief Maps the page holding an address of a process's image. Called by
+ * page_fault with interrupts enabled.
+ *
+ * @param pcb The process.
+ * @param address The faulting address.
+ * @return int TRUE if the page was mapped, FALSE if the address is outside
+ * the image or out of memory.
+ */
+int elf_fault(pcb_t* pcb, unsigned int address);
+
+/**
+ * @brief Page table flags an unmapped page of a process's image will get.
+ *
+ * @param pcb The process, may be NULL.
+ * @param address An address in the page.
+ * @return unsigned int PAGE_USER with PAGE_WRITE for writable segments, 0
+ * outside the image.
+ */
+unsigned int elf_page_flags(pcb_t* pcb, unsigned int address);
+
+/**
+ * @brief Frees a process's page directory and private pages and drops its
+ * instance of the image, if it has one. Called by retire_process for every
+ * process, never sleeps.
+ *
+ * @param pcb The process.
+ */
+void release_address_space(pcb_t* pcb);
+
+#endif
@@ -0,0 +1,494 @@
+/**
+ * @file fat.c
+ * @author Robert McKay
+ * @brief Implements the read-only FAT12 file system on the floppy.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "fat.h"
+#include "buffer.h"
+#include "fdc.h"
+#include "io.h"
+#include "mutex.h"
+#include "pmm.h"
+#include "scheduler.h"
+#include "cpu.h"
+
+unsigned int fat_chain_walks;
+unsigned int fat_dcache_hits;
+unsigned int fat_dcache_misses;
+
+/**
+ * @brief Serializes the file system. Taken before the floppy's mutex.
+ *
+ */
+mutex_t fat_mutex;
+
+/**
+ * @brief TRUE once the volume was mounted.
+ *
+ */
+unsigned int fat_mounted;
+
+/**
+ * @brief Layout of the volume, in sectors.
+ *
+ */
+unsigned int fat_sectors_per_cluster;
+unsigned int fat_root_start;
+unsigned int fat_root_entries;
+unsigned int fat_data_start;
+unsigned int fat_cluster_count;
+
+/**
+ * @brief The FAT decoded to one next cluster number per cluster.
+ *
+ */
+unsigned short* fat_next;
+unsigned int fat_next_pages;
+
+/**
+ * @brief The root directory, read at mount.
+ *
+ */
+fat_dirent_t* fat_root;
+
+/**
+ * @brief Directory entry cache, replaced round robin.
+ *
+ */
+fat_dcache_t fat_dcache[FAT_DCACHE_SIZE];
+unsigned int fat_dcache_victim;
+
+/**
+ * @brief Open files, indexed by file descriptor.
+ *
+ */
+fat_file_t fat_files[FAT_MAX_FILES];
+
+/**
+ * @brief Bounce buffer for partial sectors and subdirectory clusters.
+ *
+ */
+unsigned char fat_bounce[PAGE_SIZE];
+
+/**
+ * @brief Number of pages holding a number of bytes.
+ *
+ * @param bytes The bytes.
+ * @return unsigned int The pages.
+ */
+static unsigned int pages_for(unsigned int bytes) {
+    return (bytes + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
+/**
+ * @brief Reads the boot sector, the FAT and the root directory. Called with
+ * fat_mutex held.
+ *
+ * @return int TRUE on success.
+ */
+static int mount() {
+    fat_bpb_t* bpb = (fat_bpb_t*)fat_bounce;
+    if (fdc_read(0, 1, fat_bounce) == FALSE || bpb->bytes_per_sector != FDC_SECTOR_SIZE
+        || bpb->sectors_per_cluster == 0 || bpb->fat_count == 0
+        || bpb->sectors_per_cluster * FDC_SECTOR_SIZE > PAGE_SIZE) {
+        return FALSE;
+    }
+    unsigned int fat_start = bpb->reserved_sectors;
+    unsigned int fat_sectors = bpb->sectors_per_fat;
+    fat_sectors_per_cluster = bpb->sectors_per_cluster;
+    fat_root_entries = bpb->root_entries;
+    fat_root_start = fat_start + bpb->fat_count * fat_sectors;
+    unsigned int root_bytes = fat_root_entries * sizeof(fat_dirent_t);
+    fat_data_start = fat_root_start + (root_bytes + FDC_SECTOR_SIZE - 1) / FDC_SECTOR_SIZE;
+    if (bpb->total_sectors <= fat_data_start) {
+        return FALSE;
+    }
+    fat_cluster_count = (bpb->total_sectors - fat_data_start) / fat_sectors_per_cluster;
+
+    /* decode the 12 bit entries once so a chain step is an array index */
+    unsigned int raw_pages = pages_for(fat_sectors * FDC_SECTOR_SIZE);
+    unsigned char* raw = (unsigned char*)alloc_pages(raw_pages);
+    if (raw == NULL) {
+        return FALSE;
+    }
+    fat_next_pages = pages_for((fat_cluster_count + FAT_FIRST_CLUSTER) * sizeof(unsigned short));
+    fat_next = (unsigned short*)alloc_pages(fat_next_pages);
+    if (fat_next == NULL || fdc_read(fat_start, fat_sectors, raw) == FALSE
+        || (fat_cluster_count + FAT_FIRST_CLUSTER) * 3 / 2 > fat_sectors * FDC_SECTOR_SIZE) {
+        free_pages((unsigned int)raw, raw_pages);
+        if (fat_next != NULL) {
+            free_pages((unsigned int)fat_next, fat_next_pages);
+        }
+        return FALSE;
+    }
+    for (unsigned int n = 0; n < fat_cluster_count + FAT_FIRST_CLUSTER; n++) {
+        unsigned int offset = n + n / 2;
+        unsigned int value = raw[offset] | (raw[offset + 1] << 8);
+        fat_next[n] = (n & 1) ? value >> 4 : value & 0xfff;
+    }
+    free_pages((unsigned int)raw, raw_pages);
+
+    fat_root = (fat_dirent_t*)alloc_pages(pages_for(root_bytes));
+    if (fat_root == NULL || fdc_read(fat_root_start, fat_data_start - fat_root_start, fat_root) == FALSE) {
+        if (fat_root != NULL) {
+            free_pages((unsigned int)fat_root, pages_for(root_bytes));
+        }
+        free_pages((unsigned int)fat_next, fat_next_pages);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * @brief Checks that a cluster number is a data cluster.
+ *
+ * @param cluster The cluster.
+ * @return int TRUE if it is.
+ */
+static int valid_cluster(unsigned int cluster) {
+    return cluster >= FAT_FIRST_CLUSTER && cluster < fat_cluster_count + FAT_FIRST_CLUSTER;
+}
+
+/**
+ * @brief First sector of a data cluster.
+ *
+ * @param cluster The cluster.
+ * @return unsigned int The sector.
+ */
+static unsigned int cluster_sector(unsigned int cluster) {
+    return fat_data_start + (cluster - FAT_FIRST_CLUSTER) * fat_sectors_per_cluster;
+}
+
+/**
+ * @brief Converts a path component to a space padded short name.
+ *
+ * @param component The component.
+ * @param length Its length.
+ * @param name Receives the short name.
+ * @return int FALSE if the component is not a valid 8.3 name.
+ */
+static int short_name(char* component, unsigned int length, char name[FAT_NAME_LENGTH]) {
+    unsigned int out = 0;
+    unsigned int limit = FAT_BASE_LENGTH;
+    for (int i = 0; i < FAT_NAME_LENGTH; i++) {
+        name[i] = ' ';
+    }
+    for (unsigned int i = 0; i < length; i++) {
+        char c = component[i];
+        if (c == '.' && i != 0 && limit == FAT_BASE_LENGTH) {
+            out = FAT_BASE_LENGTH;
+            limit = FAT_NAME_LENGTH;
+            continue;
+        }
+        if (out == limit) {
+            return FALSE;
+        }
+        if (c >= 'a' && c <= 'z') {
+            c -= 'a' - 'A';
+        }
+        name[out++] = c;
+    }
+    return length != 0;
+}
+
+/**
+ * @brief Compares two short names.
+ *
+ * @param a First name.
+ * @param b Second name.
+ * @return int TRUE if they are equal.
+ */
+static int same_name(char* a, char* b) {
+    for (int i = 0; i < FAT_NAME_LENGTH; i++) {
+        if (a[i] != b[i]) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * @brief Looks for a live, matching entry among directory entries.
+ *
+ * @param entries The entries.
+ * @param count Number of entries.
+ * @param name Short name wanted.
+ * @param slot Receives the entry.
+ * @return int TRUE if found, FALSE if not, FAT_ERROR at the end of the
+ * directory.
+ */
+static int scan_entries(fat_dirent_t* entries, unsigned int count, char* name,
+                        fat_dcache_t* slot) {
+    for (unsigned int i = 0; i < count; i++) {
+        fat_dirent_t* entry = &entries[i];
+        unsigned char first = entry->name[0];
+        if (first == FAT_ENTRY_END) {
+            return FAT_ERROR;
+        }
+        if (first == FAT_ENTRY_DELETED || entry->attributes == FAT_ATTR_LONG_NAME
+            || (entry->attributes & FAT_ATTR_VOLUME)) {
+            continue;
+        }
+        if (same_name(entry->name, name)) {
+            slot->attributes = entry->attributes;
+            slot->cluster = entry->cluster;
+            slot->size = entry->size;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * @brief Reads a directory from the disk to find a name.
+ *
+ * @param parent First cluster of the directory, or FAT_ROOT.
+ * @param name Short name wanted.
+ * @param slot Receives the entry.
+ * @return int TRUE if found.
+ */
+static int search_directory(unsigned int parent, char* name, fat_dcache_t* slot) {
+    unsigned int per_cluster = fat_sectors_per_cluster * FDC_SECTOR_SIZE / sizeof(fat_dirent_t);
+    if (parent == FAT_ROOT) {
+        return scan_entries(fat_root, fat_root_entries, name, slot) == TRUE;
+    }
+    for (unsigned int cluster = parent, steps = 0; valid_cluster(cluster) && steps < fat_cluster_count;
+         cluster = fat_next[cluster], steps++) {
+        if (fdc_read(cluster_sector(cluster), fat_sectors_per_cluster, fat_bounce) == FALSE) {
+            return FALSE;
+        }
+        int found = scan_entries((fat_dirent_t*)fat_bounce, per_cluster, name, slot);
+        if (found != FALSE) {
+            return found == TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * @brief Resolves a name in a directory through the cache.
+ *
+ * @param parent First cluster of the directory, or FAT_ROOT.
+ * @param name Short name wanted.
+ * @return fat_dcache_t* The cache slot, or NULL if there is no such entry.
+ */
+static fat_dcache_t* lookup(unsigned int parent, char* name) {
+    for (int i = 0; i < FAT_DCACHE_SIZE; i++) {
+        fat_dcache_t* slot = &fat_dcache[i];
+        if (slot->used && slot->parent == parent && same_name(slot->name, name)) {
+            fat_dcache_hits++;
+            return slot;
+        }
+    }
+    fat_dcache_misses++;
+
+    fat_dcache_t* slot = &fat_dcache[fat_dcache_victim];
+    slot->used = FALSE;
+    if (search_directory(parent, name, slot) == FALSE) {
+        return NULL;
+    }
+    fat_dcache_victim = (fat_dcache_victim + 1) % FAT_DCACHE_SIZE;
+    slot->parent = parent;
+    for (int i = 0; i < FAT_NAME_LENGTH; i++) {
+        slot->name[i] = name[i];
+    }
+    slot->used = TRUE;
+    return slot;
+}
+
+/**
+ * @brief Resolves a path from the root.
+ *
+ * @param path The path.
+ * @return fat_dcache_t* The cache slot of its last component, or NULL.
+ */
+static fat_dcache_t* resolve(char* path) {
+    char name[FAT_NAME_LENGTH];
+    fat_dcache_t* slot = NULL;
+    unsigned int parent = FAT_ROOT;
+    while (*path != NULL_TERMINATOR) {
+        if (*path == '/') {
+            path++;
+            continue;
+        }
+        if (slot != NULL) {
+            if ((slot->attributes & FAT_ATTR_DIRECTORY) == 0) {
+                return NULL;
+            }
+            parent = slot->cluster;
+        }
+        unsigned int length = 0;
+        while (path[length] != NULL_TERMINATOR && path[length] != '/') {
+            length++;
+        }
+        if (short_name(path, length, name) == FALSE) {
+            return NULL;
+        }
+        slot = lookup(parent, name);
+        if (slot == NULL) {
+            return NULL;
+        }
+        path += length;
+    }
+    return slot;
+}
+
+INIT void init_fat() {
+    init_mutex(&fat_mutex, "fat");
+    register_lock_stat(&fat_mutex.stat);
+    fat_mounted = FALSE;
+    fat_dcache_victim = 0;
+    for (int i = 0; i < FAT_DCACHE_SIZE; i++) {
+        fat_dcache[i].used = FALSE;
+    }
+    for (int i = 0; i < FAT_MAX_FILES; i++) {
+        fat_files[i].used = FALSE;
+    }
+}
+
+int fat_open(char* path) {
+    int fd = FAT_ERROR;
+    mutex_lock(&fat_mutex);
+    if (fat_mounted == FALSE) {
+        fat_mounted = mount();
+    }
+    fat_dcache_t* slot = fat_mounted ? resolve(path) : NULL;
+    for (int i = 0; i < FAT_MAX_FILES && slot != NULL; i++) {
+        if (fat_files[i].used == FALSE) {
+            fd = i;
+            break;
+        }
+    }
+    if (fd == FAT_ERROR || (slot->attributes & FAT_ATTR_DIRECTORY)) {
+        mutex_unlock(&fat_mutex);
+        return FAT_ERROR;
+    }
+
+    /* walk the chain once, reads then index the array */
+    fat_file_t* file = &fat_files[fd];
+    unsigned int cluster_bytes = fat_sectors_per_cluster * FDC_SECTOR_SIZE;
+    file->cluster_count = (slot->size + cluster_bytes - 1) / cluster_bytes;
+    file->pages = pages_for(file->cluster_count * sizeof(unsigned short));
+    file->clusters = NULL;
+    if (file->pages != 0) {
+        file->clusters = (unsigned short*)alloc_pages(file->pages);
+        if (file->clusters == NULL) {
+            mutex_unlock(&fat_mutex);
+            return FAT_ERROR;
+        }
+    }
+    unsigned int cluster = slot->cluster;
+    for (unsigned int i = 0; i < file->cluster_count; i++) {
+        if (valid_cluster(cluster) == FALSE) {
+            free_pages((unsigned int)file->clusters, file->pages);
+            mutex_unlock(&fat_mutex);
+            return FAT_ERROR;
+        }
+        file->clusters[i] = cluster;
+        cluster = fat_next[cluster];
+    }
+    fat_chain_walks++;
+    file->size = slot->size;
+    file->position = 0;
+    file->used = TRUE;
+    mutex_unlock(&fat_mutex);
+    return fd;
+}
+
+int fat_read(int fd, void* buffer, unsigned int length) {
+    unsigned char* destination = buffer;
+    unsigned int cluster_bytes = fat_sectors_per_cluster * FDC_SECTOR_SIZE;
+    int total = 0;
+    if (fd < 0 || fd >= FAT_MAX_FILES) {
+        return FAT_ERROR;
+    }
+
+    mutex_lock(&fat_mutex);
+    fat_file_t* file = &fat_files[fd];
+    if (file->used == FALSE) {
+        mutex_unlock(&fat_mutex);
+        return FAT_ERROR;
+    }
+    if (length > file->size - file->position) {
+        length = file->size - file->position;
+    }
+    while (length > 0) {
+        unsigned int index = file->position / cluster_bytes;
+        unsigned int in_cluster = file->position % cluster_bytes;
+        unsigned int offset = file->position % FDC_SECTOR_SIZE;
+
+        /* extend over clusters that follow each other on the disk */
+        unsigned int run = 1;
+        while (index + run < file->cluster_count
+               && file->clusters[index + run] == file->clusters[index] + run) {
+            run++;
+        }
+        unsigned int available = run * cluster_bytes - in_cluster;
+        if (available > length) {
+            available = length;
+        }
+        unsigned int sector = cluster_sector(file->clusters[index]) + in_cluster / FDC_SECTOR_SIZE;
+        unsigned int moved;
+
+        if (offset == 0 && available >= FDC_SECTOR_SIZE) {
+            moved = available - available % FDC_SECTOR_SIZE;
+            if (fdc_read(sector, moved / FDC_SECTOR_SIZE, destination) == FALSE) {
+                break;
+            }
+        } else {
+            moved = FDC_SECTOR_SIZE - offset;
+            if (moved > available) {
+                moved = available;
+            }
+            if (fdc_read(sector, 1, fat_bounce) == FALSE) {
+                break;
+            }
+            for (unsigned int i = 0; i < moved; i++) {
+                destination[i] = fat_bounce[offset + i];
+            }
+        }
+        destination += moved;
+        file->position += moved;
+        length -= moved;
+        total += moved;
+    }
+    mutex_unlock(&fat_mutex);
+    return (length != 0 && total == 0) ? FAT_ERROR : total;
+}
+
+int fat_seek(int fd, unsigned int position) {
+    int result = FAT_ERROR;
+    if (fd < 0 || fd >= FAT_MAX_FILES) {
+        return FAT_ERROR;
+    }
+    mutex_lock(&fat_mutex);
+    fat_file_t* file = &fat_files[fd];
+    if (file->used && position <= file->size) {
+        file->position = position;
+        result = 0;
+    }
+    mutex_unlock(&fat_mutex);
+    return result;
+}
+
+int fat_close(int fd) {
+    if (fd < 0 || fd >= FAT_MAX_FILES) {
+        return FAT_ERROR;
+    }
+    mutex_lock(&fat_mutex);
+    fat_file_t* file = &fat_files[fd];
+    if (file->used == FALSE) {
+        mutex_unlock(&fat_mutex);
+        return FAT_ERROR;
+    }
+    if (file->clusters != NULL) {
+        free_pages((unsigned int)file->clusters, file->pages);
+    }
+    file->used = FALSE;
+    mutex_unlock(&fat_mutex);
+    return 0;
+}
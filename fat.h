@@ -0,0 +1,179 @@
+/**
+ * @file fat.h
+ * @author Robert McKay
+ * @brief Declares the read-only FAT12 file system on the floppy. The FAT is
+ * decoded into memory once, paths are resolved through a directory entry
+ * cache and each open file keeps its cluster chain.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef FAT_H
+#define FAT_H
+
+/* directory entry attributes */
+#define FAT_ATTR_VOLUME 0x08
+#define FAT_ATTR_DIRECTORY 0x10
+#define FAT_ATTR_LONG_NAME 0x0f
+
+/* first name byte of the last and of a deleted directory entry */
+#define FAT_ENTRY_END 0x00
+#define FAT_ENTRY_DELETED 0xe5
+
+/* cluster numbers: the first data cluster and the end of chain marks */
+#define FAT_FIRST_CLUSTER 2
+#define FAT_CHAIN_END 0xff8
+
+/* cluster standing for the root directory (".." entries use it too) */
+#define FAT_ROOT 0
+
+/* length of a short name, base and extension without the dot */
+#define FAT_NAME_LENGTH 11
+#define FAT_BASE_LENGTH 8
+
+/* limits */
+#define FAT_MAX_FILES 16
+#define FAT_DCACHE_SIZE 32
+#define FAT_PATH_MAX 64
+
+/* returned instead of a file descriptor or a byte count */
+#define FAT_ERROR -1
+
+/**
+ * @brief BIOS parameter block at the start of the first sector.
+ *
+ */
+struct fat_bpb_s {
+    unsigned char jump[3];
+    char oem[8];
+    unsigned short bytes_per_sector;
+    unsigned char sectors_per_cluster;
+    unsigned short reserved_sectors;
+    unsigned char fat_count;
+    unsigned short root_entries;
+    unsigned short total_sectors;
+    unsigned char media;
+    unsigned short sectors_per_fat;
+    unsigned short sectors_per_track;
+    unsigned short heads;
+} __attribute__ ((packed));
+
+/**
+ * @brief Type definition for the BIOS parameter block.
+ *
+ */
+typedef struct fat_bpb_s fat_bpb_t;
+
+/**
+ * @brief Directory entry on the disk.
+ *
+ */
+struct fat_dirent_s {
+    char name[FAT_NAME_LENGTH];
+    unsigned char attributes;
+    unsigned char reserved[10];
+    unsigned short time;
+    unsigned short date;
+    unsigned short cluster;
+    unsigned int size;
+} __attribute__ ((packed));
+
+/**
+ * @brief Type definition for a directory entry.
+ *
+ */
+typedef struct fat_dirent_s fat_dirent_t;
+
+/**
+ * @brief Directory entry cache slot: a name in a directory and what it
+ * resolved to.
+ *
+ */
+struct fat_dcache_s {
+    unsigned int used;
+    unsigned int parent;
+    char name[FAT_NAME_LENGTH];
+    unsigned char attributes;
+    unsigned int cluster;
+    unsigned int size;
+};
+
+/**
+ * @brief Type definition for a directory entry cache slot.
+ *
+ */
+typedef struct fat_dcache_s fat_dcache_t;
+
+/**
+ * @brief Open file. The cluster chain is walked once, at open, into
+ * clusters so reads index it instead of following the FAT.
+ *
+ */
+struct fat_file_s {
+    unsigned int used;
+    unsigned int size;
+    unsigned int position;
+    unsigned short* clusters;
+    unsigned int cluster_count;
+    unsigned int pages;
+};
+
+/**
+ * @brief Type definition for an open file.
+ *
+ */
+typedef struct fat_file_s fat_file_t;
+
+/**
+ * @brief Cluster chains walked, and directory lookups the cache answered
+ * or missed.
+ *
+ */
+extern unsigned int fat_chain_walks;
+extern unsigned int fat_dcache_hits;
+extern unsigned int fat_dcache_misses;
+
+/**
+ * @brief Initializes the file table. The volume is mounted on first open,
+ * from a process.
+ *
+ */
+void init_fat();
+
+/**
+ * @brief Opens a file for reading.
+ *
+ * @param path Path from the root, '/' separated 8.3 names in any case.
+ * @return int File descriptor, or FAT_ERROR.
+ */
+int fat_open(char* path);
+
+/**
+ * @brief Reads from the current position of an open file.
+ *
+ * @param fd File descriptor.
+ * @param buffer Receives the data.
+ * @param length Bytes wanted.
+ * @return int Bytes read, 0 at the end of the file, or FAT_ERROR.
+ */
+int fat_read(int fd, void* buffer, unsigned int length);
+
+/**
+ * @brief Moves the position of an open file.
+ *
+ * @param fd File descriptor.
+ * @param position New position, at most the size of the file.
+ * @return int 0, or FAT_ERROR.
+ */
+int fat_seek(int fd, unsigned int position);
+
+/**
+ * @brief Closes an open file.
+ *
+ * @param fd File descriptor.
+ * @return int 0, or FAT_ERROR if fd is not open.
+ */
+int fat_close(int fd);
+
+#endif
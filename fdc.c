@@ -0,0 +1,316 @@
+/**
+ * @file fdc.c
+ * @author Robert McKay
+ * @brief Implements the floppy disk controller driver.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "fdc.h"
+#include "apic.h"
+#include "boot2.h"
+#include "buffer.h"
+#include "clock.h"
+#include "defer.h"
+#include "mutex.h"
+#include "smp.h"
+#include "cpu.h"
+
+unsigned int fdc_track_reads;
+unsigned int fdc_cached_sectors;
+
+/**
+ * @brief One process at a time drives the controller.
+ *
+ */
+mutex_t fdc_mutex;
+
+/**
+ * @brief Protects fdc_irq and the queue waiting for it.
+ *
+ */
+spinlock_t fdc_lock;
+queue_t fdc_waiters;
+
+/**
+ * @brief Set by the top half, cleared before each command.
+ *
+ */
+volatile unsigned int fdc_irq;
+
+/**
+ * @brief TRUE once the controller was reset and the motor started.
+ *
+ */
+unsigned int fdc_ready;
+
+/**
+ * @brief Cylinder the head is on.
+ *
+ */
+unsigned int fdc_cylinder;
+
+/**
+ * @brief Track (cylinder * FDC_HEADS + head) held in fdc_buffer.
+ *
+ */
+unsigned int fdc_track;
+
+/**
+ * @brief DMA buffer. ISA DMA reaches the first 16 MB and can not cross a
+ * 64 KB boundary, its alignment keeps a track inside one.
+ *
+ */
+unsigned char fdc_buffer[FDC_TRACK_SIZE] __attribute__ ((aligned (0x4000)));
+
+/**
+ * @brief Writes a byte to the controller once it asks for one.
+ *
+ * @param value The byte.
+ * @return int FALSE if the controller never asked.
+ */
+static int fdc_send(unsigned char value) {
+    for (int i = 0; i < FDC_POLL_LIMIT; i++) {
+        if ((inportb(FDC_MSR) & (FDC_MSR_RQM | FDC_MSR_DIO)) == FDC_MSR_RQM) {
+            outportb(FDC_FIFO, value);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * @brief Reads a result byte from the controller once it has one.
+ *
+ * @param value Receives the byte.
+ * @return int FALSE if the controller never had one.
+ */
+static int fdc_receive(unsigned char* value) {
+    for (int i = 0; i < FDC_POLL_LIMIT; i++) {
+        if ((inportb(FDC_MSR) & (FDC_MSR_RQM | FDC_MSR_DIO)) == (FDC_MSR_RQM | FDC_MSR_DIO)) {
+            *value = inportb(FDC_FIFO);
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/**
+ * @brief Sleeps until the controller interrupts.
+ *
+ */
+static void fdc_wait() {
+    unsigned int flags = acquire_irqsave(&fdc_lock);
+    while (fdc_irq == FALSE) {
+        block_process((unsigned int)&fdc_waiters, (unsigned int)&fdc_lock);
+        acquire(&fdc_lock);
+    }
+    fdc_irq = FALSE;
+    release_irqrestore(&fdc_lock, flags);
+}
+
+/**
+ * @brief Acknowledges the interrupt of a seek, recalibrate or reset.
+ *
+ * @return unsigned char ST0.
+ */
+static unsigned char fdc_sense() {
+    unsigned char st0 = FDC_ST0_ERROR;
+    unsigned char cylinder;
+    fdc_send(FDC_CMD_SENSE_INTERRUPT);
+    fdc_receive(&st0);
+    fdc_receive(&cylinder);
+    return st0;
+}
+
+/**
+ * @brief Moves the head to cylinder 0.
+ *
+ * @return int TRUE on success.
+ */
+static int fdc_recalibrate() {
+    fdc_irq = FALSE;
+    fdc_send(FDC_CMD_RECALIBRATE);
+    fdc_send(0);
+    fdc_wait();
+    fdc_cylinder = 0;
+    return (fdc_sense() & FDC_ST0_ERROR) == 0;
+}
+
+/**
+ * @brief Moves the head to a cylinder.
+ *
+ * @param cylinder The cylinder.
+ * @param head The head.
+ * @return int TRUE on success.
+ */
+static int fdc_seek(unsigned int cylinder, unsigned int head) {
+    if (fdc_cylinder == cylinder) {
+        return TRUE;
+    }
+    fdc_irq = FALSE;
+    fdc_send(FDC_CMD_SEEK);
+    fdc_send(head << 2);
+    fdc_send(cylinder);
+    fdc_wait();
+    if (fdc_sense() & FDC_ST0_ERROR) {
+        return FALSE;
+    }
+    fdc_cylinder = cylinder;
+    return TRUE;
+}
+
+/**
+ * @brief Resets the controller, sets its timings and starts the motor,
+ * which is left running.
+ *
+ * @return int TRUE on success.
+ */
+static int fdc_reset() {
+    fdc_irq = FALSE;
+    outportb(FDC_DOR, FDC_DOR_RESET);
+    outportb(FDC_DOR, FDC_DOR_ENABLE);
+    fdc_wait();
+
+    /* one sense per drive the reset reports on */
+    for (int i = 0; i < 4; i++) {
+        fdc_sense();
+    }
+    outportb(FDC_CCR, 0);
+    fdc_send(FDC_CMD_SPECIFY);
+    fdc_send(FDC_SPECIFY_1);
+    fdc_send(FDC_SPECIFY_2);
+    outportb(FDC_DOR, FDC_DOR_MOTOR);
+    delay_us(FDC_MOTOR_DELAY_US);
+    fdc_track = FDC_NO_TRACK;
+    return fdc_recalibrate();
+}
+
+/**
+ * @brief Programs ISA DMA channel 2 to fill fdc_buffer with one track.
+ *
+ */
+static void dma_setup() {
+    unsigned int address = (unsigned int)fdc_buffer;
+    unsigned int count = FDC_TRACK_SIZE - 1;
+    outportb(DMA_MASK, DMA_MASK_ON | DMA_CHANNEL_2);
+    outportb(DMA_FLIP_FLOP, 0);
+    outportb(DMA_ADDRESS_2, address & 0xff);
+    outportb(DMA_ADDRESS_2, (address >> 8) & 0xff);
+    outportb(DMA_PAGE_2, (address >> 16) & 0xff);
+    outportb(DMA_FLIP_FLOP, 0);
+    outportb(DMA_COUNT_2, count & 0xff);
+    outportb(DMA_COUNT_2, (count >> 8) & 0xff);
+    outportb(DMA_MODE, DMA_MODE_READ_2);
+    outportb(DMA_MASK, DMA_CHANNEL_2);
+}
+
+/**
+ * @brief Reads a whole track into fdc_buffer.
+ *
+ * @param track The track (cylinder * FDC_HEADS + head).
+ * @return int TRUE on success.
+ */
+static int fdc_read_track(unsigned int track) {
+    unsigned int cylinder = track / FDC_HEADS;
+    unsigned int head = track % FDC_HEADS;
+    unsigned char result[FDC_RESULT_BYTES];
+
+    for (int attempt = 0; attempt < FDC_RETRIES; attempt++) {
+        if (fdc_seek(cylinder, head) == FALSE) {
+            fdc_recalibrate();
+            continue;
+        }
+        dma_setup();
+        fdc_irq = FALSE;
+        fdc_send(FDC_CMD_READ_DATA);
+        fdc_send(head << 2);
+        fdc_send(cylinder);
+        fdc_send(head);
+        fdc_send(1);
+        fdc_send(FDC_SECTOR_CODE);
+        fdc_send(FDC_SECTORS_PER_TRACK);
+        fdc_send(FDC_GAP);
+        fdc_send(FDC_DTL);
+        fdc_wait();
+        for (int i = 0; i < FDC_RESULT_BYTES; i++) {
+            fdc_receive(&result[i]);
+        }
+        if ((result[0] & FDC_ST0_ERROR) == 0) {
+            fdc_track = track;
+            fdc_track_reads++;
+            return TRUE;
+        }
+        fdc_recalibrate();
+    }
+    fdc_track = FDC_NO_TRACK;
+    return FALSE;
+}
+
+INIT void init_fdc() {
+    init_mutex(&fdc_mutex, "floppy");
+    init_lock(&fdc_lock, "floppy irq");
+    init_queue(&fdc_waiters, "floppy waiters");
+    register_lock_stat(&fdc_mutex.stat);
+    register_lock_stat(&fdc_lock.stat);
+    fdc_ready = FALSE;
+    fdc_track = FDC_NO_TRACK;
+    if (lapic_eoi != NULL) {
+        ioapic_route(IRQ_FDC, FDC_VECTOR, lapic_id(), FALSE);
+    } else {
+        outportb(0x21, inportb(0x21) & ~(1 << IRQ_FDC));
+    }
+    register_bottom_half(BH_FDC, fdc_bottom_half);
+}
+
+int fdc_read(unsigned int lba, unsigned int count, void* buffer) {
+    unsigned char* destination = buffer;
+    int result = TRUE;
+    if (lba >= FDC_SECTORS || count > FDC_SECTORS - lba) {
+        return FALSE;
+    }
+
+    mutex_lock(&fdc_mutex);
+    if (fdc_ready == FALSE) {
+        fdc_ready = fdc_reset();
+    }
+    while (count > 0 && result == TRUE) {
+        unsigned int track = lba / FDC_SECTORS_PER_TRACK;
+        unsigned int first = lba % FDC_SECTORS_PER_TRACK;
+        unsigned int sectors = FDC_SECTORS_PER_TRACK - first;
+        if (sectors > count) {
+            sectors = count;
+        }
+        if (track == fdc_track) {
+            fdc_cached_sectors += sectors;
+        } else if (fdc_read_track(track) == FALSE) {
+            result = FALSE;
+            break;
+        }
+
+        unsigned char* source = fdc_buffer + first * FDC_SECTOR_SIZE;
+        unsigned int bytes = sectors * FDC_SECTOR_SIZE;
+        asm volatile ("rep movsb"
+                      : "+D" (destination), "+S" (source), "+c" (bytes)
+                      : : "memory");
+        lba += sectors;
+        count -= sectors;
+    }
+    mutex_unlock(&fdc_mutex);
+    return result;
+}
+
+void fdc_interrupt() {
+    fdc_irq = TRUE;
+    raise_bottom_half(BH_FDC);
+}
+
+void fdc_bottom_half() {
+    pcb_t* pcb;
+    unsigned int flags = acquire_irqsave(&fdc_lock);
+    while ((pcb = dequeue_process(&fdc_waiters)) != NULL) {
+        make_ready(pcb);
+    }
+    release_irqrestore(&fdc_lock, flags);
+}
@@ -0,0 +1,116 @@
+/**
+ * @file fdc.h
+ * @author Robert McKay
+ * @brief Declares the floppy disk controller driver (drive 0, 1.44 MB,
+ * ISA DMA channel 2) with a one track cache.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef FDC_H
+#define FDC_H
+
+/* controller ports */
+#define FDC_DOR 0x3f2
+#define FDC_MSR 0x3f4
+#define FDC_FIFO 0x3f5
+#define FDC_CCR 0x3f7
+
+/* digital output register: drive 0, controller enabled, IRQ and DMA on,
+   motor 0 on */
+#define FDC_DOR_RESET 0x00
+#define FDC_DOR_ENABLE 0x0c
+#define FDC_DOR_MOTOR 0x1c
+
+/* bits of the main status register */
+#define FDC_MSR_DIO 0x40
+#define FDC_MSR_RQM 0x80
+
+/* commands */
+#define FDC_CMD_SPECIFY 0x03
+#define FDC_CMD_RECALIBRATE 0x07
+#define FDC_CMD_SENSE_INTERRUPT 0x08
+#define FDC_CMD_SEEK 0x0f
+#define FDC_CMD_READ_DATA 0x46
+
+/* command parameters: step rate/head unload, head load with DMA, 512 byte
+   sectors, gap length, data length */
+#define FDC_SPECIFY_1 0xdf
+#define FDC_SPECIFY_2 0x02
+#define FDC_SECTOR_CODE 2
+#define FDC_GAP 0x1b
+#define FDC_DTL 0xff
+
+/* result bytes of a read and the error bits of ST0 */
+#define FDC_RESULT_BYTES 7
+#define FDC_ST0_ERROR 0xc0
+
+/* 1.44 MB geometry */
+#define FDC_SECTOR_SIZE 512
+#define FDC_SECTORS_PER_TRACK 18
+#define FDC_HEADS 2
+#define FDC_CYLINDERS 80
+#define FDC_SECTORS (FDC_SECTORS_PER_TRACK * FDC_HEADS * FDC_CYLINDERS)
+#define FDC_TRACK_SIZE (FDC_SECTORS_PER_TRACK * FDC_SECTOR_SIZE)
+
+/* ISA DMA controller ports and the mode for channel 2 (single transfer,
+   increment, device to memory) */
+#define DMA_MASK 0x0a
+#define DMA_MODE 0x0b
+#define DMA_FLIP_FLOP 0x0c
+#define DMA_ADDRESS_2 0x04
+#define DMA_COUNT_2 0x05
+#define DMA_PAGE_2 0x81
+#define DMA_CHANNEL_2 0x02
+#define DMA_MASK_ON 0x04
+#define DMA_MODE_READ_2 0x46
+
+/* legacy interrupt line and vector (the 8259 delivers IRQ 6 at 32 + 6) */
+#define IRQ_FDC 6
+#define FDC_VECTOR 38
+
+/* limits */
+#define FDC_RETRIES 3
+#define FDC_POLL_LIMIT 100000
+#define FDC_MOTOR_DELAY_US 300000
+#define FDC_NO_TRACK 0xffffffff
+
+/**
+ * @brief Tracks read from the disk and sectors served from the track cache.
+ *
+ */
+extern unsigned int fdc_track_reads;
+extern unsigned int fdc_cached_sectors;
+
+/**
+ * @brief Initializes the driver and routes IRQ 6. The controller is reset
+ * on first use, from a process.
+ *
+ */
+void init_fdc();
+
+/**
+ * @brief Reads sectors, one whole track at a time through the DMA buffer.
+ * Sleeps until the controller interrupts.
+ *
+ * @param lba First sector.
+ * @param count Number of sectors.
+ * @param buffer Receives the data.
+ * @return int TRUE if every sector was read.
+ */
+int fdc_read(unsigned int lba, unsigned int count, void* buffer);
+
+/**
+ * @brief Top half of the floppy interrupt. Called by fdc_enter in boot2.S.
+ *
+ */
+void fdc_interrupt();
+
+/**
+ * @brief Wakes the process waiting for the controller.
+ *
+ */
+void fdc_bottom_half();
+
+#endif
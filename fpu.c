@@ -0,0 +1,127 @@
+/**
+ * @file fpu.c
+ * @author Robert McKay
+ * @brief Implements lazy switching of the x87/SSE state.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "fpu.h"
+#include "buffer.h"
+#include "cpu.h"
+#include "slab.h"
+#include "smp.h"
+
+unsigned int fpu_traps;
+unsigned int fpu_switches;
+
+/**
+ * @brief Cache the FPU state areas are allocated from.
+ *
+ */
+cache_t fpu_cache;
+
+/**
+ * @brief TRUE if the processor has FXSAVE/FXRSTOR, otherwise the x87 only
+ * FNSAVE/FRSTOR are used.
+ *
+ */
+int fxsr_supported;
+
+/**
+ * @brief Returns the aligned FPU state area of a process.
+ *
+ * @param pcb The process, which must have an area.
+ * @return void* The 16 byte aligned area.
+ */
+static void* fpu_area(pcb_t* pcb) {
+    return (void*)((pcb->fpu_state + FPU_STATE_ALIGN - 1) & ~(FPU_STATE_ALIGN - 1));
+}
+
+void init_fpu_cache() {
+    init_cache(&fpu_cache, "fpu state", FPU_STATE_SIZE + FPU_STATE_ALIGN, NULL);
+}
+
+void init_fpu() {
+    unsigned int regs[4];
+    cpu_t* cpu = this_cpu();
+
+    cpuid(1, regs);
+    fxsr_supported = (regs[3] & CPUID_EDX_FXSR) != 0;
+    if (fxsr_supported) {
+        unsigned int cr4 = read_cr4() | CR4_OSFXSR;
+        if (regs[3] & CPUID_EDX_SSE) {
+            cr4 |= CR4_OSXMMEXCPT;
+        }
+        write_cr4(cr4);
+    }
+
+    /* native x87 errors, and WAIT/FWAIT also trap while TS is set */
+    write_cr0((read_cr0() & ~(CR0_EM | CR0_TS)) | CR0_MP | CR0_NE);
+    asm volatile ("fninit");
+    write_cr0(read_cr0() | CR0_TS);
+    cpu->fpu_owner = NULL;
+    cpu->fpu_live = FALSE;
+}
+
+void fpu_switch_out(cpu_t* cpu, pcb_t* next) {
+    if (cpu->fpu_live && next != cpu->fpu_owner) {
+        write_cr0(read_cr0() | CR0_TS);
+        cpu->fpu_live = FALSE;
+    }
+}
+
+void fpu_trap() {
+    cpu_t* cpu = this_cpu();
+    pcb_t* current = cpu->current;
+    pcb_t* owner = cpu->fpu_owner;
+
+    __sync_fetch_and_add(&fpu_traps, 1);
+    asm volatile ("clts");
+    cpu->fpu_live = TRUE;
+    if (owner == current) {
+        return;
+    }
+
+    /* the registers still hold the last owner's state */
+    if (owner != NULL) {
+        if (fxsr_supported) {
+            asm volatile ("fxsave (%0)" : : "r" (fpu_area(owner)) : "memory");
+        } else {
+            asm volatile ("fnsave (%0)" : : "r" (fpu_area(owner)) : "memory");
+        }
+        __sync_fetch_and_add(&fpu_switches, 1);
+    }
+    cpu->fpu_owner = current;
+
+    /* first use starts from a clean state */
+    if (current->fpu_state == NULL) {
+        current->fpu_state = (unsigned int)cache_alloc(&fpu_cache);
+        if (current->fpu_state == NULL) {
+            cpu->fpu_owner = NULL;
+            exit_process(EXIT_FAILURE);
+        }
+        asm volatile ("fninit");
+        if (fxsr_supported) {
+            asm volatile ("fxsave (%0)" : : "r" (fpu_area(current)) : "memory");
+        }
+        return;
+    }
+    if (fxsr_supported) {
+        asm volatile ("fxrstor (%0)" : : "r" (fpu_area(current)) : "memory");
+    } else {
+        asm volatile ("frstor (%0)" : : "r" (fpu_area(current)) : "memory");
+    }
+}
+
+void free_fpu(pcb_t* pcb) {
+    cpu_t* cpu = this_cpu();
+    if (cpu->fpu_owner == pcb) {
+        cpu->fpu_owner = NULL;
+    }
+    if (pcb->fpu_state != NULL) {
+        cache_free(&fpu_cache, (void*)pcb->fpu_state);
+        pcb->fpu_state = NULL;
+    }
+}
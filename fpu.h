@@ -0,0 +1,76 @@
+/**
+ * @file fpu.h
+ * @author Robert McKay
+ * @brief Declares lazy switching of the x87/SSE state through CR0.TS and
+ * the device not available trap.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef FPU_H
+#define FPU_H
+
+#include "smp.h"
+
+/* device not available exception, raised by FPU use while CR0.TS is set */
+#define FPU_VECTOR 7
+
+/* FXSAVE area, which must be 16 byte aligned */
+#define FPU_STATE_SIZE 512
+#define FPU_STATE_ALIGN 16
+
+/**
+ * @brief Number of device not available traps taken.
+ *
+ */
+extern unsigned int fpu_traps;
+
+/**
+ * @brief Number of times one process's FPU state was saved to load
+ * another's.
+ *
+ */
+extern unsigned int fpu_switches;
+
+/**
+ * @brief Creates the cache FPU state areas are allocated from.
+ *
+ */
+void init_fpu_cache();
+
+/**
+ * @brief Enables the FPU (and SSE with FXSAVE) on the calling processor and
+ * sets CR0.TS, so the first process to use it traps.
+ *
+ */
+void init_fpu();
+
+/**
+ * @brief Called by next_process. Sets CR0.TS if the FPU holds live state
+ * that does not belong to the next process. Costs nothing more when no
+ * process has used the FPU since the last switch.
+ *
+ * @param cpu The calling processor's data.
+ * @param next The process about to run.
+ */
+void fpu_switch_out(cpu_t* cpu, pcb_t* next);
+
+/**
+ * @brief Handles the device not available trap: clears CR0.TS and, if the
+ * current process does not own the FPU, saves the owner's state and loads
+ * the current process's state (or a clean state on first use). Called by
+ * fpu_enter in boot2.S.
+ *
+ */
+void fpu_trap();
+
+/**
+ * @brief Frees a process's FPU state and drops it as the owner of the
+ * calling processor's FPU. Called when the process exits.
+ *
+ * @param pcb The process.
+ */
+void free_fpu(pcb_t* pcb);
+
+#endif
@@ -0,0 +1,40 @@
+/**
+ * @file gdt.c
+ * @author Robert McKay
+ * @brief Defines procedures to initialize the per processor GDT.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "gdt.h"
+#include "boot2.h"
+#include "cpu.h"
+
+void initGDTEntry(gdt_entry_t* entry, unsigned int base, unsigned int limit,
+                  unsigned char access, unsigned char flags) {
+    entry->limit_low16 = limit & 0x0000ffff;
+    entry->base_low16 = base & 0x0000ffff;
+    entry->base_mid8 = (base & 0x00ff0000) >> 16;
+    entry->access = access;
+    entry->limit_flags = (flags << 4) | ((limit & 0x000f0000) >> 16);
+    entry->base_hi8 = (base & 0xff000000) >> 24;
+}
+
+void initGDT(gdt_entry_t* gdt, gdt_r_t* gdtr, unsigned int percpu,
+             unsigned int percpu_size, tss_t* tss) {
+    initGDTEntry(&gdt[0], 0, 0, 0, 0);
+    initGDTEntry(&gdt[1], 0, 0xfffff, GDT_DATA, GDT_FLAT);
+    initGDTEntry(&gdt[2], 0, 0xfffff, GDT_CODE, GDT_FLAT);
+    initGDTEntry(&gdt[3], 0, 0xfffff, GDT_DATA, GDT_FLAT);
+    initGDTEntry(&gdt[4], 0, 0xfffff, GDT_USER_CODE, GDT_FLAT);
+    initGDTEntry(&gdt[5], 0, 0xfffff, GDT_USER_DATA, GDT_FLAT);
+    initGDTEntry(&gdt[6], percpu, percpu_size - 1, GDT_DATA, GDT_BYTES);
+    initGDTEntry(&gdt[7], (unsigned int)tss, sizeof(tss_t) - 1, GDT_TSS, GDT_SYSTEM);
+
+    /* load gdt and reload the segment registers */
+    gdtr->limit = sizeof(gdt_entry_t) * GDT_ENTRIES - 1;
+    gdtr->base = (unsigned int)gdt;
+    lgdtr((unsigned int)gdtr);
+    ltr(TSS_SEL);
+}
@@ -0,0 +1,143 @@
+/**
+ * @file gdt.h
+ * @author Robert McKay
+ * @brief Declares the per processor global descriptor table.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef GDT_H
+#define GDT_H
+
+#define GDT_ENTRIES 8
+
+/* segment selectors (the first four match the table boot1 installs, the
+   user segments follow the kernel code segment as SYSEXIT requires) */
+#define LINEAR_SEL 0x08
+#define KERNEL_CODE_SEL 0x10
+#define KERNEL_DATA_SEL 0x18
+#define USER_CODE_SEL 0x20
+#define USER_DATA_SEL 0x28
+#define PERCPU_SEL 0x30
+#define TSS_SEL 0x38
+
+/* requested privilege level of user selectors */
+#define RPL_USER 3
+
+/* access bytes */
+#define GDT_CODE 0x9a
+#define GDT_DATA 0x92
+#define GDT_USER_CODE 0xfa
+#define GDT_USER_DATA 0xf2
+#define GDT_TSS 0x89
+
+/* flags nibble: 4 KB granularity and 32 bit, byte granularity, or none
+   for system descriptors */
+#define GDT_FLAT 0xc
+#define GDT_BYTES 0x4
+#define GDT_SYSTEM 0x0
+
+/**
+ * @brief Structure for a segment descriptor.
+ *
+ */
+struct gdt_entry_s {
+    unsigned short limit_low16;
+    unsigned short base_low16;
+    unsigned char base_mid8;
+    unsigned char access;
+    unsigned char limit_flags;
+    unsigned char base_hi8;
+} __attribute__ ((packed));
+
+/**
+ * @brief Structure for the limit and base address of the GDT.
+ *
+ */
+struct gdt_r_s {
+    unsigned short limit;
+    unsigned int base;
+} __attribute__ ((packed));
+
+/**
+ * @brief Structure for a task state segment. Only the ring 0 stack is used,
+ * to enter the kernel from user mode.
+ *
+ */
+struct tss_s {
+    unsigned int link;
+    unsigned int esp0;
+    unsigned int ss0;
+    unsigned int esp1;
+    unsigned int ss1;
+    unsigned int esp2;
+    unsigned int ss2;
+    unsigned int cr3;
+    unsigned int eip;
+    unsigned int eflags;
+    unsigned int eax;
+    unsigned int ecx;
+    unsigned int edx;
+    unsigned int ebx;
+    unsigned int esp;
+    unsigned int ebp;
+    unsigned int esi;
+    unsigned int edi;
+    unsigned int es;
+    unsigned int cs;
+    unsigned int ss;
+    unsigned int ds;
+    unsigned int fs;
+    unsigned int gs;
+    unsigned int ldt;
+    unsigned short trap;
+    unsigned short iomap_base;
+} __attribute__ ((packed));
+
+/**
+ * @brief Type definition for a task state segment.
+ *
+ */
+typedef struct tss_s tss_t;
+
+/**
+ * @brief Type definition for a segment descriptor.
+ *
+ */
+typedef struct gdt_entry_s gdt_entry_t;
+
+/**
+ * @brief Type definition for the base/limit of the GDT.
+ *
+ */
+typedef struct gdt_r_s gdt_r_t;
+
+/**
+ * @brief Initializes a segment descriptor.
+ *
+ * @param entry The descriptor to initialize.
+ * @param base Base address of the segment.
+ * @param limit Limit of the segment (in units given by the flags).
+ * @param access Access byte.
+ * @param flags Granularity and size flags.
+ */
+void initGDTEntry(gdt_entry_t* entry, unsigned int base, unsigned int limit,
+                  unsigned char access, unsigned char flags);
+
+/**
+ * @brief Fills a processor's GDT, loads it on the calling processor and
+ * loads the task register. Each processor has its own table so the same
+ * PERCPU_SEL and TSS_SEL selectors find each processor's own data through
+ * gs and its own TSS.
+ *
+ * @param gdt The processor's table of GDT_ENTRIES descriptors.
+ * @param gdtr The processor's GDT register image.
+ * @param percpu Address of the processor's per cpu data.
+ * @param percpu_size Size of the per cpu data in bytes.
+ * @param tss The processor's task state segment.
+ */
+void initGDT(gdt_entry_t* gdt, gdt_r_t* gdtr, unsigned int percpu,
+             unsigned int percpu_size, tss_t* tss);
+
+#endif
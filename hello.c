@@ -0,0 +1,60 @@
+/**
+ * @file hello.c
+ * @author Robert McKay
+ * @brief User program run from the floppy by the ELF loader. It is linked
+ * on its own at USER_BASE, so it makes system calls with int 0x80 itself.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "syscall.h"
+
+/* pages of scratch memory touched, each faulted in as a private page */
+#define HELLO_SCRATCH_PAGES 4
+#define HELLO_PAGE_SIZE 4096
+
+/**
+ * @brief Message printed, read-only data shared between instances.
+ *
+ */
+const char message[] = "hello from a program loaded from the floppy";
+
+/**
+ * @brief Scratch memory in the bss.
+ *
+ */
+unsigned char scratch[HELLO_SCRATCH_PAGES * HELLO_PAGE_SIZE];
+
+/**
+ * @brief Makes a system call.
+ *
+ * @param number The system call number.
+ * @param arg1 First argument.
+ * @param arg2 Second argument.
+ * @return unsigned int The result of the call.
+ */
+static inline unsigned int hello_syscall(unsigned int number, unsigned int arg1,
+                                         unsigned int arg2) {
+    unsigned int result;
+    asm volatile ("int $0x80"
+                  : "=a" (result)
+                  : "a" (number), "b" (arg1), "S" (arg2), "D" (0)
+                  : "memory");
+    return result;
+}
+
+/**
+ * @brief Entry point. Touches the scratch pages, prints the message and
+ * exits with the sum of the scratch bytes (0).
+ *
+ */
+void _start() {
+    unsigned int sum = 0;
+    for (unsigned int i = 0; i < sizeof(scratch); i += HELLO_PAGE_SIZE) {
+        sum += scratch[i];
+        scratch[i] = 1;
+    }
+    hello_syscall(SYS_PRINTLN, (unsigned int)message, sizeof(message) - 1);
+    hello_syscall(SYS_EXIT, sum, 0);
+}
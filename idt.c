@@ -9,6 +9,18 @@
 
 #include "boot2.h"
 #include "idt.h"
+#include "apic.h"
+#include "syscall.h"
+#include "fpu.h"
+#include "paging.h"
+#include "ata.h"
+#include "fdc.h"
+#include "buffer.h"
+#include "defer.h"
+#include "gdt.h"
+#include "io.h"
+#include "process.h"
+#include "cpu.h"
 
 /**
  * @brief Interrupt Descriptor Table.
@@ -31,12 +43,18 @@ void initIDTEntry(unsigned int entry, unsigned int base,
     idt[entry].base_hi16 = (base & 0xffff0000) >> 16;
 }
 
-void initIDT() {
+INIT void initIDT() {
     /* entries 0-31 */
-    for (unsigned int entry = 0; entry < 31; entry++) {
-        initIDTEntry(entry, (unsigned int)default_handler, 0x10, 0x8e);
+    for (unsigned int entry = 0; entry < EXCEPTION_COUNT; entry++) {
+        initIDTEntry(entry, exception_stubs[entry], 0x10, 0x8e);
     }
 
+    /* entry 7, FPU use while CR0.TS is set */
+    initIDTEntry(FPU_VECTOR, (unsigned int)fpu_enter, 0x10, 0x8e);
+
+    /* entry 14, page faults */
+    initIDTEntry(PAGE_FAULT_VECTOR, (unsigned int)page_fault_enter, 0x10, 0x8e);
+
     /* entry 32 */
     initIDTEntry(32, (unsigned int)dispatch, 0x10, 0x8e);
 
@@ -48,13 +66,56 @@ void initIDT() {
         initIDTEntry(entry, 0, 0, 0);
     }
 
+    /* entry 46, IRQ 14 through either controller */
+    initIDTEntry(ATA_VECTOR, (unsigned int)ata_enter, 0x10, 0x8e);
+
+    /* entry 38, IRQ 6 through either controller */
+    initIDTEntry(FDC_VECTOR, (unsigned int)fdc_enter, 0x10, 0x8e);
+
+    /* entry 128, callable from ring 3 */
+    initIDTEntry(SYSCALL_VECTOR, (unsigned int)syscall_enter, 0x10, SYSCALL_GATE);
+
+    /* entry 240 */
+    initIDTEntry(RESCHED_VECTOR, (unsigned int)resched_enter, 0x10, 0x8e);
+
+    /* entry 255 */
+    initIDTEntry(SPURIOUS_VECTOR, (unsigned int)spurious_handler, 0x10, 0x8e);
+
     /* load idt */
     idtr.limit = sizeof(idt_entry_t) * IDT_SIZE - 1;
     idtr.base = (unsigned int)&idt;
     lidtr((unsigned int)&idtr);
 }
 
-void setupPIC() {
+void exception(unsigned int vector, unsigned int error, unsigned int cs) {
+    char message[] = "unhandled exception ";
+    char code[] = ", error code ";
+    char number[11];
+
+    /* one bad instruction in ring 3 only ends its process */
+    if ((cs & RPL_USER) == RPL_USER) {
+        exit_process(EXIT_FAULT);
+    }
+
+    /* the instruction after a trap can run, a fault would repeat */
+    if (vector == DEBUG_VECTOR || vector == NMI_VECTOR || vector == BREAKPOINT_VECTOR
+        || vector == OVERFLOW_VECTOR) {
+        raise_bottom_half(BH_DEFAULT);
+        return;
+    }
+    convert_num(vector, number);
+    println(message);
+    println(number);
+    convert_num(error, number);
+    println(code);
+    println(number);
+    new_line();
+    while (TRUE) {
+        asm volatile ("cli; hlt");
+    }
+}
+
+INIT void setupPIC() {
     outportb(0x20, 0x11);   /* start 8259 master initialization */
     outportb(0xa0, 0x11);   /* start 8259 slave initialization */
 
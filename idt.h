@@ -12,6 +12,13 @@
 
 #define IDT_SIZE 256
 
+/* exceptions reserved by the processor, and the traps among them */
+#define EXCEPTION_COUNT 32
+#define DEBUG_VECTOR 1
+#define NMI_VECTOR 2
+#define BREAKPOINT_VECTOR 3
+#define OVERFLOW_VECTOR 4
+
 /**
  * @brief Structure to represent a single interrupt descriptor.
  * 
@@ -45,6 +52,12 @@ typedef struct idt_entry_s idt_entry_t;
  */
 typedef struct idt_r_s idt_r_t;
 
+/**
+ * @brief Base address and limit of the IDT, shared by all processors.
+ * 
+ */
+extern idt_r_t idtr;
+
 /**
  * @brief Initializes an entry in the IDT table.
  * 
@@ -62,6 +75,18 @@ void initIDTEntry(unsigned int entry, unsigned int base,
  */
 void initIDT();
 
+/**
+ * @brief Handles an exception other than a page fault or a device not
+ * available trap, called by exception_enter. A user process is killed
+ * with EXIT_FAULT. In the kernel, traps print the default message from a
+ * bottom half and return, and faults halt.
+ *
+ * @param vector The exception vector.
+ * @param error The error code, 0 if the exception has none.
+ * @param cs The code segment the exception interrupted.
+ */
+void exception(unsigned int vector, unsigned int error, unsigned int cs);
+
 /**
  * @brief Configures the Programmerable Interrupt Controller.
  * 
@@ -10,6 +10,10 @@
 
 #include "io.h"
 #include "boot2.h"
+#include "buffer.h"
+#include "mutex.h"
+#include "smp.h"
+#include "cpu.h"
 
 /* global variables for screen I/O */
 
@@ -21,7 +25,51 @@ char tab[TAB_SIZE + 1];
 char space = WHITESPACE;
 char end = NULL_TERMINATOR;
 
-void init_screen() {
+/* protects the cursor state shared by every processor */
+mutex_t screen_mutex;
+
+/**
+ * @brief Takes the screen mutex. Boot code and bottom halves can not sleep,
+ * so they spin for it, and a bottom half that interrupted the owner gives
+ * up rather than wait for a process that can not run.
+ *
+ * @return int SCREEN_LOCKED, SCREEN_UNLOCKED if there is nothing to exclude
+ * yet, or SCREEN_BUSY if the screen must be left alone.
+ */
+static int lock_screen() {
+    cpu_t* cpu = this_cpu();
+
+    /* before the idle processes exist only this processor runs */
+    if (cpu->idle == NULL) {
+        return SCREEN_UNLOCKED;
+    }
+    if (cpu->current != NULL && cpu->bh_active == FALSE) {
+        mutex_lock(&screen_mutex);
+        return SCREEN_LOCKED;
+    }
+    while (mutex_trylock(&screen_mutex) == FALSE) {
+        if (cpu->current != NULL && screen_mutex.owner == cpu->current) {
+            return SCREEN_BUSY;
+        }
+        asm volatile ("pause");
+    }
+    return SCREEN_LOCKED;
+}
+
+/**
+ * @brief Releases the screen mutex taken by lock_screen.
+ *
+ * @param locked The value returned by lock_screen.
+ */
+static void unlock_screen(int locked) {
+    if (locked == SCREEN_LOCKED) {
+        mutex_unlock(&screen_mutex);
+    }
+}
+
+INIT void init_screen() {
+    init_mutex(&screen_mutex, "screen");
+    register_lock_stat(&screen_mutex.stat);
     start_row = 0;
     current_row = 0;
     current_column = 0;
@@ -36,17 +84,39 @@ void init_screen() {
 }
 
 void clearscr() {
-    int length = NUM_COLS * NUM_ROWS;
-    char whitespace[length];
-    for (int i = 0; i < length; i++) {
+    /* one row at a time keeps this callable from a small stack */
+    char whitespace[NUM_COLS];
+    for (int i = 0; i < NUM_COLS; i++) {
         whitespace[i] = WHITESPACE;
     }
-    k_print(whitespace, length, 0, 0);
+    for (int row = 0; row < NUM_ROWS; row++) {
+        k_print(whitespace, NUM_COLS, 0, row);
+    }
     current_row = 0;
     current_column = 0;
 }
 
-void println(char* text) {
+HOT void println(char* text) {
+    int locked = lock_screen();
+    if (locked != SCREEN_BUSY) {
+        print_text(text);
+    }
+    unlock_screen(locked);
+}
+
+int println_row(char* text) {
+    int locked = lock_screen();
+    int row = current_row;
+    if (locked != SCREEN_BUSY) {
+        print_text(text);
+        row = current_row;
+        end_line();
+    }
+    unlock_screen(locked);
+    return row;
+}
+
+void print_text(char* text) {
     if (current_row > MAX_ROW) {
         k_scroll();
         current_row = MAX_ROW;
@@ -85,13 +155,23 @@ int string_size(char* ptr) {
 }
 
 void new_line() {
+    int locked = lock_screen();
+    if (locked != SCREEN_BUSY) {
+        end_line();
+    }
+    unlock_screen(locked);
+}
+
+void end_line() {
     row_tails[current_row] = current_column;
     current_column = 0;
     current_row++;
 }
 
 void backspace() {
-    if (current_row == start_row && current_column == 0) {
+    int locked = lock_screen();
+    if (locked == SCREEN_BUSY || (current_row == start_row && current_column == 0)) {
+        unlock_screen(locked);
         return;
     }
     if (current_column == 0) {
@@ -101,14 +181,20 @@ void backspace() {
     } else {
         current_column--;
     }
-    println(&space);
+    print_text(&space);
     current_column--;
+    unlock_screen(locked);
 }
 
 void tab_over() {
-    if (MAX_COL - current_column <= TAB_SIZE) {
-        new_line();
+    int locked = lock_screen();
+    if (locked == SCREEN_BUSY) {
         return;
     }
-    println(tab);
+    if (MAX_COL - current_column <= TAB_SIZE) {
+        end_line();
+    } else {
+        print_text(tab);
+    }
+    unlock_screen(locked);
 }
\ No newline at end of file
@@ -19,6 +19,11 @@
 #define WHITESPACE 32
 #define NULL_TERMINATOR 0
 
+/* results of taking the screen mutex */
+#define SCREEN_UNLOCKED 0
+#define SCREEN_LOCKED 1
+#define SCREEN_BUSY 2
+
 /**
  * @brief The starting row of video memory to use for keyboard output.
  * 
@@ -50,6 +55,21 @@ void clearscr();
  */
 void println(char* text);
 
+/**
+ * @brief Prints a line of text and returns the row it was printed on.
+ * 
+ * @param text The text to print.
+ * @return int The row of video memory the text was printed on.
+ */
+int println_row(char* text);
+
+/**
+ * @brief Prints text at the cursor. The caller must hold the screen mutex.
+ * 
+ * @param text The text to print.
+ */
+void print_text(char* text);
+
 /**
  * @brief Converts an integer to a ascii string.
  * 
@@ -81,6 +101,13 @@ int string_size(char* ptr);
  */
 void new_line();
 
+/**
+ * @brief Moves the cursor to the next line. The caller must hold the screen
+ * mutex.
+ * 
+ */
+void end_line();
+
 /**
  * @brief Deletes the last char output to the screen.
  * 
@@ -0,0 +1,197 @@
+/**
+ * @file ipc.c
+ * @author Robert McKay
+ * @brief Implements synchronous message passing with direct handoff.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "ipc.h"
+#include "boot2.h"
+#include "buffer.h"
+#include "smp.h"
+
+unsigned int ipc_handoffs;
+
+/**
+ * @brief Copies a message word by word.
+ *
+ * @param destination The message to fill.
+ * @param source The message to copy.
+ */
+static void copy_message(message_t* destination, message_t* source) {
+    destination->sender = source->sender;
+    for (int i = 0; i < IPC_WORDS; i++) {
+        destination->words[i] = source->words[i];
+    }
+}
+
+/**
+ * @brief Takes the message of a waiting sender. Called with the mailbox
+ * lock held.
+ *
+ * @param self The receiving process.
+ * @param sender The sender taken from the mailbox.
+ * @return pcb_t* The sender if it waits for a reply, NULL if it was sending
+ * and must be made ready.
+ */
+static pcb_t* take_message(pcb_t* self, pcb_t* sender) {
+    copy_message(&self->ipc_message, &sender->ipc_message);
+    if (sender->ipc_state == IPC_CALLING) {
+        return sender;
+    }
+    sender->ipc_state = IPC_NONE;
+    return NULL;
+}
+
+/**
+ * @brief Wakes the process a message was delivered to. When both are
+ * normal processes on this processor the woken process runs at once on the
+ * rest of the waker's slice, otherwise it goes through its ready queue.
+ * Called with interrupts disabled.
+ *
+ * @param self The calling process.
+ * @param target The process to wake.
+ * @param slice What was left of the caller's slice.
+ * @param self_ready TRUE if the caller stays runnable, FALSE if it has
+ * already queued itself to wait.
+ */
+static void wake(pcb_t* self, pcb_t* target, unsigned int slice, int self_ready) {
+    if (target->cpu == self->cpu && target->rt_period == 0 && self->rt_period == 0) {
+        target->slice_left = slice != 0 ? slice : target->quantum;
+        __sync_fetch_and_add(&ipc_handoffs, 1);
+        if (self_ready) {
+            make_ready(self);
+        }
+        switch_to((unsigned int)target);
+        return;
+    }
+    make_ready(target);
+    if (self_ready == FALSE) {
+        switch_process();
+    }
+}
+
+/**
+ * @brief Common part of send and call.
+ *
+ * @param mailbox The mailbox.
+ * @param message The message, replaced by the reply for a call.
+ * @param state IPC_SENDING or IPC_CALLING.
+ */
+static void deliver(mailbox_t* mailbox, message_t* message, unsigned int state) {
+    pcb_t* self = current_process();
+    unsigned int slice = self->slice_left;
+    unsigned int flags = acquire_irqsave(&mailbox->lock);
+
+    message->sender = self->pid;
+    copy_message(&self->ipc_message, message);
+    pcb_t* receiver = dequeue_process(&mailbox->receivers);
+    if (receiver == NULL) {
+        /* the receiver that takes the message wakes us (or replies) */
+        self->ipc_state = state;
+        end_slice(self);
+        enqueue_process(&mailbox->senders, self);
+        release(&mailbox->lock);
+        switch_process();
+    } else {
+        copy_message(&receiver->ipc_message, message);
+        receiver->ipc_client = state == IPC_CALLING ? self : NULL;
+        receiver->ipc_state = IPC_NONE;
+        if (state == IPC_CALLING) {
+            self->ipc_state = IPC_CALLING;
+            end_slice(self);
+        }
+        release(&mailbox->lock);
+        wake(self, receiver, slice, state == IPC_SENDING);
+    }
+
+    if (state == IPC_CALLING) {
+        copy_message(message, &self->ipc_message);
+    }
+    irq_restore(flags);
+}
+
+void init_mailbox(mailbox_t* mailbox, char* name) {
+    init_lock(&mailbox->lock, name);
+    init_queue(&mailbox->senders, name);
+    init_queue(&mailbox->receivers, name);
+}
+
+void send(mailbox_t* mailbox, message_t* message) {
+    deliver(mailbox, message, IPC_SENDING);
+}
+
+void call(mailbox_t* mailbox, message_t* message) {
+    deliver(mailbox, message, IPC_CALLING);
+}
+
+pcb_t* receive(mailbox_t* mailbox, message_t* message) {
+    pcb_t* self = current_process();
+    pcb_t* client;
+    unsigned int flags = acquire_irqsave(&mailbox->lock);
+
+    pcb_t* sender = dequeue_process(&mailbox->senders);
+    if (sender == NULL) {
+        self->ipc_state = IPC_RECEIVING;
+        end_slice(self);
+        enqueue_process(&mailbox->receivers, self);
+        release(&mailbox->lock);
+        switch_process();
+        client = self->ipc_client;
+    } else {
+        client = take_message(self, sender);
+        release(&mailbox->lock);
+        if (client == NULL) {
+            make_ready(sender);
+        }
+    }
+
+    copy_message(message, &self->ipc_message);
+    irq_restore(flags);
+    return client;
+}
+
+void reply(pcb_t* client, message_t* message) {
+    pcb_t* self = current_process();
+    unsigned int flags = irq_save();
+    message->sender = self->pid;
+    copy_message(&client->ipc_message, message);
+    client->ipc_state = IPC_NONE;
+    wake(self, client, self->slice_left, TRUE);
+    irq_restore(flags);
+}
+
+pcb_t* reply_receive(pcb_t* client, message_t* answer, mailbox_t* mailbox,
+                     message_t* message) {
+    pcb_t* self = current_process();
+    pcb_t* next;
+    unsigned int slice = self->slice_left;
+    unsigned int flags = acquire_irqsave(&mailbox->lock);
+
+    answer->sender = self->pid;
+    copy_message(&client->ipc_message, answer);
+    client->ipc_state = IPC_NONE;
+    pcb_t* sender = dequeue_process(&mailbox->senders);
+    if (sender == NULL) {
+        /* wait first, so the client can call again as soon as it runs */
+        self->ipc_state = IPC_RECEIVING;
+        end_slice(self);
+        enqueue_process(&mailbox->receivers, self);
+        release(&mailbox->lock);
+        wake(self, client, slice, FALSE);
+        next = self->ipc_client;
+    } else {
+        next = take_message(self, sender);
+        release(&mailbox->lock);
+        if (next == NULL) {
+            make_ready(sender);
+        }
+        make_ready(client);
+    }
+
+    copy_message(message, &self->ipc_message);
+    irq_restore(flags);
+    return next;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file ipc.h
+ * @author Robert McKay
+ * @brief Declares synchronous message passing through mailboxes.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef IPC_H
+#define IPC_H
+
+#include "scheduler.h"
+
+/**
+ * @brief Structure for a mailbox. Senders wait on it until a receiver
+ * takes their message, receivers wait on it until a message arrives.
+ *
+ */
+struct mailbox_s {
+    spinlock_t lock;
+    queue_t senders;
+    queue_t receivers;
+};
+
+/**
+ * @brief Type definition for a mailbox.
+ *
+ */
+typedef struct mailbox_s mailbox_t;
+
+/**
+ * @brief Number of direct handoffs, where the woken process ran at once on
+ * the rest of the waker's slice instead of going through the ready queue.
+ *
+ */
+extern unsigned int ipc_handoffs;
+
+/**
+ * @brief Initializes an empty mailbox.
+ *
+ * @param mailbox The mailbox.
+ * @param name Name of the mailbox, used in lock statistics.
+ */
+void init_mailbox(mailbox_t* mailbox, char* name);
+
+/**
+ * @brief Sends a message and waits until a receiver has taken it. A
+ * receiver already waiting on this processor runs at once on the rest of
+ * the sender's slice.
+ *
+ * @param mailbox The mailbox.
+ * @param message The message, its sender field is filled in.
+ */
+void send(mailbox_t* mailbox, message_t* message);
+
+/**
+ * @brief Waits for a message.
+ *
+ * @param mailbox The mailbox.
+ * @param message Receives the message.
+ * @return pcb_t* The process to reply to if the message came from call,
+ * NULL if it came from send.
+ */
+pcb_t* receive(mailbox_t* mailbox, message_t* message);
+
+/**
+ * @brief Sends a message and waits for the reply.
+ *
+ * @param mailbox The mailbox.
+ * @param message The message, replaced by the reply.
+ */
+void call(mailbox_t* mailbox, message_t* message);
+
+/**
+ * @brief Answers a call. A client on this processor runs at once on the
+ * rest of the caller's slice, the caller goes back to the ready queue.
+ *
+ * @param client The process returned by receive.
+ * @param message The reply.
+ */
+void reply(pcb_t* client, message_t* message);
+
+/**
+ * @brief Answers a call and waits for the next message, the usual loop of
+ * a server. Costs one switch per call instead of two when the client is on
+ * this processor.
+ *
+ * @param client The process returned by receive.
+ * @param answer The reply.
+ * @param mailbox The mailbox to receive from.
+ * @param message Receives the next message.
+ * @return pcb_t* The process to reply to next, NULL if the message came
+ * from send.
+ */
+pcb_t* reply_receive(pcb_t* client, message_t* answer, mailbox_t* mailbox,
+                     message_t* message);
+
+#endif
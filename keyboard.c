@@ -11,6 +11,8 @@
 #include "buffer.h"
 #include "scheduler.h"
 #include "process.h"
+#include "defer.h"
+#include "cpu.h"
 
 /* constants for ranges of keys */
 
@@ -28,18 +30,24 @@ static const char Z_ROW_SHIFT[] = "ZXCVBNM<>\?";
 int shift_active = FALSE;
 int caps_active = FALSE;
 
-void kbd_handler(unsigned int scancode) {
-    if (scancode == FALSE || is_full() == TRUE) {
-        return;
-    }
-    char value = translate_scancode(scancode);
-    if (value == FALSE) {
+/* scancodes waiting for the bottom half */
+irq_ring_t kbd_ring;
+
+HOT void kbd_handler(unsigned int scancode) {
+    if (scancode == FALSE) {
         return;
     }
-    enqueue_char(value);
-    if (blocked_queue.tail != NULL) {
-        pcb_t* pcb = dequeue_process(&blocked_queue);
-        enqueue_process(&ready_queue, pcb);
+    irq_ring_put(&kbd_ring, scancode);
+    raise_bottom_half(BH_KEYBOARD);
+}
+
+void kbd_bottom_half() {
+    unsigned char scancode;
+    while (irq_ring_get(&kbd_ring, &scancode) == TRUE) {
+        char value = translate_scancode(scancode);
+        if (value != FALSE) {
+            enqueue_char(value);
+        }
     }
 }
 
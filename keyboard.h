@@ -51,12 +51,20 @@
 #define Z_ROW_END 0x35
 
 /**
- * @brief Handles keyboard interrupts.
+ * @brief Handles keyboard interrupts. Only queues the scancode for
+ * kbd_bottom_half, interrupts are disabled while it runs.
  * 
  * @param scancode The scancode generated from user input.
  */
 void kbd_handler(unsigned int scancode);
 
+/**
+ * @brief Bottom half of the keyboard interrupt. Translates the queued
+ * scancodes and adds them to the keyboard buffer.
+ * 
+ */
+void kbd_bottom_half();
+
 /**
  * @brief Translates given scancode to corresponding character.
  * 
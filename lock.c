@@ -0,0 +1,118 @@
+/**
+ * @file lock.c
+ * @author Robert McKay
+ * @brief Implements spinlocks, ticket locks and interrupt save/restore.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "lock.h"
+#include "cpu.h"
+
+lock_stat_t* lock_stats[MAX_LOCK_STATS];
+unsigned int lock_stat_count;
+unsigned int lock_stats_dropped;
+
+/**
+ * @brief Serializes register_lock_stat. Zero is unlocked, so it needs no
+ * initialization, and it is not registered itself.
+ *
+ */
+static spinlock_t lock_stats_lock;
+
+void init_lock(spinlock_t* lock, char* name) {
+    lock->locked = UNLOCKED;
+    init_lock_stat(&lock->stat, name);
+}
+
+HOT void acquire(spinlock_t* lock) {
+    unsigned long long start;
+    if (__sync_lock_test_and_set(&lock->locked, LOCKED) != UNLOCKED) {
+        /* spin on reads so waiters share the line until it is released */
+        start = rdtsc();
+        do {
+            while (lock->locked != UNLOCKED) {
+                asm volatile ("pause");
+            }
+        } while (__sync_lock_test_and_set(&lock->locked, LOCKED) != UNLOCKED);
+        lock->stat.contended++;
+        lock->stat.wait_cycles += rdtsc() - start;
+    }
+    lock->stat.acquired++;
+}
+
+HOT void release(spinlock_t* lock) {
+    __sync_lock_release(&lock->locked);
+}
+
+HOT unsigned int acquire_irqsave(spinlock_t* lock) {
+    unsigned int flags = irq_save();
+    acquire(lock);
+    return flags;
+}
+
+HOT void release_irqrestore(spinlock_t* lock, unsigned int flags) {
+    release(lock);
+    irq_restore(flags);
+}
+
+void init_ticket_lock(ticket_lock_t* lock, char* name) {
+    lock->next = 0;
+    lock->serving = 0;
+    init_lock_stat(&lock->stat, name);
+}
+
+HOT void acquire_ticket(ticket_lock_t* lock) {
+    unsigned long long start;
+    unsigned int ticket = __sync_fetch_and_add(&lock->next, 1);
+    if (lock->serving != ticket) {
+        start = rdtsc();
+        while (lock->serving != ticket) {
+            asm volatile ("pause");
+        }
+        lock->stat.contended++;
+        lock->stat.wait_cycles += rdtsc() - start;
+    }
+    lock->stat.acquired++;
+}
+
+HOT void release_ticket(ticket_lock_t* lock) {
+    /* only the holder writes serving, stores are not reordered on x86 */
+    asm volatile ("" : : : "memory");
+    lock->serving = lock->serving + 1;
+}
+
+HOT unsigned int acquire_ticket_irqsave(ticket_lock_t* lock) {
+    unsigned int flags = irq_save();
+    acquire_ticket(lock);
+    return flags;
+}
+
+HOT void release_ticket_irqrestore(ticket_lock_t* lock, unsigned int flags) {
+    release_ticket(lock);
+    irq_restore(flags);
+}
+
+void init_lock_stat(lock_stat_t* stat, char* name) {
+    stat->name = name;
+    stat->acquired = 0;
+    stat->contended = 0;
+    stat->wait_cycles = 0;
+}
+
+void register_lock_stat(lock_stat_t* stat) {
+    unsigned int flags = acquire_irqsave(&lock_stats_lock);
+    for (unsigned int i = 0; i < lock_stat_count; i++) {
+        if (lock_stats[i] == stat) {
+            release_irqrestore(&lock_stats_lock, flags);
+            return;
+        }
+    }
+    if (lock_stat_count < MAX_LOCK_STATS) {
+        lock_stats[lock_stat_count++] = stat;
+    } else {
+        lock_stats_dropped++;
+    }
+    release_irqrestore(&lock_stats_lock, flags);
+}
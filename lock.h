@@ -0,0 +1,204 @@
+/**
+ * @file lock.h
+ * @author Robert McKay
+ * @brief Declares spinlocks, ticket locks and interrupt save/restore for
+ * data shared between processors and interrupt handlers.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef LOCK_H
+#define LOCK_H
+
+#define UNLOCKED 0
+#define LOCKED 1
+
+/* maximum number of locks reported by lock_stats */
+#define MAX_LOCK_STATS 64
+
+/**
+ * @brief Contention counters of a lock, updated by the holder.
+ *
+ */
+struct lock_stat_s {
+    char* name;
+    unsigned int acquired;
+    unsigned int contended;
+    unsigned long long wait_cycles;
+};
+
+/**
+ * @brief Type definition for lock contention counters.
+ *
+ */
+typedef struct lock_stat_s lock_stat_t;
+
+/**
+ * @brief Structure for a test-and-test-and-set spinlock.
+ *
+ */
+struct spinlock_s {
+    volatile unsigned int locked;
+    lock_stat_t stat;
+};
+
+/**
+ * @brief Type definition for a spinlock.
+ *
+ */
+typedef struct spinlock_s spinlock_t;
+
+/**
+ * @brief Structure for a ticket lock, which grants the lock in arrival order.
+ *
+ */
+struct ticket_lock_s {
+    volatile unsigned int next;
+    volatile unsigned int serving;
+    lock_stat_t stat;
+};
+
+/**
+ * @brief Type definition for a ticket lock.
+ *
+ */
+typedef struct ticket_lock_s ticket_lock_t;
+
+/**
+ * @brief Counters of the locks passed to register_lock_stat, in
+ * registration order.
+ *
+ */
+extern lock_stat_t* lock_stats[MAX_LOCK_STATS];
+
+/**
+ * @brief Number of entries in lock_stats.
+ *
+ */
+extern unsigned int lock_stat_count;
+
+/**
+ * @brief Locks register_lock_stat had no room for in lock_stats.
+ *
+ */
+extern unsigned int lock_stats_dropped;
+
+/**
+ * @brief Disables interrupts and returns the previous flags.
+ *
+ * @return unsigned int The eflags register before interrupts were disabled.
+ */
+static inline unsigned int irq_save() {
+    unsigned int flags;
+    asm volatile ("pushf; pop %0; cli" : "=r" (flags) : : "memory");
+    return flags;
+}
+
+/**
+ * @brief Restores the flags returned by irq_save, re-enabling interrupts
+ * only if they were enabled before.
+ *
+ * @param flags The value returned by irq_save.
+ */
+static inline void irq_restore(unsigned int flags) {
+    asm volatile ("push %0; popf" : : "r" (flags) : "memory", "cc");
+}
+
+/**
+ * @brief Initializes a spinlock to the unlocked state.
+ *
+ * @param lock The lock to initialize.
+ * @param name Name reported with the lock's counters.
+ */
+void init_lock(spinlock_t* lock, char* name);
+
+/**
+ * @brief Spins until the lock is acquired. Use acquire_irqsave if an
+ * interrupt handler may take the same lock.
+ *
+ * @param lock The lock to acquire.
+ */
+void acquire(spinlock_t* lock);
+
+/**
+ * @brief Releases a lock held by the caller.
+ *
+ * @param lock The lock to release.
+ */
+void release(spinlock_t* lock);
+
+/**
+ * @brief Disables interrupts and acquires the lock.
+ *
+ * @param lock The lock to acquire.
+ * @return unsigned int The flags to pass to release_irqrestore.
+ */
+unsigned int acquire_irqsave(spinlock_t* lock);
+
+/**
+ * @brief Releases the lock and restores the flags from acquire_irqsave.
+ *
+ * @param lock The lock to release.
+ * @param flags The value returned by acquire_irqsave.
+ */
+void release_irqrestore(spinlock_t* lock, unsigned int flags);
+
+/**
+ * @brief Initializes a ticket lock to the unlocked state.
+ *
+ * @param lock The lock to initialize.
+ * @param name Name reported with the lock's counters.
+ */
+void init_ticket_lock(ticket_lock_t* lock, char* name);
+
+/**
+ * @brief Takes a ticket and spins until it is served.
+ *
+ * @param lock The lock to acquire.
+ */
+void acquire_ticket(ticket_lock_t* lock);
+
+/**
+ * @brief Serves the next ticket.
+ *
+ * @param lock The lock to release.
+ */
+void release_ticket(ticket_lock_t* lock);
+
+/**
+ * @brief Disables interrupts and acquires the ticket lock.
+ *
+ * @param lock The lock to acquire.
+ * @return unsigned int The flags to pass to release_ticket_irqrestore.
+ */
+unsigned int acquire_ticket_irqsave(ticket_lock_t* lock);
+
+/**
+ * @brief Releases the ticket lock and restores the flags from
+ * acquire_ticket_irqsave.
+ *
+ * @param lock The lock to release.
+ * @param flags The value returned by acquire_ticket_irqsave.
+ */
+void release_ticket_irqrestore(ticket_lock_t* lock, unsigned int flags);
+
+/**
+ * @brief Clears a lock's counters. They are only reported once the lock is
+ * registered with register_lock_stat.
+ *
+ * @param stat The counters to clear.
+ * @param name Name reported with the counters.
+ */
+void init_lock_stat(lock_stat_t* stat, char* name);
+
+/**
+ * @brief Adds a lock's counters to lock_stats, once. Entries are never
+ * removed, so only locks that live as long as the kernel are registered,
+ * not those of mailboxes, channels or images.
+ *
+ * @param stat The counters to add.
+ */
+void register_lock_stat(lock_stat_t* stat);
+
+#endif
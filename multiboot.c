@@ -0,0 +1,57 @@
+/**
+ * @file multiboot.c
+ * @author Robert McKay
+ * @brief Implements the Multiboot boot path.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "multiboot.h"
+#include "buffer.h"
+#include "pmm.h"
+#include "cpu.h"
+
+int multiboot_booted = FALSE;
+
+/**
+ * @brief Appends a region to the E820 map if there is room.
+ *
+ * @param map The map.
+ * @param base Start of the region.
+ * @param length Length of the region in bytes.
+ * @param type E820 type of the region.
+ */
+INIT static void add_region(e820_map_t* map, unsigned long long base,
+                            unsigned long long length, unsigned int type) {
+    if (map->count == E820_MAX || length == 0) {
+        return;
+    }
+    e820_entry_t* entry = &map->entries[map->count];
+    entry->base = base;
+    entry->length = length;
+    entry->type = type;
+    entry->attributes = 1;
+    map->count++;
+}
+
+INIT void multiboot_memory_map(multiboot_info_t* info) {
+    e820_map_t* map = (e820_map_t*)E820_ADDRESS;
+    multiboot_mmap_t* entry;
+    unsigned int end = info->mmap_addr + info->mmap_length;
+
+    multiboot_booted = TRUE;
+    map->count = 0;
+    if (info->flags & MULTIBOOT_INFO_MMAP) {
+        /* an entry's size does not count the size field itself */
+        for (unsigned int address = info->mmap_addr; address < end;
+             address += entry->size + sizeof(entry->size)) {
+            entry = (multiboot_mmap_t*)address;
+            add_region(map, entry->base, entry->length, entry->type);
+        }
+    } else if (info->flags & MULTIBOOT_INFO_MEMORY) {
+        /* KB below 640 KB and from 1 MB up to the first hole */
+        add_region(map, 0, info->mem_lower * 1024ULL, E820_USABLE);
+        add_region(map, PMM_LOW_LIMIT, info->mem_upper * 1024ULL, E820_USABLE);
+    }
+}
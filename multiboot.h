@@ -0,0 +1,87 @@
+/**
+ * @file multiboot.h
+ * @author Robert McKay
+ * @brief Declares the Multiboot boot path. A Multiboot loader (qemu
+ * -kernel, GRUB) loads boot2.exe directly instead of boot1 reading BOOT2
+ * from the floppy, and the memory map comes from its info structure instead
+ * of the BIOS.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef MULTIBOOT_H
+#define MULTIBOOT_H
+
+/* header in the first 8 KB of boot2.exe, asking for the memory map (must
+   match boot2.S) */
+#define MULTIBOOT_HEADER_MAGIC 0x1badb002
+#define MULTIBOOT_MEMORY_INFO 0x2
+#define MULTIBOOT_HEADER_FLAGS MULTIBOOT_MEMORY_INFO
+
+/* eax at kernel_entry when a Multiboot loader started the kernel (must
+   match boot2.S) */
+#define MULTIBOOT_BOOTLOADER_MAGIC 0x2badb002
+
+/* info structure flags: mem_lower and mem_upper, mmap_addr and mmap_length */
+#define MULTIBOOT_INFO_MEMORY 0x1
+#define MULTIBOOT_INFO_MMAP 0x40
+
+/**
+ * @brief Info structure the loader passes in ebx, up to the memory map.
+ *
+ */
+struct multiboot_info_s {
+    unsigned int flags;
+    unsigned int mem_lower;
+    unsigned int mem_upper;
+    unsigned int boot_device;
+    unsigned int cmdline;
+    unsigned int mods_count;
+    unsigned int mods_addr;
+    unsigned int syms[4];
+    unsigned int mmap_length;
+    unsigned int mmap_addr;
+} __attribute__ ((packed));
+
+/**
+ * @brief Type definition for the Multiboot info structure.
+ *
+ */
+typedef struct multiboot_info_s multiboot_info_t;
+
+/**
+ * @brief Memory map entry, preceded by its size. Types are the E820 types.
+ *
+ */
+struct multiboot_mmap_s {
+    unsigned int size;
+    unsigned long long base;
+    unsigned long long length;
+    unsigned int type;
+} __attribute__ ((packed));
+
+/**
+ * @brief Type definition for a Multiboot memory map entry.
+ *
+ */
+typedef struct multiboot_mmap_s multiboot_mmap_t;
+
+/**
+ * @brief TRUE if the kernel was started by a Multiboot loader, FALSE if by
+ * boot1.
+ *
+ */
+extern int multiboot_booted;
+
+/**
+ * @brief Fills the E820 map at E820_ADDRESS from the Multiboot info, in
+ * place of read_e820. Called by kernel_entry before main. Falls back to
+ * mem_lower and mem_upper without a memory map, and leaves the map empty
+ * (so init_pmm assumes memory) without either.
+ *
+ * @param info The info structure from ebx.
+ */
+void multiboot_memory_map(multiboot_info_t* info);
+
+#endif
@@ -0,0 +1,194 @@
+/**
+ * @file mutex.c
+ * @author Robert McKay
+ * @brief Implements sleeping kernel mutexes with adaptive spinning and
+ * priority inheritance.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "mutex.h"
+#include "boot2.h"
+#include "buffer.h"
+#include "cpu.h"
+#include "smp.h"
+
+/**
+ * @brief Returns the process the caller acts as.
+ *
+ * @return pcb_t* The current process, or the idle process before any
+ * process has run.
+ */
+static pcb_t* mutex_self() {
+    pcb_t* pcb = current_process();
+    if (pcb == NULL) {
+        pcb = this_cpu()->idle;
+    }
+    return pcb;
+}
+
+/**
+ * @brief Tells whether the owner of a mutex is on a processor right now,
+ * in which case it will likely release the mutex soon.
+ *
+ * @param owner The owner.
+ * @return int TRUE if it is running.
+ */
+static int owner_running(pcb_t* owner) {
+    return owner->cpu != CPU_ANY && cpus[owner->cpu].current == owner;
+}
+
+/**
+ * @brief Raises the priority of a mutex owner, and of the owners it waits
+ * on in turn, to at least the given priority. A raised owner waiting in a
+ * ready queue moves ahead of normal processes.
+ *
+ * @param owner The owner, may be NULL.
+ * @param priority The priority of the waiter.
+ */
+static void inherit_priority(pcb_t* owner, unsigned int priority) {
+    for (int depth = 0; owner != NULL && depth < MUTEX_CHAIN_MAX; depth++) {
+        if (owner->priority >= priority) {
+            return;
+        }
+        owner->priority = priority;
+        if (owner->rt_period == 0 && owner->cpu != CPU_ANY
+            && remove_process(&cpus[owner->cpu].ready_queue, owner) == TRUE) {
+            make_ready(owner);
+        }
+        mutex_t* next = owner->mutex_wait;
+        owner = next == NULL ? NULL : next->owner;
+    }
+}
+
+/**
+ * @brief Finds the waiter with the highest priority, the first to arrive
+ * among equals.
+ *
+ * @param queue The wait queue.
+ * @return pcb_t* The waiter, or NULL if the queue is empty.
+ */
+static pcb_t* highest_waiter(queue_t* queue) {
+    pcb_t* highest = NULL;
+    unsigned int flags = acquire_ticket_irqsave(&queue->lock);
+    for (node_t* node = queue->head; node != NULL; node = node->next) {
+        if (highest == NULL || node->pcb->priority > highest->priority) {
+            highest = node->pcb;
+        }
+    }
+    release_ticket_irqrestore(&queue->lock, flags);
+    return highest;
+}
+
+/**
+ * @brief Contended part of mutex_lock.
+ *
+ * @param mutex The mutex.
+ * @param self The calling process.
+ */
+static void mutex_lock_slow(mutex_t* mutex, pcb_t* self) {
+    unsigned long long start = rdtsc();
+    unsigned long long spin_start = start;
+    int slept = FALSE;
+
+    while (TRUE) {
+        pcb_t* owner = mutex->owner;
+        if (owner == NULL) {
+            if (__sync_bool_compare_and_swap(&mutex->owner, NULL, self)) {
+                break;
+            }
+            continue;
+        }
+        if (owner_running(owner) && rdtsc() - spin_start < MUTEX_SPIN_CYCLES) {
+            asm volatile ("pause");
+            continue;
+        }
+
+        /* count as waiting before the last look, unlock checks the count
+           after clearing the owner, so one of the two sees the other */
+        unsigned int flags = acquire_irqsave(&mutex->lock);
+        mutex->waiting++;
+        __sync_synchronize();
+        if (__sync_bool_compare_and_swap(&mutex->owner, NULL, self)) {
+            mutex->waiting--;
+            release_irqrestore(&mutex->lock, flags);
+            break;
+        }
+        inherit_priority(mutex->owner, self->priority);
+        self->mutex_wait = mutex;
+        slept = TRUE;
+        block_process((unsigned int)&mutex->waiters, (unsigned int)&mutex->lock);
+        self->mutex_wait = NULL;
+        irq_restore(flags);
+        spin_start = rdtsc();
+    }
+
+    /* the counters belong to the holder, like a spinlock's */
+    self->mutexes_held++;
+    mutex->stat.acquired++;
+    mutex->stat.contended++;
+    mutex->stat.wait_cycles += rdtsc() - start;
+    if (slept == TRUE) {
+        mutex->sleeps++;
+    } else {
+        mutex->spins++;
+    }
+}
+
+void init_mutex(mutex_t* mutex, char* name) {
+    mutex->owner = NULL;
+    mutex->waiting = 0;
+    mutex->spins = 0;
+    mutex->sleeps = 0;
+    init_lock(&mutex->lock, name);
+    init_queue(&mutex->waiters, name);
+    init_lock_stat(&mutex->stat, name);
+}
+
+void mutex_lock(mutex_t* mutex) {
+    pcb_t* self = current_process();
+    if (__sync_bool_compare_and_swap(&mutex->owner, NULL, self)) {
+        self->mutexes_held++;
+        mutex->stat.acquired++;
+        return;
+    }
+    mutex_lock_slow(mutex, self);
+}
+
+int mutex_trylock(mutex_t* mutex) {
+    pcb_t* self = mutex_self();
+    if (__sync_bool_compare_and_swap(&mutex->owner, NULL, self) == FALSE) {
+        return FALSE;
+    }
+    self->mutexes_held++;
+    mutex->stat.acquired++;
+    return TRUE;
+}
+
+void mutex_unlock(mutex_t* mutex) {
+    pcb_t* self = mutex->owner;
+    pcb_t* free = NULL;
+    pcb_t* pcb = NULL;
+    self->mutexes_held--;
+
+    /* xchg is locked, so the load of waiting can not pass the store */
+    asm volatile ("xchgl %0, %1" : "+r" (free), "+m" (mutex->owner) : : "memory");
+    if (mutex->waiting != 0) {
+        unsigned int flags = acquire_irqsave(&mutex->lock);
+        if (mutex->waiting != 0) {
+            pcb = highest_waiter(&mutex->waiters);
+            remove_process(&mutex->waiters, pcb);
+            mutex->waiting--;
+        }
+        release_irqrestore(&mutex->lock, flags);
+        if (pcb != NULL) {
+            make_ready(pcb);
+        }
+    }
+
+    /* any boost was applied under the lock taken above */
+    if (self->mutexes_held == 0 && self->priority != self->base_priority) {
+        self->priority = self->base_priority;
+    }
+}
@@ -0,0 +1,83 @@
+/**
+ * @file mutex.h
+ * @author Robert McKay
+ * @brief Declares sleeping kernel mutexes with adaptive spinning and
+ * priority inheritance.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef MUTEX_H
+#define MUTEX_H
+
+#include "lock.h"
+#include "process.h"
+#include "scheduler.h"
+
+/* cycles a waiter spins while the owner is running before it sleeps */
+#define MUTEX_SPIN_CYCLES 20000
+
+/* owners followed when passing on an inherited priority */
+#define MUTEX_CHAIN_MAX 8
+
+/**
+ * @brief Structure for a mutex. The owner field is the lock: taking and
+ * releasing an uncontended mutex is one locked instruction each. The
+ * spinlock only guards the wait queue.
+ *
+ */
+struct mutex_s {
+    pcb_t* volatile owner;
+    volatile unsigned int waiting;
+    spinlock_t lock;
+    queue_t waiters;
+    lock_stat_t stat;
+    unsigned int spins;
+    unsigned int sleeps;
+};
+
+/**
+ * @brief Type definition for a mutex.
+ *
+ */
+typedef struct mutex_s mutex_t;
+
+/**
+ * @brief Initializes a mutex to the unlocked state.
+ *
+ * @param mutex The mutex to initialize.
+ * @param name Name reported with the mutex's counters.
+ */
+void init_mutex(mutex_t* mutex, char* name);
+
+/**
+ * @brief Acquires the mutex. While the owner is running on another
+ * processor the caller spins, otherwise it sleeps on the wait queue and
+ * lends the owner its priority until the mutex is released. Must be called
+ * from a process, never from a bottom half.
+ *
+ * @param mutex The mutex to acquire.
+ */
+void mutex_lock(mutex_t* mutex);
+
+/**
+ * @brief Acquires the mutex only if it is free. Code running before any
+ * process (which has no process to sleep) holds it as its processor's idle
+ * process.
+ *
+ * @param mutex The mutex to acquire.
+ * @return int TRUE if the mutex was acquired.
+ */
+int mutex_trylock(mutex_t* mutex);
+
+/**
+ * @brief Releases a mutex held by the caller and wakes the waiter with the
+ * highest priority. The caller drops back to its base priority once it
+ * holds no other mutex.
+ *
+ * @param mutex The mutex to release.
+ */
+void mutex_unlock(mutex_t* mutex);
+
+#endif
@@ -0,0 +1,552 @@
+/**
+ * @file paging.c
+ * @author Robert McKay
+ * @brief Implements the kernel page directory and functions to map pages.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "paging.h"
+#include "acpi.h"
+#include "buffer.h"
+#include "cpu.h"
+#include "elf.h"
+#include "io.h"
+#include "lock.h"
+#include "pmm.h"
+#include "process.h"
+#include "scheduler.h"
+#include "smp.h"
+
+unsigned int* kernel_directory;
+unsigned int kernel_top;
+unsigned int global_flag;
+unsigned int cow_copies;
+unsigned int fork_pages;
+unsigned int init_pages_freed;
+
+/**
+ * @brief TRUE if the processor supports 4 MB pages.
+ *
+ */
+int large_pages;
+
+/**
+ * @brief CR4 bits set on every processor before paging is turned on.
+ *
+ */
+unsigned int cr4_flags;
+
+/**
+ * @brief Protects the page directories and tables.
+ *
+ */
+spinlock_t paging_lock CACHE_ALIGNED;
+
+/**
+ * @brief Directories sharing each page after a fork, besides the first,
+ * indexed by page number. Covers the identity mapped memory pages are
+ * allocated from. A whole word each, every fork adds one and a process
+ * could fork more times than a byte counts.
+ *
+ */
+unsigned int* page_shares;
+
+/**
+ * @brief Page aligned end of the code, read-only data and USER_READ
+ * variables, set by the linker.
+ *
+ */
+extern char __user_end[];
+
+/**
+ * @brief Page aligned bounds of the INIT functions, set by the linker.
+ *
+ */
+extern char __init_start[];
+extern char __init_end[];
+
+/**
+ * @brief Copies a page with rep movsl.
+ *
+ * @param destination The page to copy to.
+ * @param source The page to copy from.
+ */
+static inline void copy_page(unsigned int destination, unsigned int source) {
+    unsigned int count = PAGE_SIZE / sizeof(unsigned int);
+    asm volatile ("rep movsl"
+                  : "+D" (destination), "+S" (source), "+c" (count)
+                  : : "memory");
+}
+
+/**
+ * @brief Drops a directory's reference to a private page.
+ *
+ * @param page The page.
+ * @return int TRUE if it was the last reference, so the page can be freed.
+ */
+static int drop_share(unsigned int page) {
+    unsigned int* shares = &page_shares[page >> PAGE_SHIFT];
+    unsigned int count;
+    do {
+        count = *shares;
+        if (count == 0) {
+            return TRUE;
+        }
+    } while (__sync_bool_compare_and_swap(shares, count, count - 1) == FALSE);
+    return FALSE;
+}
+
+/**
+ * @brief Allocates a page and clears it.
+ *
+ * @return unsigned int* The page, NULL if out of memory.
+ */
+static unsigned int* alloc_table() {
+    unsigned int* table = (unsigned int*)alloc_page();
+    if (table != NULL) {
+        for (int i = 0; i < PAGE_ENTRIES; i++) {
+            table[i] = 0;
+        }
+    }
+    return table;
+}
+
+INIT int init_paging() {
+    e820_map_t* map = (e820_map_t*)E820_ADDRESS;
+    e820_entry_t* entry;
+    unsigned long long top = 0;
+    unsigned long long end;
+    unsigned int regs[4];
+
+    init_lock(&paging_lock, "page tables");
+    register_lock_stat(&paging_lock.stat);
+    cpuid(1, regs);
+    large_pages = (regs[3] & CPUID_EDX_PSE) != 0;
+    global_flag = (regs[3] & CPUID_EDX_PGE) ? PAGE_GLOBAL : 0;
+    cr4_flags = (large_pages ? CR4_PSE : 0) | (global_flag ? CR4_PGE : 0);
+
+    kernel_directory = alloc_table();
+    if (kernel_directory == NULL) {
+        return FALSE;
+    }
+
+    /* everything but reserved ranges, including the ACPI tables */
+    for (unsigned int i = 0; i < map->count; i++) {
+        entry = &map->entries[i];
+        end = entry->base + entry->length;
+        if (entry->type != E820_RESERVED && end > top) {
+            top = end;
+        }
+    }
+    top = (top + LARGE_PAGE_SIZE - 1) & ~(unsigned long long)(LARGE_PAGE_SIZE - 1);
+    kernel_top = top > KERNEL_TOP_MAX ? KERNEL_TOP_MAX : top;
+
+    /* memory above is not identity mapped, so it can not be handed out */
+    mark_region(kernel_top, top - kernel_top, TRUE);
+
+    unsigned int share_count = kernel_top >> PAGE_SHIFT;
+    unsigned int share_pages = (share_count * sizeof(unsigned int) + PAGE_SIZE - 1) / PAGE_SIZE;
+    page_shares = (unsigned int*)alloc_pages(share_pages);
+    if (page_shares == NULL) {
+        kernel_directory = NULL;
+        return FALSE;
+    }
+    for (unsigned int i = 0; i < share_count; i++) {
+        page_shares[i] = 0;
+    }
+
+    if (map_low_memory(kernel_directory) == FALSE) {
+        kernel_directory = NULL;
+        return FALSE;
+    }
+    for (unsigned int address = LARGE_PAGE_SIZE; address < kernel_top; address += LARGE_PAGE_SIZE) {
+        if (identity_map(kernel_directory, address, PAGE_WRITE | global_flag) == FALSE) {
+            kernel_directory = NULL;
+            return FALSE;
+        }
+    }
+
+    /* device registers must not be cached */
+    identity_map(kernel_directory, lapic_address,
+                 PAGE_WRITE | PAGE_CACHE_DISABLE | PAGE_WRITE_THROUGH | global_flag);
+    if (ioapic_address != 0) {
+        identity_map(kernel_directory, ioapic_address,
+                     PAGE_WRITE | PAGE_CACHE_DISABLE | PAGE_WRITE_THROUGH | global_flag);
+    }
+
+    load_paging();
+    return TRUE;
+}
+
+void load_paging() {
+    if (kernel_directory == NULL) {
+        return;
+    }
+    write_cr4(read_cr4() | cr4_flags);
+    write_cr3((unsigned int)kernel_directory);
+    write_cr0((read_cr0() | CR0_PG) & ~CR0_WP);
+}
+
+INIT int map_low_memory(unsigned int* directory) {
+    unsigned int* table = alloc_table();
+    unsigned int address;
+    unsigned int flags;
+    if (table == NULL) {
+        return FALSE;
+    }
+    for (unsigned int i = 0; i < PAGE_ENTRIES; i++) {
+        address = i << PAGE_SHIFT;
+        flags = PAGE_WRITE | global_flag;
+        if (address >= KERNEL_BASE && address < (unsigned int)__user_end) {
+            flags = PAGE_USER | global_flag;
+        }
+        table[i] = address | flags | PAGE_PRESENT;
+    }
+    directory[0] = (unsigned int)table | PAGE_USER | PAGE_WRITE | PAGE_PRESENT;
+    return TRUE;
+}
+
+void free_init_text() {
+    unsigned int start = (unsigned int)__init_start;
+    unsigned int count = ((unsigned int)__init_end - start) / PAGE_SIZE;
+    if (count == 0) {
+        return;
+    }
+
+    /* the pages are already mapped like any other kernel page (above
+       __user_end), so no processor holds a TLB entry that goes stale */
+    free_pages(start, count);
+    init_pages_freed = count;
+}
+
+int identity_map(unsigned int* directory, unsigned int address, unsigned int flags) {
+    unsigned int index = address >> LARGE_PAGE_SHIFT;
+    unsigned int base = index << LARGE_PAGE_SHIFT;
+    unsigned int* table;
+
+    if (directory[index] & PAGE_PRESENT) {
+        return TRUE;
+    }
+    if (large_pages) {
+        directory[index] = base | flags | PAGE_LARGE | PAGE_PRESENT;
+        return TRUE;
+    }
+    table = alloc_table();
+    if (table == NULL) {
+        return FALSE;
+    }
+    for (unsigned int i = 0; i < PAGE_ENTRIES; i++) {
+        table[i] = (base + (i << PAGE_SHIFT)) | flags | PAGE_PRESENT;
+    }
+    directory[index] = (unsigned int)table | PAGE_WRITE | PAGE_PRESENT;
+    return TRUE;
+}
+
+unsigned int* page_table(unsigned int* directory, unsigned int address, int create) {
+    unsigned int* entry = &directory[address >> LARGE_PAGE_SHIFT];
+    unsigned int* table;
+
+    if (*entry & PAGE_PRESENT) {
+        if (*entry & PAGE_LARGE) {
+            return NULL;
+        }
+        return (unsigned int*)(*entry & PAGE_FRAME);
+    }
+    if (create == FALSE) {
+        return NULL;
+    }
+    table = alloc_table();
+    if (table == NULL) {
+        return NULL;
+    }
+
+    /* access is decided by the page table entries */
+    *entry = (unsigned int)table | PAGE_USER | PAGE_WRITE | PAGE_PRESENT;
+    return table;
+}
+
+int map_page(unsigned int* directory, unsigned int address,
+             unsigned int physical, unsigned int flags) {
+    unsigned int irq_flags = acquire_irqsave(&paging_lock);
+    unsigned int* table = page_table(directory, address, TRUE);
+    if (table == NULL) {
+        release_irqrestore(&paging_lock, irq_flags);
+        return FALSE;
+    }
+    table[(address >> PAGE_SHIFT) & (PAGE_ENTRIES - 1)] =
+        (physical & PAGE_FRAME) | flags | PAGE_PRESENT;
+    invlpg(address);
+    release_irqrestore(&paging_lock, irq_flags);
+    return TRUE;
+}
+
+void unmap_page(unsigned int* directory, unsigned int address) {
+    unsigned int irq_flags = acquire_irqsave(&paging_lock);
+    unsigned int* table = page_table(directory, address, FALSE);
+    if (table != NULL) {
+        table[(address >> PAGE_SHIFT) & (PAGE_ENTRIES - 1)] = 0;
+        invlpg(address);
+    }
+    release_irqrestore(&paging_lock, irq_flags);
+}
+
+/**
+ * @brief Checks that a range is mapped for user mode access with the given
+ * flags in the current page directory. Pages of a process's image not yet
+ * touched count with the flags they will be mapped with.
+ *
+ * @param address Start of the range.
+ * @param length Length of the range in bytes.
+ * @param wanted PAGE_USER, with PAGE_WRITE to require writable pages.
+ * @return int TRUE if every page of the range has the flags.
+ */
+static int user_range(unsigned int address, unsigned int length, unsigned int wanted) {
+    unsigned int end = address + length;
+    unsigned int* directory = (unsigned int*)read_cr3();
+    unsigned int entry;
+    unsigned int page;
+
+    if (kernel_directory == NULL) {
+        return TRUE;
+    }
+    if (end < address) {
+        return FALSE;
+    }
+    wanted |= PAGE_PRESENT;
+    for (page = address & PAGE_FRAME; page < end; page += PAGE_SIZE) {
+        entry = directory[page >> LARGE_PAGE_SHIFT];
+        if ((entry & (PAGE_PRESENT | PAGE_LARGE)) == PAGE_PRESENT) {
+            if ((entry & PAGE_USER) == 0) {
+                return FALSE;
+            }
+            entry = ((unsigned int*)(entry & PAGE_FRAME))[(page >> PAGE_SHIFT) & (PAGE_ENTRIES - 1)];
+        }
+        if ((entry & PAGE_PRESENT) == 0) {
+            entry = elf_page_flags(current_process(), page);
+        } else if (entry & PAGE_COW) {
+            entry |= PAGE_WRITE;
+        }
+        if ((entry & wanted) != wanted) {
+            return FALSE;
+        }
+        if (page == PAGE_FRAME) {
+            break;
+        }
+    }
+    return TRUE;
+}
+
+int user_accessible(unsigned int address, unsigned int length) {
+    return user_range(address, length, PAGE_USER);
+}
+
+int user_writable(unsigned int address, unsigned int length) {
+    unsigned int* directory = (unsigned int*)read_cr3();
+    unsigned int* table;
+    unsigned int entry;
+
+    if (user_range(address, length, PAGE_USER | PAGE_WRITE) == FALSE) {
+        return FALSE;
+    }
+    for (unsigned int page = address & PAGE_FRAME; page < address + length; page += PAGE_SIZE) {
+        if (page < USER_BASE || page >= USER_TOP) {
+            continue;
+        }
+        table = page_table(directory, page, FALSE);
+        entry = table != NULL ? table[(page >> PAGE_SHIFT) & (PAGE_ENTRIES - 1)] : 0;
+
+        /* fault image pages in now, the caller may write them holding the
+           file system locks elf_fault takes */
+        if ((entry & PAGE_PRESENT) == 0) {
+            if (elf_fault(current_process(), page) == FALSE) {
+                return FALSE;
+            }
+        } else if ((entry & PAGE_COW) && unshare_page(directory, page) == FALSE) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+void flush_tlb() {
+    write_cr3(read_cr3());
+}
+
+unsigned int* new_directory() {
+    unsigned int* directory = alloc_table();
+    if (directory == NULL) {
+        return NULL;
+    }
+    unsigned int flags = acquire_irqsave(&paging_lock);
+    for (unsigned int i = 0; i < PAGE_ENTRIES; i++) {
+        if (i < USER_BASE >> LARGE_PAGE_SHIFT || i >= USER_TOP >> LARGE_PAGE_SHIFT) {
+            directory[i] = kernel_directory[i];
+        }
+    }
+    release_irqrestore(&paging_lock, flags);
+    return directory;
+}
+
+unsigned int* fork_directory(unsigned int* directory, int copy) {
+    unsigned int* child = new_directory();
+    unsigned int* table;
+    unsigned int* child_table;
+    unsigned int entry;
+    unsigned int page;
+
+    if (child == NULL) {
+        return NULL;
+    }
+    fork_pages++;
+    for (unsigned int i = USER_BASE >> LARGE_PAGE_SHIFT; i < USER_TOP >> LARGE_PAGE_SHIFT; i++) {
+        if ((directory[i] & PAGE_PRESENT) == 0) {
+            continue;
+        }
+        table = (unsigned int*)(directory[i] & PAGE_FRAME);
+        child_table = alloc_table();
+        if (child_table == NULL) {
+            free_directory(child);
+            return NULL;
+        }
+        child[i] = (unsigned int)child_table | PAGE_USER | PAGE_WRITE | PAGE_PRESENT;
+        fork_pages++;
+        for (unsigned int j = 0; j < PAGE_ENTRIES; j++) {
+            entry = table[j];
+            if ((entry & (PAGE_PRESENT | PAGE_SHARED)) != PAGE_PRESENT) {
+                child_table[j] = entry;
+            } else if (copy) {
+                page = alloc_page();
+                if (page == NULL) {
+                    free_directory(child);
+                    return NULL;
+                }
+                copy_page(page, entry & PAGE_FRAME);
+                child_table[j] = page | (entry & ~(PAGE_FRAME | PAGE_COW)) | PAGE_WRITE;
+                fork_pages++;
+            } else {
+                if (entry & PAGE_WRITE) {
+                    entry = (entry & ~PAGE_WRITE) | PAGE_COW;
+                    table[j] = entry;
+                }
+                __sync_fetch_and_add(&page_shares[entry >> PAGE_SHIFT], 1);
+                child_table[j] = entry;
+            }
+        }
+    }
+
+    /* the pages just made read only may be cached writable */
+    if (copy == FALSE && read_cr3() == (unsigned int)directory) {
+        flush_tlb();
+    }
+    return child;
+}
+
+int unshare_page(unsigned int* directory, unsigned int address) {
+    unsigned int* table = page_table(directory, address, FALSE);
+    unsigned int* entry;
+    unsigned int page;
+    unsigned int copy;
+
+    if (table == NULL) {
+        return FALSE;
+    }
+    entry = &table[(address >> PAGE_SHIFT) & (PAGE_ENTRIES - 1)];
+    if ((*entry & (PAGE_PRESENT | PAGE_COW)) != (PAGE_PRESENT | PAGE_COW)) {
+        return FALSE;
+    }
+    page = *entry & PAGE_FRAME;
+
+    /* a page nothing else shares any more is taken over as it is */
+    if (page_shares[page >> PAGE_SHIFT] != 0) {
+        copy = alloc_page();
+        if (copy == NULL) {
+            return FALSE;
+        }
+        copy_page(copy, page);
+        cow_copies++;
+        if (drop_share(page)) {
+            free_page(page);
+        }
+        page = copy;
+    }
+    *entry = page | (*entry & ~(PAGE_FRAME | PAGE_COW)) | PAGE_WRITE;
+    invlpg(address);
+    return TRUE;
+}
+
+void free_directory(unsigned int* directory) {
+    for (unsigned int i = USER_BASE >> LARGE_PAGE_SHIFT; i < USER_TOP >> LARGE_PAGE_SHIFT; i++) {
+        if ((directory[i] & PAGE_PRESENT) == 0) {
+            continue;
+        }
+        unsigned int* table = (unsigned int*)(directory[i] & PAGE_FRAME);
+        for (unsigned int j = 0; j < PAGE_ENTRIES; j++) {
+            if ((table[j] & (PAGE_PRESENT | PAGE_SHARED)) == PAGE_PRESENT
+                && drop_share(table[j] & PAGE_FRAME)) {
+                free_page(table[j] & PAGE_FRAME);
+            }
+        }
+        free_page((unsigned int)table);
+    }
+    free_page((unsigned int)directory);
+}
+
+unsigned int resident_pages(unsigned int* directory, int shared) {
+    unsigned int wanted = shared ? PAGE_PRESENT | PAGE_SHARED : PAGE_PRESENT;
+    unsigned int count = 0;
+    for (unsigned int i = USER_BASE >> LARGE_PAGE_SHIFT; i < USER_TOP >> LARGE_PAGE_SHIFT; i++) {
+        if ((directory[i] & PAGE_PRESENT) == 0) {
+            continue;
+        }
+        unsigned int* table = (unsigned int*)(directory[i] & PAGE_FRAME);
+        for (unsigned int j = 0; j < PAGE_ENTRIES; j++) {
+            if ((table[j] & (PAGE_PRESENT | PAGE_SHARED)) == wanted) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+void load_directory(unsigned int* directory) {
+    if (kernel_directory == NULL) {
+        return;
+    }
+    if (directory == NULL) {
+        directory = kernel_directory;
+    }
+    if (read_cr3() != (unsigned int)directory) {
+        write_cr3((unsigned int)directory);
+    }
+}
+
+void page_fault(unsigned int error, unsigned int address, unsigned int eflags) {
+    char message[] = "unhandled page fault";
+    pcb_t* pcb = current_process();
+
+    /* write protection is off in the kernel, so only user writes land here */
+    if ((error & (FAULT_PRESENT | FAULT_WRITE | FAULT_USER)) == (FAULT_PRESENT | FAULT_WRITE | FAULT_USER)
+        && pcb != NULL && pcb->directory != NULL && address >= USER_BASE && address < USER_TOP
+        && unshare_page(pcb->directory, address) == TRUE) {
+        return;
+    }
+
+    /* loading a page sleeps on the floppy, which needs interrupts */
+    if ((eflags & EFLAGS_IF) && pcb != NULL && (error & FAULT_PRESENT) == 0
+        && address >= USER_BASE && address < USER_TOP) {
+        asm volatile ("sti");
+        if (elf_fault(pcb, address) == TRUE) {
+            return;
+        }
+    }
+    if (error & FAULT_USER) {
+        exit_process(EXIT_FAULT);
+    }
+    println(message);
+    new_line();
+    while (TRUE) {
+        asm volatile ("cli; hlt");
+    }
+}
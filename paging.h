@@ -0,0 +1,279 @@
+/**
+ * @file paging.h
+ * @author Robert McKay
+ * @brief Declares the kernel page directory and functions to map pages.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef PAGING_H
+#define PAGING_H
+
+/* page directory and page table entry bits */
+#define PAGE_PRESENT 0x1
+#define PAGE_WRITE 0x2
+#define PAGE_USER 0x4
+#define PAGE_WRITE_THROUGH 0x8
+#define PAGE_CACHE_DISABLE 0x10
+#define PAGE_LARGE 0x80
+#define PAGE_GLOBAL 0x100
+#define PAGE_FRAME 0xfffff000
+
+/* available bit marking a user page the page directory shares, and does not
+   free with it */
+#define PAGE_SHARED 0x200
+
+/* available bit marking a private page shared read only after a fork, copied
+   on the first write */
+#define PAGE_COW 0x400
+
+/* 4 MB pages, one per page directory entry */
+#define LARGE_PAGE_SIZE 0x400000
+#define LARGE_PAGE_SHIFT 22
+#define PAGE_ENTRIES 1024
+
+/* load address of the kernel image (must match kernel.ld) */
+#define KERNEL_BASE 0x10000
+
+/* device registers start here on a PC, memory is identity mapped below */
+#define IDENTITY_LIMIT 0xfec00000
+
+/* address space private to each process loaded from a file, memory is not
+   identity mapped here */
+#define USER_BASE 0x40000000
+#define USER_TOP 0x80000000
+
+/* user stack, the top page of the user address space, with an unmapped
+   guard page below */
+#define USER_STACK (USER_TOP - 0x1000)
+#define USER_STACK_GUARD (USER_STACK - 0x1000)
+
+/* identity mapping stops below the user address space, leaving room for the
+   benchmark window at kernel_top */
+#define KERNEL_TOP_MAX (USER_BASE - 2 * LARGE_PAGE_SIZE)
+
+/* page fault vector, an interrupt gate so cr2 is read before anything can
+   fault again */
+#define PAGE_FAULT_VECTOR 14
+
+/* page fault error code bits */
+#define FAULT_PRESENT 0x1
+#define FAULT_WRITE 0x2
+#define FAULT_USER 0x4
+
+/**
+ * @brief Page directory shared by every processor, NULL while paging is off.
+ *
+ */
+extern unsigned int* kernel_directory;
+
+/**
+ * @brief End of the identity mapped memory. Addresses from here up to the
+ * device registers are free for map_page.
+ *
+ */
+extern unsigned int kernel_top;
+
+/**
+ * @brief PAGE_GLOBAL if the processor supports global pages, 0 otherwise.
+ *
+ */
+extern unsigned int global_flag;
+
+/**
+ * @brief Pages copied on a write after a fork, and pages allocated by
+ * fork_directory (directories, tables and copies).
+ *
+ */
+extern unsigned int cow_copies;
+extern unsigned int fork_pages;
+
+/**
+ * @brief Pages of INIT code returned to the allocator by free_init_text.
+ *
+ */
+extern unsigned int init_pages_freed;
+
+/**
+ * @brief Builds the kernel page directory, identity mapping memory from the
+ * E820 map and the APIC registers with global 4 MB pages (4 KB page tables
+ * without PSE, and for the first 4 MB), and turns paging on for the calling
+ * processor.
+ *
+ * @return int TRUE if paging is enabled, FALSE if out of memory.
+ */
+int init_paging();
+
+/**
+ * @brief Turns paging on for the calling processor with the kernel page
+ * directory. Called by each application processor. Write protection stays
+ * off so the kernel can write pages that are read only for user mode.
+ *
+ */
+void load_paging();
+
+/**
+ * @brief Maps the first 4 MB with 4 KB pages: the kernel code, read-only
+ * data and USER_READ variables are readable from user mode, since user
+ * processes run code linked into it, and the rest is kernel only.
+ *
+ * @param directory The page directory.
+ * @return int TRUE if mapped, FALSE if out of memory.
+ */
+int map_low_memory(unsigned int* directory);
+
+/**
+ * @brief Frees the pages of the INIT functions (.init.text, see kernel.ld).
+ * Their mapping is left as it is: map_low_memory maps them kernel only and
+ * writable, like the pages they are handed out as, so the other processors
+ * need no TLB flush. Called by main once every processor is running,
+ * application processors never run INIT code.
+ *
+ */
+void free_init_text();
+
+/**
+ * @brief Maps the 4 MB region holding an address to itself, with a single
+ * large page if the processor supports them.
+ *
+ * @param directory The page directory.
+ * @param address Address in the region.
+ * @param flags Entry bits besides PAGE_PRESENT.
+ * @return int TRUE if mapped, FALSE if out of memory.
+ */
+int identity_map(unsigned int* directory, unsigned int address, unsigned int flags);
+
+/**
+ * @brief Returns the page table covering an address.
+ *
+ * @param directory The page directory.
+ * @param address The virtual address.
+ * @param create TRUE to allocate the table if it is missing.
+ * @return unsigned int* The page table, NULL if missing, out of memory or
+ * the address is in a 4 MB page.
+ */
+unsigned int* page_table(unsigned int* directory, unsigned int address, int create);
+
+/**
+ * @brief Maps a 4 KB page. Only the calling processor's TLB is updated.
+ *
+ * @param directory The page directory.
+ * @param address The virtual address.
+ * @param physical The physical address.
+ * @param flags Entry bits besides PAGE_PRESENT.
+ * @return int TRUE if mapped, FALSE if out of memory or the address is in
+ * a 4 MB page.
+ */
+int map_page(unsigned int* directory, unsigned int address,
+             unsigned int physical, unsigned int flags);
+
+/**
+ * @brief Unmaps a 4 KB page. Only the calling processor's TLB is updated,
+ * and empty page tables are kept.
+ *
+ * @param directory The page directory.
+ * @param address The virtual address.
+ */
+void unmap_page(unsigned int* directory, unsigned int address);
+
+/**
+ * @brief Checks that a range is mapped for user mode access in the current
+ * page directory, or will be on first touch, so a system call cannot be
+ * used to read kernel memory.
+ *
+ * @param address Start of the range.
+ * @param length Length of the range in bytes.
+ * @return int TRUE if every page of the range is user accessible.
+ */
+int user_accessible(unsigned int address, unsigned int length);
+
+/**
+ * @brief Checks that a range is mapped writable for user mode access in the
+ * current page directory, or will be on first touch. Copy-on-write pages
+ * of the range are copied, since the kernel writes with write protection
+ * off, and image pages not yet touched are faulted in, so the kernel can
+ * write the range without a page fault. Must be called without locks held.
+ *
+ * @param address Start of the range.
+ * @param length Length of the range in bytes.
+ * @return int TRUE if every page of the range is user writable.
+ */
+int user_writable(unsigned int address, unsigned int length);
+
+/**
+ * @brief Flushes the calling processor's TLB. Global pages stay cached.
+ *
+ */
+void flush_tlb();
+
+/**
+ * @brief Creates a page directory for a process with its own user address
+ * space. Everything outside it is shared with the kernel page directory.
+ *
+ * @return unsigned int* The directory, NULL if out of memory.
+ */
+unsigned int* new_directory();
+
+/**
+ * @brief Copies a process's page directory for a fork. Private pages are
+ * shared read only and marked PAGE_COW in both directories, or copied at
+ * once if copy is TRUE. PAGE_SHARED and not yet touched pages stay as they
+ * are.
+ *
+ * @param directory The directory.
+ * @param copy TRUE to copy every private page instead of sharing it.
+ * @return unsigned int* The new directory, NULL if out of memory.
+ */
+unsigned int* fork_directory(unsigned int* directory, int copy);
+
+/**
+ * @brief Gives a directory its own writable copy of a copy-on-write page.
+ * The last directory sharing a page keeps it without copying.
+ *
+ * @param directory The directory.
+ * @param address An address in the page.
+ * @return int TRUE if the page was copy-on-write and is writable now, FALSE
+ * if it was not or out of memory.
+ */
+int unshare_page(unsigned int* directory, unsigned int address);
+
+/**
+ * @brief Frees a process's page directory with its user page tables and
+ * the pages they map, except PAGE_SHARED pages and pages another directory
+ * still shares after a fork. The directory must not be loaded.
+ *
+ * @param directory The directory.
+ */
+void free_directory(unsigned int* directory);
+
+/**
+ * @brief Counts the pages mapped in a directory's user address space.
+ *
+ * @param directory The directory.
+ * @param shared TRUE to count PAGE_SHARED pages, FALSE for private pages.
+ * @return unsigned int The number of pages.
+ */
+unsigned int resident_pages(unsigned int* directory, int shared);
+
+/**
+ * @brief Loads a page directory on the calling processor unless it is
+ * loaded already.
+ *
+ * @param directory The directory, NULL for the kernel page directory.
+ */
+void load_directory(unsigned int* directory);
+
+/**
+ * @brief Page fault handler, called by page_fault_enter in boot2.S.
+ * Faults on user address space pages not yet mapped are resolved by the
+ * ELF loader, and writes to copy-on-write pages by unshare_page. Any other
+ * fault kills a user process with EXIT_FAULT and halts the kernel.
+ *
+ * @param error Error code pushed by the processor.
+ * @param address Faulting address from cr2.
+ * @param eflags eflags of the interrupted code.
+ */
+void page_fault(unsigned int error, unsigned int address, unsigned int eflags);
+
+#endif
@@ -0,0 +1,69 @@
+/**
+ * @file pci.c
+ * @author Robert McKay
+ * @brief Implements PCI configuration space access (mechanism 1).
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "pci.h"
+#include "buffer.h"
+#include "cpu.h"
+#include "lock.h"
+
+/**
+ * @brief Keeps the address and data port accesses of one processor together.
+ *
+ */
+spinlock_t pci_lock;
+
+INIT void init_pci() {
+    init_lock(&pci_lock, "pci");
+    register_lock_stat(&pci_lock.stat);
+}
+
+pci_address_t pci_address(unsigned int bus, unsigned int device, unsigned int function) {
+    return PCI_ENABLE | (bus << 16) | (device << 11) | (function << 8);
+}
+
+unsigned int pci_read(pci_address_t address, unsigned int reg) {
+    unsigned int flags = acquire_irqsave(&pci_lock);
+    outportl(PCI_CONFIG_ADDRESS, address | reg);
+    unsigned int value = inportl(PCI_CONFIG_DATA);
+    release_irqrestore(&pci_lock, flags);
+    return value;
+}
+
+void pci_write(pci_address_t address, unsigned int reg, unsigned int value) {
+    unsigned int flags = acquire_irqsave(&pci_lock);
+    outportl(PCI_CONFIG_ADDRESS, address | reg);
+    outportl(PCI_CONFIG_DATA, value);
+    release_irqrestore(&pci_lock, flags);
+}
+
+int pci_find_class(unsigned int class_code, unsigned int subclass, pci_address_t* address) {
+    for (unsigned int bus = 0; bus < PCI_BUSES; bus++) {
+        for (unsigned int device = 0; device < PCI_DEVICES; device++) {
+            unsigned int functions = 1;
+            if ((pci_read(pci_address(bus, device, 0), PCI_VENDOR) & 0xffff) == PCI_NO_DEVICE) {
+                continue;
+            }
+            if ((pci_read(pci_address(bus, device, 0), PCI_HEADER_TYPE) >> 16) & PCI_MULTIFUNCTION) {
+                functions = PCI_FUNCTIONS;
+            }
+            for (unsigned int function = 0; function < functions; function++) {
+                pci_address_t candidate = pci_address(bus, device, function);
+                if ((pci_read(candidate, PCI_VENDOR) & 0xffff) == PCI_NO_DEVICE) {
+                    continue;
+                }
+                unsigned int class = pci_read(candidate, PCI_CLASS);
+                if ((class >> 24) == class_code && ((class >> 16) & 0xff) == subclass) {
+                    *address = candidate;
+                    return TRUE;
+                }
+            }
+        }
+    }
+    return FALSE;
+}
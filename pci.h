@@ -0,0 +1,91 @@
+/**
+ * @file pci.h
+ * @author Robert McKay
+ * @brief Declares PCI configuration space access (mechanism 1).
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef PCI_H
+#define PCI_H
+
+/* configuration space ports */
+#define PCI_CONFIG_ADDRESS 0xcf8
+#define PCI_CONFIG_DATA 0xcfc
+#define PCI_ENABLE 0x80000000
+
+/* configuration space registers */
+#define PCI_VENDOR 0x00
+#define PCI_COMMAND 0x04
+#define PCI_CLASS 0x08
+#define PCI_HEADER_TYPE 0x0c
+#define PCI_BAR4 0x20
+
+/* bits of the command register */
+#define PCI_COMMAND_IO 0x1
+#define PCI_COMMAND_BUS_MASTER 0x4
+
+/* bus, device and function limits */
+#define PCI_BUSES 256
+#define PCI_DEVICES 32
+#define PCI_FUNCTIONS 8
+#define PCI_NO_DEVICE 0xffff
+#define PCI_MULTIFUNCTION 0x80
+
+/* bits of an I/O space base address register */
+#define PCI_BAR_IO 0x1
+#define PCI_BAR_IO_MASK 0xfffffffc
+
+/**
+ * @brief Address of a device function, as written to PCI_CONFIG_ADDRESS
+ * without the register.
+ *
+ */
+typedef unsigned int pci_address_t;
+
+/**
+ * @brief Initializes the lock around configuration space accesses.
+ *
+ */
+void init_pci();
+
+/**
+ * @brief Builds the address of a device function.
+ *
+ * @param bus The bus.
+ * @param device The device on the bus.
+ * @param function The function of the device.
+ * @return pci_address_t The address.
+ */
+pci_address_t pci_address(unsigned int bus, unsigned int device, unsigned int function);
+
+/**
+ * @brief Reads a configuration register.
+ *
+ * @param address The device function.
+ * @param reg Offset of the register (a multiple of 4).
+ * @return unsigned int The register.
+ */
+unsigned int pci_read(pci_address_t address, unsigned int reg);
+
+/**
+ * @brief Writes a configuration register.
+ *
+ * @param address The device function.
+ * @param reg Offset of the register (a multiple of 4).
+ * @param value The value to write.
+ */
+void pci_write(pci_address_t address, unsigned int reg, unsigned int value);
+
+/**
+ * @brief Finds the first function with the given class and subclass.
+ *
+ * @param class_code The base class.
+ * @param subclass The subclass.
+ * @param address Receives the device function.
+ * @return int TRUE if one was found.
+ */
+int pci_find_class(unsigned int class_code, unsigned int subclass, pci_address_t* address);
+
+#endif
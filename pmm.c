@@ -0,0 +1,243 @@
+/**
+ * @file pmm.c
+ * @author Robert McKay
+ * @brief Implements the physical page allocator built from the E820 map.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "pmm.h"
+#include "buffer.h"
+#include "lock.h"
+#include "smp.h"
+#include "cpu.h"
+
+unsigned int total_pages;
+unsigned int free_page_count;
+
+/**
+ * @brief One bit per page below max_page, set while the page is in use.
+ *
+ */
+unsigned int* page_bitmap;
+
+/**
+ * @brief Number of pages covered by the bitmap.
+ *
+ */
+unsigned int max_page;
+
+/**
+ * @brief Bitmap word the next single page search starts at.
+ *
+ */
+unsigned int next_free_word;
+
+/**
+ * @brief Protects the bitmap and free_page_count.
+ *
+ */
+spinlock_t pmm_lock CACHE_ALIGNED;
+
+INIT void init_pmm() {
+    e820_map_t* map = (e820_map_t*)E820_ADDRESS;
+    e820_entry_t* entry;
+    unsigned long long end;
+    unsigned long long start;
+    unsigned int bitmap_bytes;
+
+    init_lock(&pmm_lock, "page allocator");
+    register_lock_stat(&pmm_lock.stat);
+    total_pages = 0;
+    free_page_count = 0;
+    next_free_word = 0;
+
+    /* without an E820 map assume the usual memory above 1 MB */
+    if (map->count == 0) {
+        map->count = 1;
+        map->entries[0].base = PMM_LOW_LIMIT;
+        map->entries[0].length = PMM_FALLBACK_LIMIT - PMM_LOW_LIMIT;
+        map->entries[0].type = E820_USABLE;
+    }
+
+    /* size the bitmap for the highest usable page */
+    max_page = 0;
+    for (unsigned int i = 0; i < map->count; i++) {
+        entry = &map->entries[i];
+        end = (entry->base + entry->length) >> PAGE_SHIFT;
+        if (entry->type == E820_USABLE && end > max_page) {
+            max_page = end > PMM_MAX_PAGES ? PMM_MAX_PAGES : end;
+        }
+    }
+    bitmap_bytes = ((max_page + 31) / 32) * sizeof(unsigned int);
+
+    /* store it at the start of the first usable region with room */
+    page_bitmap = NULL;
+    for (unsigned int i = 0; i < map->count && page_bitmap == NULL; i++) {
+        entry = &map->entries[i];
+        start = entry->base < PMM_LOW_LIMIT ? PMM_LOW_LIMIT : entry->base;
+        start = (start + PAGE_SIZE - 1) & ~(unsigned long long)(PAGE_SIZE - 1);
+        end = entry->base + entry->length;
+        if (entry->type == E820_USABLE && start + bitmap_bytes <= end
+            && start + bitmap_bytes <= (unsigned long long)PMM_MAX_PAGES << PAGE_SHIFT) {
+            page_bitmap = (unsigned int*)(unsigned int)start;
+        }
+    }
+    if (page_bitmap == NULL) {
+        return;
+    }
+
+    /* free the usable regions, then reserve anything that overlaps them */
+    for (unsigned int i = 0; i < bitmap_bytes / sizeof(unsigned int); i++) {
+        page_bitmap[i] = 0xffffffff;
+    }
+    for (unsigned int i = 0; i < map->count; i++) {
+        if (map->entries[i].type == E820_USABLE) {
+            mark_region(map->entries[i].base, map->entries[i].length, FALSE);
+        }
+    }
+    for (unsigned int i = 0; i < map->count; i++) {
+        if (map->entries[i].type != E820_USABLE) {
+            mark_region(map->entries[i].base, map->entries[i].length, TRUE);
+        }
+    }
+    mark_region(0, PMM_LOW_LIMIT, TRUE);
+    mark_region((unsigned int)page_bitmap, bitmap_bytes, TRUE);
+    total_pages = free_page_count;
+}
+
+void mark_region(unsigned long long base, unsigned long long length, int used) {
+    unsigned long long first;
+    unsigned long long last;
+    unsigned int mask;
+
+    /* free only whole pages, reserve every page touched */
+    if (used == TRUE) {
+        first = base >> PAGE_SHIFT;
+        last = (base + length + PAGE_SIZE - 1) >> PAGE_SHIFT;
+    } else {
+        first = (base + PAGE_SIZE - 1) >> PAGE_SHIFT;
+        last = (base + length) >> PAGE_SHIFT;
+    }
+    if (last > max_page) {
+        last = max_page;
+    }
+    if (first >= last) {
+        return;
+    }
+    for (unsigned int page = first; page < last; page++) {
+        mask = 1 << (page % 32);
+        if (used == TRUE && (page_bitmap[page / 32] & mask) == 0) {
+            page_bitmap[page / 32] |= mask;
+            free_page_count--;
+        }
+        if (used == FALSE && (page_bitmap[page / 32] & mask) != 0) {
+            page_bitmap[page / 32] &= ~mask;
+            free_page_count++;
+        }
+    }
+}
+
+unsigned int alloc_page() {
+    unsigned int page = NULL;
+    unsigned int flags = irq_save();
+    cpu_t* cpu = this_cpu();
+    if (cpu->page_cache_count == 0) {
+        refill_page_cache(cpu);
+    }
+    if (cpu->page_cache_count > 0) {
+        page = cpu->page_cache[--cpu->page_cache_count];
+    }
+    irq_restore(flags);
+    return page;
+}
+
+void free_page(unsigned int page) {
+    if (page == NULL) {
+        return;
+    }
+    unsigned int flags = irq_save();
+    cpu_t* cpu = this_cpu();
+    if (cpu->page_cache_count == PAGE_CACHE_SIZE) {
+        drain_page_cache(cpu, PAGE_CACHE_BATCH);
+    }
+    cpu->page_cache[cpu->page_cache_count++] = page;
+    irq_restore(flags);
+}
+
+void refill_page_cache(cpu_t* cpu) {
+    unsigned int words = (max_page + 31) / 32;
+    unsigned int word = next_free_word;
+    unsigned int bit;
+
+    if (page_bitmap == NULL) {
+        return;
+    }
+    acquire(&pmm_lock);
+    for (unsigned int scanned = 0; scanned < words
+         && cpu->page_cache_count < PAGE_CACHE_BATCH; scanned++) {
+        /* take every free page of the word, bits past max_page stay set */
+        while (page_bitmap[word] != 0xffffffff
+               && cpu->page_cache_count < PAGE_CACHE_BATCH) {
+            bit = __builtin_ctz(~page_bitmap[word]);
+            page_bitmap[word] |= 1 << bit;
+            free_page_count--;
+            cpu->page_cache[cpu->page_cache_count++] = (word * 32 + bit) << PAGE_SHIFT;
+        }
+        if (cpu->page_cache_count < PAGE_CACHE_BATCH) {
+            word = (word + 1) % words;
+        }
+    }
+    next_free_word = word;
+    release(&pmm_lock);
+}
+
+void drain_page_cache(cpu_t* cpu, unsigned int count) {
+    unsigned int page;
+    acquire(&pmm_lock);
+    while (count > 0 && cpu->page_cache_count > 0) {
+        page = cpu->page_cache[--cpu->page_cache_count] >> PAGE_SHIFT;
+        page_bitmap[page / 32] &= ~(1 << (page % 32));
+        free_page_count++;
+        count--;
+    }
+    release(&pmm_lock);
+}
+
+unsigned int alloc_pages(unsigned int count) {
+    unsigned int run = 0;
+    unsigned int first;
+    if (page_bitmap == NULL || count == 0) {
+        return NULL;
+    }
+    unsigned int flags = acquire_irqsave(&pmm_lock);
+    for (unsigned int page = PMM_LOW_LIMIT >> PAGE_SHIFT; page < max_page; page++) {
+        if (page_bitmap[page / 32] & (1 << (page % 32))) {
+            run = 0;
+            continue;
+        }
+        if (++run < count) {
+            continue;
+        }
+        first = page - count + 1;
+        for (page = first; page < first + count; page++) {
+            page_bitmap[page / 32] |= 1 << (page % 32);
+        }
+        free_page_count -= count;
+        release_irqrestore(&pmm_lock, flags);
+        return first << PAGE_SHIFT;
+    }
+    release_irqrestore(&pmm_lock, flags);
+    return NULL;
+}
+
+void free_pages(unsigned int address, unsigned int count) {
+    unsigned int first = address >> PAGE_SHIFT;
+    unsigned int flags = acquire_irqsave(&pmm_lock);
+    for (unsigned int page = first; page < first + count; page++) {
+        page_bitmap[page / 32] &= ~(1 << (page % 32));
+    }
+    free_page_count += count;
+    release_irqrestore(&pmm_lock, flags);
+}
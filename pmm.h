@@ -0,0 +1,145 @@
+/**
+ * @file pmm.h
+ * @author Robert McKay
+ * @brief Declares the physical page allocator built from the E820 map.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef PMM_H
+#define PMM_H
+
+#define PAGE_SIZE 4096
+#define PAGE_SHIFT 12
+
+/* E820 map left by read_e820 in boot2.S (must match boot2.S) */
+#define E820_ADDRESS 0x5000
+#define E820_MAX 32
+#define E820_USABLE 1
+#define E820_RESERVED 2
+
+/* memory below 1 MB holds the kernel, its boot data and the BIOS */
+#define PMM_LOW_LIMIT 0x100000
+
+/* memory assumed usable if the BIOS has no E820 map */
+#define PMM_FALLBACK_LIMIT 0x1000000
+
+/* only the first 4 GB are addressable without paging extensions */
+#define PMM_MAX_PAGES 0x100000
+
+/* pages each processor keeps, and moves to or from the bitmap at once */
+#define PAGE_CACHE_SIZE 16
+#define PAGE_CACHE_BATCH 8
+
+struct cpu_s;
+
+/**
+ * @brief Structure for one entry of the BIOS E820 memory map.
+ *
+ */
+struct e820_entry_s {
+    unsigned long long base;
+    unsigned long long length;
+    unsigned int type;
+    unsigned int attributes;
+} __attribute__ ((packed));
+
+/**
+ * @brief Type definition for an E820 entry.
+ *
+ */
+typedef struct e820_entry_s e820_entry_t;
+
+/**
+ * @brief Structure for the E820 map at E820_ADDRESS.
+ *
+ */
+struct e820_map_s {
+    unsigned int count;
+    e820_entry_t entries[E820_MAX];
+} __attribute__ ((packed));
+
+/**
+ * @brief Type definition for the E820 map.
+ *
+ */
+typedef struct e820_map_s e820_map_t;
+
+/**
+ * @brief Number of pages the allocator manages.
+ *
+ */
+extern unsigned int total_pages;
+
+/**
+ * @brief Number of pages free in the bitmap, not counting pages held in the
+ * processor caches.
+ *
+ */
+extern unsigned int free_page_count;
+
+/**
+ * @brief Builds the page bitmap from the E820 map. The bitmap is stored in
+ * the first usable region large enough to hold it.
+ *
+ */
+void init_pmm();
+
+/**
+ * @brief Marks a range of physical memory free or used in the bitmap.
+ *
+ * @param base Start of the range.
+ * @param length Length of the range in bytes.
+ * @param used TRUE to mark the pages used, FALSE to mark them free.
+ */
+void mark_region(unsigned long long base, unsigned long long length, int used);
+
+/**
+ * @brief Allocates one page from the calling processor's cache.
+ *
+ * @return unsigned int Physical address of the page, NULL if none are left.
+ */
+unsigned int alloc_page();
+
+/**
+ * @brief Returns one page to the calling processor's cache.
+ *
+ * @param page Physical address of the page.
+ */
+void free_page(unsigned int page);
+
+/**
+ * @brief Allocates physically contiguous pages from the bitmap.
+ *
+ * @param count Number of pages.
+ * @return unsigned int Physical address of the first page, NULL if no run
+ * of count free pages exists.
+ */
+unsigned int alloc_pages(unsigned int count);
+
+/**
+ * @brief Frees pages allocated with alloc_pages.
+ *
+ * @param address Physical address of the first page.
+ * @param count Number of pages.
+ */
+void free_pages(unsigned int address, unsigned int count);
+
+/**
+ * @brief Moves up to PAGE_CACHE_BATCH free pages from the bitmap to the
+ * cache of a processor.
+ *
+ * @param cpu The processor's data.
+ */
+void refill_page_cache(struct cpu_s* cpu);
+
+/**
+ * @brief Moves pages from the cache of a processor back to the bitmap.
+ *
+ * @param cpu The processor's data.
+ * @param count Number of pages to move.
+ */
+void drain_page_cache(struct cpu_s* cpu, unsigned int count);
+
+#endif
@@ -11,42 +11,415 @@
 #include "boot2.h"
 #include "scheduler.h"
 #include "driver.h"
+#include "elf.h"
+#include "fpu.h"
+#include "gdt.h"
+#include "pmm.h"
+#include "slab.h"
+#include "smp.h"
+#include "paging.h"
+#include "syscall.h"
+#include "buffer.h"
+#include "cpu.h"
 
 int process_count = 0;
-pcb_t pcbs[MAX_PROCESSES];
-unsigned int stack[MAX_PROCESSES][STACK_SIZE];
+spinlock_t process_lock CACHE_ALIGNED;
+
+/**
+ * @brief Pid given to the next new process.
+ * 
+ */
+unsigned int next_pid = 0;
+
+/**
+ * @brief Queue for parents blocked in wait_process.
+ * 
+ */
+queue_t wait_queue CACHE_ALIGNED;
+
+/**
+ * @brief Cache the pcbs are allocated from.
+ * 
+ */
+cache_t pcb_cache;
+
+/**
+ * @brief Cache the stacks of SMALL_STACK_SIZE or less are allocated from.
+ * 
+ */
+cache_t small_stack_cache;
+
+pcb_t* process_table = NULL;
+unsigned int stack_overflows = 0;
+
+INIT void init_processes() {
+    init_cache(&pcb_cache, "pcb", sizeof(pcb_t), NULL);
+    init_cache(&small_stack_cache, "small stack", SMALL_STACK_SIZE, NULL);
+    init_fpu_cache();
+    init_lock(&process_lock, "process table");
+    init_queue(&wait_queue, "wait queue");
+    register_lock_stat(&process_lock.stat);
+    register_lock_stat(&wait_queue.lock.stat);
+}
 
 pcb_t* alloc_pcb() {
-    if (process_count < MAX_PROCESSES) {
-        return &pcbs[process_count];
+    /* no fixed limit, the cache grows a page at a time like the stacks */
+    return cache_alloc(&pcb_cache);
+}
+
+unsigned int stack_bytes(unsigned int size) {
+    if (size <= SMALL_STACK_SIZE) {
+        return SMALL_STACK_SIZE;
+    }
+    return (size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+}
+
+unsigned int alloc_stack(unsigned int size) {
+    unsigned int stack;
+    if (size == SMALL_STACK_SIZE) {
+        stack = (unsigned int)cache_alloc(&small_stack_cache);
+    } else {
+        stack = alloc_pages(size / PAGE_SIZE);
+    }
+    if (stack == NULL) {
+        return NULL;
+    }
+
+    /* the canary shows how deep the stack has been used */
+    unsigned int* word = (unsigned int*)stack;
+    for (unsigned int i = 0; i < size / sizeof(unsigned int); i++) {
+        word[i] = STACK_CANARY;
+    }
+    return stack;
+}
+
+void free_stack(unsigned int stack, unsigned int size) {
+    if (size == SMALL_STACK_SIZE) {
+        cache_free(&small_stack_cache, (void*)stack);
+    } else {
+        free_pages(stack, size / PAGE_SIZE);
     }
-    return NULL;
 }
 
-unsigned int* alloc_stack() {
-    if (process_count < MAX_PROCESSES) {
-        return &stack[process_count][STACK_SIZE];
+unsigned int stack_high_water(pcb_t* pcb) {
+    unsigned int* word = (unsigned int*)pcb->stack;
+    unsigned int words = pcb->stack_size / sizeof(unsigned int);
+    unsigned int i = 0;
+    while (i < words && word[i] == STACK_CANARY) {
+        i++;
     }
-    return NULL;
+    return (words - i) * sizeof(unsigned int);
 }
 
-int create_process(unsigned int process_entry) {
+int stack_overflowed(pcb_t* pcb) {
+    return stack_high_water(pcb) > pcb->stack_size - STACK_GUARD_SIZE;
+}
+
+pcb_t* new_process(unsigned int process_entry, unsigned int stack_size) {
     pcb_t* pcb = alloc_pcb();
-    unsigned int* tos = alloc_stack();
-    if (tos == NULL || pcb == NULL) {
-        return EXIT_FAILURE;
+    if (pcb == NULL) {
+        return NULL;
+    }
+    stack_size = stack_bytes(stack_size);
+    unsigned int stack = alloc_stack(stack_size);
+    if (stack == NULL) {
+        cache_free(&pcb_cache, pcb);
+        return NULL;
     }
+    unsigned int* tos = (unsigned int*)(stack + stack_size);
     init_stack(&tos, process_entry);
     pcb->esp = (unsigned int)tos;
-    pcb->pid = process_count;
-    enqueue_process(&ready_queue, pcb);
+    pcb->stack = stack;
+    pcb->stack_size = stack_size;
+    pcb->pid = __sync_fetch_and_add(&next_pid, 1);
+    pcb->cpu = CPU_ANY;
+    pcb->state = PROCESS_ACTIVE;
+    pcb->exit_code = EXIT_SUCCESS;
+    pcb->parent = NULL;
+    pcb->first_child = NULL;
+    pcb->next_sibling = NULL;
+    pcb->user_stack = NULL;
+    pcb->user_stack_address = NULL;
+    pcb->fpu_state = NULL;
+    pcb->quantum = QUANTUM_DEFAULT_US;
+    pcb->slice_left = 0;
+    pcb->quantum_min = QUANTUM_MIN_US;
+    pcb->quantum_max = QUANTUM_MAX_US;
+    pcb->rt_period = 0;
+    pcb->rt_next = NULL;
+    pcb->deadline_misses = 0;
+    pcb->ipc_state = IPC_NONE;
+    pcb->ipc_client = NULL;
+    pcb->base_priority = PRIORITY_NORMAL;
+    pcb->priority = PRIORITY_NORMAL;
+    pcb->mutex_wait = NULL;
+    pcb->mutexes_held = 0;
+    pcb->directory = NULL;
+    pcb->image = NULL;
+
+    unsigned int flags = acquire_irqsave(&process_lock);
+    pcb->table_prev = NULL;
+    pcb->table_next = process_table;
+    if (process_table != NULL) {
+        process_table->table_prev = pcb;
+    }
+    process_table = pcb;
     process_count++;
+    release_irqrestore(&process_lock, flags);
+    return pcb;
+}
+
+pcb_t* new_user_process(unsigned int process_entry, unsigned int stack_size) {
+    pcb_t* pcb = new_process(process_entry, stack_size);
+    if (pcb == NULL) {
+        return NULL;
+    }
+    if (alloc_user_stack(pcb) == FALSE) {
+        unsigned int flags = acquire_irqsave(&process_lock);
+        free_stack(pcb->stack, pcb->stack_size);
+        free_process(pcb);
+        release_irqrestore(&process_lock, flags);
+        return NULL;
+    }
+
+    /* the user stack starts with the return address of the entry point */
+    unsigned int* user_tos = (unsigned int*)(pcb->user_stack + PAGE_SIZE);
+    push(&user_tos, (unsigned int)user_return);
+
+    /* replace the kernel frame with one that irets to ring 3 */
+    unsigned int* tos = (unsigned int*)(pcb->stack + pcb->stack_size);
+    init_user_stack(&tos, process_entry, pcb->user_stack_address + PAGE_SIZE - sizeof(unsigned int));
+    pcb->esp = (unsigned int)tos;
+    return pcb;
+}
+
+int alloc_user_stack(pcb_t* pcb) {
+    unsigned int page = alloc_page();
+    unsigned int* directory;
+    if (page == NULL) {
+        return FALSE;
+    }
+
+    /* without paging every address is reachable from ring 3 */
+    if (kernel_directory == NULL) {
+        pcb->user_stack = page;
+        pcb->user_stack_address = page;
+        return TRUE;
+    }
+
+    /* the guard page below the stack is never mapped */
+    directory = new_directory();
+    if (directory == NULL
+        || map_page(directory, USER_STACK, page, PAGE_USER | PAGE_WRITE) == FALSE) {
+        if (directory != NULL) {
+            free_directory(directory);
+        }
+        free_page(page);
+        return FALSE;
+    }
+    pcb->directory = directory;
+    pcb->user_stack = page;
+    pcb->user_stack_address = USER_STACK;
+    return TRUE;
+}
+
+void free_user_stack(pcb_t* pcb) {
+    if (pcb->user_stack != NULL && pcb->directory == NULL) {
+        free_page(pcb->user_stack);
+    }
+    pcb->user_stack = NULL;
+    pcb->user_stack_address = NULL;
+}
+
+pcb_t* fork_process(int copy) {
+    pcb_t* parent = current_process();
+    if (parent->directory == NULL) {
+        return NULL;
+    }
+    pcb_t* pcb = new_process(NULL, parent->stack_size);
+    if (pcb == NULL) {
+        return NULL;
+    }
+    pcb->directory = fork_directory(parent->directory, copy);
+    if (pcb->directory == NULL) {
+        unsigned int flags = acquire_irqsave(&process_lock);
+        free_stack(pcb->stack, pcb->stack_size);
+        free_process(pcb);
+        release_irqrestore(&process_lock, flags);
+        return NULL;
+    }
+    pcb->user_stack_address = parent->user_stack_address;
+    pcb->quantum_min = parent->quantum_min;
+    pcb->quantum_max = parent->quantum_max;
+    pcb->image = parent->image;
+    if (pcb->image != NULL) {
+        __sync_fetch_and_add(&pcb->image->instances, 1);
+    }
+    if (parent->rt_period != 0) {
+        set_realtime(pcb, parent->rt_period, parent->rt_budget);
+    }
+
+    /* the child returns from the parent's system call, with 0 */
+    unsigned int* frame = (unsigned int*)(parent->stack + parent->stack_size) - SYSCALL_FRAME_WORDS;
+    unsigned int* tos = (unsigned int*)(pcb->stack + pcb->stack_size) - SYSCALL_FRAME_WORDS;
+    for (int i = 0; i < SYSCALL_FRAME_WORDS; i++) {
+        tos[i] = frame[i];
+    }
+    tos[SAVED_EAX_WORD] = 0;
+    init_switch_frame(&tos);
+    pcb->esp = (unsigned int)tos;
+    return pcb;
+}
+
+int create_process(unsigned int process_entry, unsigned int stack_size) {
+    return start_process(new_process(process_entry, stack_size));
+}
+
+int create_user_process(unsigned int process_entry, unsigned int stack_size) {
+    return start_process(new_user_process(process_entry, stack_size));
+}
+
+int start_process(pcb_t* pcb) {
+    if (pcb == NULL) {
+        return EXIT_FAILURE;
+    }
+    /* admission control already placed real-time processes */
+    if (pcb->cpu == CPU_ANY) {
+        pcb->cpu = assign_cpu();
+    }
+
+    /* processes created by main have no parent and are freed on exit */
+    pcb_t* parent = current_process();
+    if (parent != NULL) {
+        unsigned int flags = acquire_irqsave(&process_lock);
+        pcb->parent = parent;
+        pcb->next_sibling = parent->first_child;
+        parent->first_child = pcb;
+        release_irqrestore(&process_lock, flags);
+    }
+    make_ready(pcb);
     return EXIT_SUCCESS;
 }
 
+int start_process_on(pcb_t* pcb, unsigned int cpu) {
+    if (pcb == NULL) {
+        return EXIT_FAILURE;
+    }
+    pcb->cpu = cpu;
+    return start_process(pcb);
+}
+
+void free_process(pcb_t* pcb) {
+    if (pcb->table_prev == NULL) {
+        process_table = pcb->table_next;
+    } else {
+        pcb->table_prev->table_next = pcb->table_next;
+    }
+    if (pcb->table_next != NULL) {
+        pcb->table_next->table_prev = pcb->table_prev;
+    }
+    process_count--;
+    cache_free(&pcb_cache, pcb);
+}
+
+void exit_process(unsigned int code) {
+    pcb_t* pcb = current_process();
+
+    /* interrupts stay off until the next process is running */
+    irq_save();
+    pcb->exit_code = code;
+    exit_switch((unsigned int)pcb);
+}
+
+void process_return() {
+    exit_process(EXIT_SUCCESS);
+}
+
+void retire_process(pcb_t* pcb) {
+    pcb_t* child;
+    pcb_t* next;
+    pcb_t* parent;
+
+    acquire(&process_lock);
+
+    /* nothing runs on the stack any more, so it can be reused at once */
+    if (stack_overflowed(pcb)) {
+        stack_overflows++;
+    }
+    free_stack(pcb->stack, pcb->stack_size);
+    pcb->stack = NULL;
+    free_user_stack(pcb);
+    free_fpu(pcb);
+    clear_realtime(pcb);
+    release_address_space(pcb);
+
+    /* orphans free themselves on exit, zombies are reaped here */
+    for (child = pcb->first_child; child != NULL; child = next) {
+        next = child->next_sibling;
+        child->parent = NULL;
+        child->next_sibling = NULL;
+        if (child->state == PROCESS_ZOMBIE) {
+            free_process(child);
+        }
+    }
+    pcb->first_child = NULL;
+
+    parent = pcb->parent;
+    if (parent == NULL) {
+        free_process(pcb);
+        release(&process_lock);
+        return;
+    }
+    pcb->state = PROCESS_ZOMBIE;
+    if (parent->state == PROCESS_WAITING && remove_process(&wait_queue, parent)) {
+        parent->state = PROCESS_ACTIVE;
+        make_ready(parent);
+    }
+    release(&process_lock);
+}
+
+int wait_process(unsigned int* exit_code) {
+    pcb_t* pcb = current_process();
+    pcb_t* previous;
+    pcb_t* child = NULL;
+    unsigned int flags = acquire_irqsave(&process_lock);
+
+    while (child == NULL) {
+        if (pcb->first_child == NULL) {
+            release_irqrestore(&process_lock, flags);
+            return -1;
+        }
+        previous = NULL;
+        for (child = pcb->first_child; child != NULL; child = child->next_sibling) {
+            if (child->state == PROCESS_ZOMBIE) {
+                break;
+            }
+            previous = child;
+        }
+        if (child == NULL) {
+            /* retire_process takes the lock to wake us, so no exit is missed */
+            pcb->state = PROCESS_WAITING;
+            block_process((unsigned int)&wait_queue, (unsigned int)&process_lock);
+            acquire(&process_lock);
+        }
+    }
+    if (previous == NULL) {
+        pcb->first_child = child->next_sibling;
+    } else {
+        previous->next_sibling = child->next_sibling;
+    }
+    int pid = child->pid;
+    if (exit_code != NULL) {
+        *exit_code = child->exit_code;
+    }
+    free_process(child);
+    release_irqrestore(&process_lock, flags);
+    return pid;
+}
+
 void init_stack(unsigned int** tos, unsigned int process_entry) {
     
-    push(tos, (unsigned int)go);
+    push(tos, (unsigned int)process_return);
     push(tos, EFLAGS);
     push(tos, CS);
     push(tos, process_entry);
@@ -54,10 +427,39 @@ void init_stack(unsigned int** tos, unsigned int process_entry) {
     for (int i = 0; i < 8; i++) {
         push(tos, GENERAL_REGISTERS);
     }
-    // push 0x8 for ds, es, fs, gs
-    for (int i = 0; i < 4; i++) {
+    // push 0x8 for ds, es, fs
+    for (int i = 0; i < 3; i++) {
         push(tos, SEGMENT_REGISTERS);
     }
+    // gs selects the per cpu data of whichever cpu runs the process
+    push(tos, PERCPU_SEL);
+    init_switch_frame(tos);
+}
+
+void init_user_stack(unsigned int** tos, unsigned int process_entry,
+                     unsigned int user_esp) {
+    push(tos, USER_DATA_SEL | RPL_USER);
+    push(tos, user_esp);
+    push(tos, EFLAGS);
+    push(tos, USER_CODE_SEL | RPL_USER);
+    push(tos, process_entry);
+    // push 0x0 for eax, ebx, ecx, edx, esi, edi, esp, ebp
+    for (int i = 0; i < 8; i++) {
+        push(tos, GENERAL_REGISTERS);
+    }
+    // user data for ds, es, fs and gs
+    for (int i = 0; i < 4; i++) {
+        push(tos, USER_DATA_SEL | RPL_USER);
+    }
+    init_switch_frame(tos);
+}
+
+void init_switch_frame(unsigned int** tos) {
+    push(tos, (unsigned int)switch_start);
+    // push 0x0 for ebp, ebx, esi, edi
+    for (int i = 0; i < 4; i++) {
+        push(tos, GENERAL_REGISTERS);
+    }
 }
 
 void push(unsigned int** tos, unsigned int value) {
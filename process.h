@@ -12,14 +12,72 @@
 
 #define EXIT_SUCCESS 0
 #define EXIT_FAILURE 1
-#define STACK_SIZE 1024
+#define EXIT_FAULT 2
 #define CS 0x10
 #define SEGMENT_REGISTERS 0x8
 #define GENERAL_REGISTERS 0x0
 #define EFLAGS 0x0200
 
+/* stack sizes in bytes, small stacks are packed two to a slab page */
+#define DEFAULT_STACK_SIZE 4096
+#define SMALL_STACK_SIZE 2032
+#define STACK_GUARD_SIZE 64
+#define STACK_CANARY 0x57ac57ac
+
+/* words of user state at the top of the kernel stack during a system call:
+   the registers pushed by save_state below the interrupt frame, with the
+   saved eax at SAVED_EAX_WORD (must match boot2.S) */
+#define SYSCALL_FRAME_WORDS 17
+#define SAVED_EAX_WORD 11
+
+/* a process not placed on a processor yet (start_process picks one) */
+#define CPU_ANY 0xffffffff
+
+/* words of data in an ipc message */
+#define IPC_WORDS 2
+
+/* ipc states of a process */
+#define IPC_NONE 0
+#define IPC_SENDING 1
+#define IPC_CALLING 2
+#define IPC_RECEIVING 3
+
+/* scheduling priorities, a process holding a mutex inherits the highest
+   priority among its waiters */
+#define PRIORITY_NORMAL 0
+#define PRIORITY_REALTIME 1
+
+/* process states */
+#define PROCESS_ACTIVE 0
+#define PROCESS_WAITING 1
+#define PROCESS_ZOMBIE 2
+
+#include "lock.h"
+#include "gdt.h"
+
 /* structure for a process control block */
 
+/* mutex a process may wait on, defined in mutex.h */
+struct mutex_s;
+
+/* program file a process was loaded from, defined in elf.h */
+struct image_s;
+
+/**
+ * @brief A small ipc message, copied word by word between pcbs.
+ * 
+ */
+struct message_s {
+    unsigned int sender;
+    unsigned int words[IPC_WORDS];
+} __attribute__ ((packed));
+
+/**
+ * @brief Type definition for an ipc message.
+ * 
+ */
+typedef struct message_s message_t;
+
 /**
  * @brief Structure for a process control block.
  * 
@@ -27,6 +85,40 @@
 struct pcb_s {
     unsigned int esp;
     unsigned int pid;
+    unsigned int cpu;
+    unsigned int stack;
+    unsigned int stack_size;
+    unsigned int state;
+    unsigned int exit_code;
+    struct pcb_s* parent;
+    struct pcb_s* first_child;
+    struct pcb_s* next_sibling;
+    struct pcb_s* table_prev;
+    struct pcb_s* table_next;
+    unsigned int user_stack;
+    unsigned int user_stack_address;
+    unsigned int fpu_state;
+    unsigned int quantum;
+    unsigned int slice_left;
+    unsigned int quantum_min;
+    unsigned int quantum_max;
+    unsigned int rt_period;
+    unsigned int rt_budget;
+    unsigned int rt_budget_left;
+    unsigned int rt_state;
+    unsigned long long rt_release;
+    unsigned long long rt_deadline;
+    struct pcb_s* rt_next;
+    unsigned int deadline_misses;
+    unsigned int ipc_state;
+    struct pcb_s* ipc_client;
+    message_t ipc_message;
+    unsigned int base_priority;
+    unsigned int priority;
+    struct mutex_s* mutex_wait;
+    unsigned int mutexes_held;
+    unsigned int* directory;
+    struct image_s* image;
 } __attribute__ ((packed));
 
 /**
@@ -35,27 +127,218 @@ struct pcb_s {
  */
 typedef struct pcb_s pcb_t;
 
+/**
+ * @brief Number of live processes (not yet reaped).
+ * 
+ */
+extern int process_count;
+
+/**
+ * @brief Protects the process table, the parent and child links and the
+ * state of every process.
+ * 
+ */
+extern spinlock_t process_lock;
+
+/**
+ * @brief Every live process (including zombies), linked through table_next.
+ * 
+ */
+extern pcb_t* process_table;
+
+/**
+ * @brief Number of exited processes that had written into their stack's
+ * guard region.
+ * 
+ */
+extern unsigned int stack_overflows;
+
+/**
+ * @brief Creates the cache pcbs are allocated from.
+ * 
+ */
+void init_processes();
+
 /**
  * @brief Allocates a pcb structure to a process.
  * 
- * @return pcb_t* Pointer to the pcb.
+ * @return pcb_t* Pointer to the pcb, NULL if out of memory.
  */
 pcb_t* alloc_pcb();
 
 /**
- * @brief Allocates a stack to a process.
+ * @brief Rounds a requested stack size up to the size actually allocated:
+ * SMALL_STACK_SIZE, or a whole number of pages.
+ * 
+ * @param size The requested size in bytes.
+ * @return unsigned int The allocated size in bytes.
+ */
+unsigned int stack_bytes(unsigned int size);
+
+/**
+ * @brief Allocates a process's stack and fills it with STACK_CANARY.
+ * 
+ * @param size Size of the stack as returned by stack_bytes.
+ * @return unsigned int Lowest address of the stack, NULL if out of memory.
+ */
+unsigned int alloc_stack(unsigned int size);
+
+/**
+ * @brief Frees a process's stack.
+ * 
+ * @param stack Lowest address of the stack.
+ * @param size Size of the stack as returned by stack_bytes.
+ */
+void free_stack(unsigned int stack, unsigned int size);
+
+/**
+ * @brief Measures the deepest point a process's stack has reached, by
+ * finding the lowest word that no longer holds STACK_CANARY.
  * 
- * @return unsigned int* Pointer to the top of the stack.
+ * @param pcb The pcb of the process.
+ * @return unsigned int Bytes of stack used at the deepest point.
  */
-unsigned int* alloc_stack();
+unsigned int stack_high_water(pcb_t* pcb);
+
+/**
+ * @brief Checks the guard region, the lowest STACK_GUARD_SIZE bytes of the
+ * stack, which a process must never reach.
+ * 
+ * @param pcb The pcb of the process.
+ * @return int TRUE if the guard region was written, FALSE otherwise.
+ */
+int stack_overflowed(pcb_t* pcb);
+
+/**
+ * @brief Allocates a pcb and stack and builds the initial stack frame.
+ * The process is not added to any queue.
+ * 
+ * @param process_entry The entry point of the process.
+ * @param stack_size Stack size in bytes, rounded up by stack_bytes.
+ * @return pcb_t* Pointer to the new pcb or NULL if none are left.
+ */
+pcb_t* new_process(unsigned int process_entry, unsigned int stack_size);
+
+/**
+ * @brief Allocates a pcb, kernel stack and user stack for a ring 3 process
+ * and builds an initial frame that irets to its entry point.
+ * 
+ * @param process_entry The entry point of the process.
+ * @param stack_size Kernel stack size in bytes, rounded up by stack_bytes.
+ * @return pcb_t* Pointer to the new pcb or NULL if none are left.
+ */
+pcb_t* new_user_process(unsigned int process_entry, unsigned int stack_size);
+
+/**
+ * @brief Gives a process its own page directory and maps a user stack page
+ * at USER_STACK in it, user writable.
+ * 
+ * @param pcb The pcb of the process.
+ * @return int TRUE if successful, FALSE if out of memory.
+ */
+int alloc_user_stack(pcb_t* pcb);
+
+/**
+ * @brief Frees a process's user stack, if it has one and no page directory
+ * (the stack is then freed with the directory by release_address_space).
+ * The caller holds process_lock.
+ * 
+ * @param pcb The pcb of the process.
+ */
+void free_user_stack(pcb_t* pcb);
+
+/**
+ * @brief Duplicates the calling ring 3 process, which is in a system call.
+ * The child gets a copy of the page directory from fork_directory and
+ * returns from the same system call with 0. A real-time parent's child gets
+ * the same reservation if admission control accepts it. The child is not
+ * started.
+ * 
+ * @param copy TRUE to copy every private page at once instead of sharing
+ * it copy-on-write.
+ * @return pcb_t* The child, NULL if the caller has no page directory or out
+ * of memory.
+ */
+pcb_t* fork_process(int copy);
 
 /**
  * @brief Creates a new process and adds it to the queue.
  * 
  * @param process_entry The entry point of the process.
+ * @param stack_size Stack size in bytes, rounded up by stack_bytes.
+ * @return int EXIT_SUCCESS (0) if successful, EXIT_FAILURE (1) otherwise.
+ */
+int create_process(unsigned int process_entry, unsigned int stack_size);
+
+/**
+ * @brief Creates a new ring 3 process and adds it to the queue. It reaches
+ * the kernel only through system calls.
+ * 
+ * @param process_entry The entry point of the process.
+ * @param stack_size Kernel stack size in bytes, rounded up by stack_bytes.
  * @return int EXIT_SUCCESS (0) if successful, EXIT_FAILURE (1) otherwise.
  */
-int create_process(unsigned int process_entry);
+int create_user_process(unsigned int process_entry, unsigned int stack_size);
+
+/**
+ * @brief Gives a new process a processor, links it to its parent (the
+ * calling process) and makes it ready.
+ * 
+ * @param pcb The new process, may be NULL.
+ * @return int EXIT_SUCCESS (0) if successful, EXIT_FAILURE (1) if pcb is NULL.
+ */
+int start_process(pcb_t* pcb);
+
+/**
+ * @brief Starts a process on a given processor instead of the next one in
+ * round robin order.
+ * 
+ * @param pcb The process from new_process or new_user_process.
+ * @param cpu Index of the processor.
+ * @return int EXIT_SUCCESS (0) if successful, EXIT_FAILURE (1) if pcb is NULL.
+ */
+int start_process_on(pcb_t* pcb, unsigned int cpu);
+
+/**
+ * @brief Removes a process from the process table and returns its pcb to
+ * the pcb cache. The caller holds process_lock.
+ * 
+ * @param pcb The pcb of the process, its stack must already be freed.
+ */
+void free_process(pcb_t* pcb);
+
+/**
+ * @brief Ends the calling process. Its stack is freed at once, its pcb when
+ * the parent reaps it with wait_process, or at once if it has no parent.
+ * Processes that return from their entry point exit with EXIT_SUCCESS.
+ * 
+ * @param code The exit code reported to the parent.
+ */
+void exit_process(unsigned int code);
+
+/**
+ * @brief Entry point's return address on a new process's stack.
+ * 
+ */
+void process_return();
+
+/**
+ * @brief Frees the stack of an exited process, counting it in
+ * stack_overflows if its guard region was written, and either frees its pcb
+ * or leaves it as a zombie for its parent. Called by exit_switch in boot2.S on
+ * the processor's own stack with interrupts disabled.
+ * 
+ * @param pcb The pcb of the exited process.
+ */
+void retire_process(pcb_t* pcb);
+
+/**
+ * @brief Waits for a child of the calling process to exit and reaps it.
+ * 
+ * @param exit_code Receives the child's exit code, may be NULL.
+ * @return int The pid of the reaped child, -1 if the caller has no children.
+ */
+int wait_process(unsigned int* exit_code);
 
 /**
  * @brief Initializes the stack for a new process.
@@ -65,6 +348,25 @@ int create_process(unsigned int process_entry);
  */
 void init_stack(unsigned int** tos, unsigned int process_entry);
 
+/**
+ * @brief Initializes the kernel stack of a ring 3 process with a frame that
+ * irets to user mode.
+ * 
+ * @param tos Pointer to the top of the kernel stack.
+ * @param process_entry The entry point of the process.
+ * @param user_esp The process's initial user stack pointer.
+ */
+void init_user_stack(unsigned int** tos, unsigned int process_entry,
+                     unsigned int user_esp);
+
+/**
+ * @brief Pushes the callee saved registers and return address that
+ * switch_process pops, so a new process starts in switch_start.
+ * 
+ * @param tos Pointer to the top of the stack.
+ */
+void init_switch_frame(unsigned int** tos);
+
 /*-------------------------------- push --------------------------------------
     Pushes a value on the processes stack.
 
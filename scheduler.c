@@ -8,67 +8,87 @@
  */
 
 #include "scheduler.h"
+#include "smp.h"
+#include "fpu.h"
+#include "apic.h"
+#include "slab.h"
+#include "buffer.h"
+#include "boot2.h"
+#include "clock.h"
+#include "paging.h"
+#include "cpu.h"
 
 /**
- * @brief Array of nodes to allocate to the queues.
+ * @brief Cache the queue nodes are allocated from.
  * 
  */
-node_t nodes[MAX_PROCESSES];
+cache_t node_cache CACHE_ALIGNED;
 
 /**
- * @brief Stores reference to the pcb of the current process.
- * The process dispatcher in boot2.S needs this to save/restore state.
+ * @brief Processor that receives the next new process.
  * 
  */
-pcb_t current_process;
+unsigned int next_cpu;
 
-queue_t ready_queue;
-queue_t blocked_queue;
+queue_t blocked_queue CACHE_ALIGNED;
 
-void init_queues() {
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        nodes[i].pcb = NULL;
-        nodes[i].next = NULL;
-    }
-    ready_queue.head = NULL;
-    ready_queue.tail = NULL;
-    blocked_queue.head = NULL;
-    blocked_queue.tail = NULL;
+unsigned int deadline_misses;
+
+INIT void init_queues() {
+    init_cache(&node_cache, "queue node", sizeof(node_t), init_node);
+    init_queue(&blocked_queue, "blocked queue");
+    register_lock_stat(&blocked_queue.lock.stat);
+    next_cpu = 0;
 }
 
-node_t* alloc_node() {
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        if (nodes[i].pcb == NULL) {
-            nodes[i].next = NULL;
-            return &nodes[i];
-        }
-    }
-    return NULL;
+void init_queue(queue_t *queue, char* name) {
+    queue->head = NULL;
+    queue->tail = NULL;
+    init_ticket_lock(&queue->lock, name);
 }
 
-void free_node(node_t *node) {
+void init_node(void* object) {
+    node_t* node = object;
     node->pcb = NULL;
     node->next = NULL;
 }
 
-void enqueue_process(queue_t *queue, pcb_t *pcb) {
-    node_t* new_node = alloc_node();
+HOT node_t* alloc_node(pcb_t* pcb) {
+    node_t* node = cache_alloc(&node_cache);
+    if (node != NULL) {
+        node->pcb = pcb;
+    }
+    return node;
+}
+
+HOT void free_node(node_t *node) {
+    /* return the node in its constructed state */
+    init_node(node);
+    cache_free(&node_cache, node);
+}
+
+HOT void enqueue_process(queue_t *queue, pcb_t *pcb) {
+    node_t* new_node = alloc_node(pcb);
     if (new_node == NULL) {
         return;
     }
-    new_node->pcb = pcb;
+    unsigned int flags = acquire_ticket_irqsave(&queue->lock);
     if (queue->tail == NULL) {
         queue->head = new_node;
         queue->tail = new_node;
+        release_ticket_irqrestore(&queue->lock, flags);
         return;
     }
     queue->tail->next = new_node;
     queue->tail = new_node;
+    release_ticket_irqrestore(&queue->lock, flags);
 }
 
-pcb_t* dequeue_process(queue_t *queue) {
+HOT pcb_t* dequeue_process(queue_t *queue) {
+    unsigned int flags = acquire_ticket_irqsave(&queue->lock);
     if (queue->head == NULL)
     {
+        release_ticket_irqrestore(&queue->lock, flags);
         return NULL;
     }
     node_t *temp = queue->head;
@@ -77,6 +97,343 @@ pcb_t* dequeue_process(queue_t *queue) {
     if (queue->head == NULL) {
         queue->tail = NULL;
     }
+    release_ticket_irqrestore(&queue->lock, flags);
     free_node(temp);
     return pcb;
-}
\ No newline at end of file
+}
+
+int remove_process(queue_t *queue, pcb_t* pcb) {
+    unsigned int flags = acquire_ticket_irqsave(&queue->lock);
+    node_t* previous = NULL;
+    node_t* node = queue->head;
+    while (node != NULL && node->pcb != pcb) {
+        previous = node;
+        node = node->next;
+    }
+    if (node == NULL) {
+        release_ticket_irqrestore(&queue->lock, flags);
+        return FALSE;
+    }
+    if (previous == NULL) {
+        queue->head = node->next;
+    } else {
+        previous->next = node->next;
+    }
+    if (queue->tail == node) {
+        queue->tail = previous;
+    }
+    release_ticket_irqrestore(&queue->lock, flags);
+    free_node(node);
+    return TRUE;
+}
+
+HOT void make_ready(pcb_t* pcb) {
+    cpu_t* cpu = &cpus[pcb->cpu];
+    if (pcb == cpu->idle) {
+        return;
+    }
+    if (pcb->rt_period != 0) {
+        /* sleeping processes wait for their release, not a wakeup */
+        unsigned int flags = acquire_irqsave(&cpu->rt_lock);
+        if (pcb->rt_state == RT_BLOCKED) {
+            pcb->rt_state = RT_READY;
+        }
+        release_irqrestore(&cpu->rt_lock, flags);
+        if (cpu != this_cpu()) {
+            send_ipi(cpu->apic_id, RESCHED_VECTOR);
+        }
+        return;
+    }
+    if (pcb->priority > PRIORITY_NORMAL) {
+        /* a mutex owner lent a higher priority goes ahead */
+        enqueue_process(&cpu->boosted_queue, pcb);
+        if (cpu != this_cpu() && cpu->current->priority < pcb->priority) {
+            send_ipi(cpu->apic_id, RESCHED_VECTOR);
+        }
+        return;
+    }
+    enqueue_process(&cpu->ready_queue, pcb);
+    if (cpu != this_cpu() && cpu->current == cpu->idle) {
+        send_ipi(cpu->apic_id, RESCHED_VECTOR);
+    }
+}
+
+HOT pcb_t* next_process() {
+    cpu_t* cpu = this_cpu();
+    pcb_t* pcb = pick_realtime(cpu);
+    if (pcb == NULL && cpu->boosted_queue.head != NULL) {
+        pcb = dequeue_process(&cpu->boosted_queue);
+    }
+    if (pcb == NULL) {
+        pcb = dequeue_process(&cpu->ready_queue);
+    }
+    if (pcb == NULL) {
+        pcb = cpu->idle;
+    }
+    pcb->slice_left = pcb->quantum;
+    return run_process(pcb);
+}
+
+HOT pcb_t* run_process(pcb_t* pcb) {
+    cpu_t* cpu = this_cpu();
+    cpu->current = pcb;
+    fpu_switch_out(cpu, pcb);
+
+    /* interrupts and system calls from user mode land on this stack */
+    cpu->tss.esp0 = pcb->stack + pcb->stack_size;
+
+    /* processes loaded from a file have their own user address space */
+    load_directory(pcb->directory);
+    return pcb;
+}
+
+HOT int slice_tick() {
+    cpu_t* cpu = this_cpu();
+    pcb_t* pcb = cpu->current;
+    int preempt = FALSE;
+
+    if (cpu->rt_tasks != NULL) {
+        preempt = realtime_tick(cpu, pcb);
+    }
+
+    /* the idle process gives way at every tick */
+    if (pcb == cpu->idle) {
+        return TRUE;
+    }
+
+    /* real-time processes run until they wait, overrun or are preempted */
+    if (pcb->rt_period != 0 || preempt) {
+        return preempt;
+    }
+
+    /* a boosted mutex owner is waiting behind a normal process */
+    if (pcb->priority == PRIORITY_NORMAL && cpu->boosted_queue.head != NULL) {
+        return TRUE;
+    }
+    if (pcb->slice_left > tick_us) {
+        pcb->slice_left -= tick_us;
+        return FALSE;
+    }
+    pcb->slice_left = 0;
+    pcb->quantum *= 2;
+    if (pcb->quantum > pcb->quantum_max) {
+        pcb->quantum = pcb->quantum_max;
+    }
+    return TRUE;
+}
+
+HOT void end_slice(pcb_t* pcb) {
+    if (pcb->rt_period != 0) {
+        pcb->rt_state = RT_BLOCKED;
+        return;
+    }
+    if (pcb->slice_left > pcb->quantum / 2) {
+        pcb->quantum /= 2;
+        if (pcb->quantum < pcb->quantum_min) {
+            pcb->quantum = pcb->quantum_min;
+        }
+    }
+    pcb->slice_left = 0;
+}
+
+void set_quantum(pcb_t* pcb, unsigned int min_us, unsigned int max_us) {
+    if (min_us < QUANTUM_MIN_US) {
+        min_us = QUANTUM_MIN_US;
+    }
+    if (max_us > QUANTUM_MAX_US) {
+        max_us = QUANTUM_MAX_US;
+    }
+    if (max_us < min_us) {
+        max_us = min_us;
+    }
+    unsigned int flags = irq_save();
+    pcb->quantum_min = min_us;
+    pcb->quantum_max = max_us;
+    if (pcb->quantum < min_us) {
+        pcb->quantum = min_us;
+    }
+    if (pcb->quantum > max_us) {
+        pcb->quantum = max_us;
+    }
+    irq_restore(flags);
+}
+
+int set_realtime(pcb_t* pcb, unsigned int period_us, unsigned int budget_us) {
+    if (budget_us == 0 || budget_us > period_us) {
+        return FALSE;
+    }
+    unsigned int utilization = div_u64((unsigned long long)budget_us * RT_SCALE, period_us);
+
+    /* first fit, EDF meets every deadline while utilization is at most 1 */
+    for (unsigned int i = 0; i < cpus_online; i++) {
+        cpu_t* cpu = &cpus[i];
+        unsigned int flags = acquire_irqsave(&cpu->rt_lock);
+        if (cpu->rt_utilization + utilization <= RT_UTILIZATION_MAX) {
+            cpu->rt_utilization += utilization;
+            pcb->cpu = i;
+            pcb->rt_period = period_us;
+            pcb->rt_budget = budget_us;
+            pcb->rt_budget_left = budget_us;
+            pcb->rt_state = RT_BLOCKED;
+            pcb->base_priority = PRIORITY_REALTIME;
+            pcb->priority = PRIORITY_REALTIME;
+            pcb->rt_release = clock_ns();
+            pcb->rt_deadline = pcb->rt_release + (unsigned long long)period_us * 1000;
+            pcb->rt_next = cpu->rt_tasks;
+            cpu->rt_tasks = pcb;
+            release_irqrestore(&cpu->rt_lock, flags);
+            return TRUE;
+        }
+        release_irqrestore(&cpu->rt_lock, flags);
+    }
+    return FALSE;
+}
+
+void clear_realtime(pcb_t* pcb) {
+    if (pcb->rt_period == 0) {
+        return;
+    }
+    cpu_t* cpu = &cpus[pcb->cpu];
+    unsigned int flags = acquire_irqsave(&cpu->rt_lock);
+    pcb_t* previous = NULL;
+    pcb_t* task = cpu->rt_tasks;
+    while (task != NULL && task != pcb) {
+        previous = task;
+        task = task->rt_next;
+    }
+    if (task != NULL && previous == NULL) {
+        cpu->rt_tasks = pcb->rt_next;
+    } else if (task != NULL) {
+        previous->rt_next = pcb->rt_next;
+    }
+    cpu->rt_utilization -= div_u64((unsigned long long)pcb->rt_budget * RT_SCALE,
+                                   pcb->rt_period);
+    pcb->rt_next = NULL;
+    pcb->rt_period = 0;
+    release_irqrestore(&cpu->rt_lock, flags);
+}
+
+pcb_t* pick_realtime(cpu_t* cpu) {
+    pcb_t* earliest = NULL;
+    if (cpu->rt_tasks == NULL) {
+        return NULL;
+    }
+    acquire(&cpu->rt_lock);
+    for (pcb_t* pcb = cpu->rt_tasks; pcb != NULL; pcb = pcb->rt_next) {
+        if (pcb->rt_state == RT_READY
+            && (earliest == NULL || pcb->rt_deadline < earliest->rt_deadline)) {
+            earliest = pcb;
+        }
+    }
+    release(&cpu->rt_lock);
+    return earliest;
+}
+
+/**
+ * @brief Moves a real-time process on to its next period.
+ *
+ * @param pcb The process.
+ * @param now The current time in nanoseconds.
+ */
+static void next_period(pcb_t* pcb, unsigned long long now) {
+    unsigned long long period = (unsigned long long)pcb->rt_period * 1000;
+    pcb->rt_release = pcb->rt_deadline;
+    pcb->rt_deadline += period;
+
+    /* a process more than a period late starts over rather than catch up */
+    if (pcb->rt_deadline <= now) {
+        pcb->rt_release = now;
+        pcb->rt_deadline = now + period;
+    }
+}
+
+/**
+ * @brief Counts a missed deadline.
+ *
+ * @param pcb The process that missed it.
+ */
+static void miss_deadline(pcb_t* pcb) {
+    pcb->deadline_misses++;
+    __sync_fetch_and_add(&deadline_misses, 1);
+}
+
+int realtime_tick(cpu_t* cpu, pcb_t* current) {
+    pcb_t* pcb;
+    int preempt = FALSE;
+
+    acquire(&cpu->rt_lock);
+    unsigned long long now = clock_ns();
+
+    /* a process that overruns its budget waits for its next period */
+    if (current->rt_period != 0 && current->rt_state == RT_READY) {
+        if (current->rt_budget_left > tick_us) {
+            current->rt_budget_left -= tick_us;
+        } else {
+            miss_deadline(current);
+            next_period(current, now);
+            current->rt_state = RT_SLEEPING;
+            preempt = TRUE;
+        }
+    }
+
+    for (pcb = cpu->rt_tasks; pcb != NULL; pcb = pcb->rt_next) {
+        if (pcb->rt_state == RT_READY && now > pcb->rt_deadline) {
+            /* still running its job at the deadline */
+            miss_deadline(pcb);
+            next_period(pcb, now);
+            pcb->rt_budget_left = pcb->rt_budget;
+        } else if (pcb->rt_state == RT_SLEEPING && now >= pcb->rt_release) {
+            pcb->rt_state = RT_READY;
+            pcb->rt_budget_left = pcb->rt_budget;
+        }
+    }
+
+    /* earliest deadline first, and real-time before normal processes */
+    for (pcb = cpu->rt_tasks; pcb != NULL; pcb = pcb->rt_next) {
+        if (pcb != current && pcb->rt_state == RT_READY
+            && (current->rt_period == 0 || current->rt_state != RT_READY
+                || pcb->rt_deadline < current->rt_deadline)) {
+            preempt = TRUE;
+        }
+    }
+    release(&cpu->rt_lock);
+    return preempt;
+}
+
+int wait_period() {
+    cpu_t* cpu;
+    pcb_t* pcb = current_process();
+    if (pcb->rt_period == 0) {
+        return FALSE;
+    }
+
+    unsigned int flags = irq_save();
+    cpu = this_cpu();
+    acquire(&cpu->rt_lock);
+    unsigned long long now = clock_ns();
+    if (now > pcb->rt_deadline) {
+        miss_deadline(pcb);
+    }
+    next_period(pcb, now);
+    pcb->rt_budget_left = pcb->rt_budget;
+    pcb->rt_state = now >= pcb->rt_release ? RT_READY : RT_SLEEPING;
+    release(&cpu->rt_lock);
+
+    /* the tick releases it, or EDF picks among the ready processes now */
+    switch_process();
+    irq_restore(flags);
+    return TRUE;
+}
+
+void yield() {
+    unsigned int flags = irq_save();
+    pcb_t* pcb = current_process();
+    end_slice(pcb);
+    make_ready(pcb);
+    switch_process();
+    irq_restore(flags);
+}
+
+unsigned int assign_cpu() {
+    return __sync_fetch_and_add(&next_cpu, 1) % cpus_online;
+}
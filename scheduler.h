@@ -10,10 +10,28 @@
 #ifndef SCHEDULER_H
 #define SCHEDULER_H
 
-#define MAX_PROCESSES 10
 #define NULL 0
 
+/* time slices in micro seconds, a process's quantum adapts between its
+   bounds, which default to the widest range */
+#define QUANTUM_MIN_US 1000
+#define QUANTUM_DEFAULT_US 10000
+#define QUANTUM_MAX_US 40000
+
+/* states of a real-time process */
+#define RT_READY 0
+#define RT_BLOCKED 1
+#define RT_SLEEPING 2
+
+/* utilization in millionths, admission leaves room for normal processes */
+#define RT_SCALE 1000000
+#define RT_UTILIZATION_MAX 900000
+
 #include "process.h"
+#include "lock.h"
+
+/* per processor data, defined in smp.h */
+struct cpu_s;
 
 /**
  * @brief Structure for a queue node.
@@ -37,6 +55,7 @@ typedef struct node_s node_t;
 struct queue_s {
     node_t *head;
     node_t *tail;
+    ticket_lock_t lock;
 };
 
 /**
@@ -46,35 +65,47 @@ struct queue_s {
 typedef struct queue_s queue_t;
 
 /**
- * @brief Queue for processes ready to execute.
+ * @brief Queue for processes in blocked state.
  * 
  */
-extern queue_t ready_queue;
+extern queue_t blocked_queue;
 
 /**
- * @brief Queue for processes in blocked state.
+ * @brief Initializes the blocked queue and the node cache. Each processor's
+ * ready queue is initialized with the processor.
  * 
  */
-extern queue_t blocked_queue;
+void init_queues();
 
 /**
- * @brief Initializes the ready/blocked queues. Sets all nodes to null.
+ * @brief Initializes an empty queue.
  * 
+ * @param queue The queue to initialize.
+ * @param name Name reported with the queue lock's counters.
  */
-void init_queues();
+void init_queue(queue_t *queue, char* name);
+
+/**
+ * @brief Node cache constructor, clears a node.
+ * 
+ * @param object The node to construct.
+ */
+void init_node(void* object);
 
 /**
  * @brief Allocates a new node for the queue.
  * 
- * @return node_t* Pointer to the new node.
+ * @param pcb The pcb the node will hold.
+ * @return node_t* Pointer to the new node, NULL if out of memory.
  */
-node_t* alloc_node();
+node_t* alloc_node(pcb_t* pcb);
 
 /**
  * @brief Deallocates a node from the queue.
  * 
+ * @param node The node to free.
  */
-void free_node();
+void free_node(node_t *node);
 
 /**
  * @brief Adds a process to the end of the queue.
@@ -101,4 +132,146 @@ void enqueue_process(queue_t *queue, pcb_t* pcb);
  */
 pcb_t* dequeue_process(queue_t *queue);
 
-#endif
\ No newline at end of file
+/**
+ * @brief Removes a particular process from a queue.
+ * 
+ * @param queue The queue to remove from.
+ * @param pcb The pcb of the process to remove.
+ * @return int TRUE if the process was in the queue, FALSE otherwise.
+ */
+int remove_process(queue_t *queue, pcb_t* pcb);
+
+/**
+ * @brief Deadlines missed by all real-time processes, including budget
+ * overruns.
+ * 
+ */
+extern unsigned int deadline_misses;
+
+/**
+ * @brief Adds a process to the ready queue of its processor. Wakes the
+ * processor with an IPI if it is idle. Idle processes are never queued.
+ * Real-time processes are marked ready instead of queued, and their
+ * processor is always told so it can preempt for the earlier deadline.
+ * Processes boosted by a mutex waiter go on the boosted queue.
+ * 
+ * @param pcb The pcb of the process to make ready.
+ */
+void make_ready(pcb_t* pcb);
+
+/**
+ * @brief Selects the next process for the calling processor and makes it
+ * the current process: the earliest deadline real-time process, then
+ * processes boosted by priority inheritance, then the ready queue. Called
+ * by go and switch_process in boot2.S.
+ * 
+ * @return pcb_t* The next process, or the processor's idle process.
+ */
+pcb_t* next_process();
+
+/**
+ * @brief Makes a process the current process of the calling processor
+ * without touching its slice. Called by next_process and by switch_to in
+ * boot2.S for direct handoffs.
+ * 
+ * @param pcb The process about to run.
+ * @return pcb_t* The same process.
+ */
+pcb_t* run_process(pcb_t* pcb);
+
+/**
+ * @brief Charges one timer tick to the current process. A process that
+ * uses its whole slice is CPU bound, so its quantum doubles (up to
+ * quantum_max) to cut switches. Called by dispatch in boot2.S.
+ * 
+ * @return int TRUE if the slice is used up and the process is preempted.
+ */
+int slice_tick();
+
+/**
+ * @brief Ends the slice of a process giving up the processor early. A
+ * process that blocks or yields within the first half of its slice is
+ * latency bound, so its quantum halves (down to quantum_min). Called by
+ * yield and block_process.
+ * 
+ * @param pcb The process giving up the processor.
+ */
+void end_slice(pcb_t* pcb);
+
+/**
+ * @brief Limits the quantum of a process, trading throughput (long slices)
+ * against latency (short slices). Equal bounds fix the quantum.
+ * 
+ * @param pcb The process.
+ * @param min_us Shortest quantum in micro seconds.
+ * @param max_us Longest quantum in micro seconds.
+ */
+void set_quantum(pcb_t* pcb, unsigned int min_us, unsigned int max_us);
+
+/**
+ * @brief Makes a process that has not been started periodic and real-time.
+ * Each period it is given budget_us of processor time, to be used by the
+ * end of the period. Admission control places it on the first processor
+ * whose real-time utilization stays within RT_UTILIZATION_MAX, which EDF
+ * can always schedule, and rejects it if there is none.
+ * 
+ * @param pcb The process, before start_process.
+ * @param period_us Period and relative deadline in micro seconds.
+ * @param budget_us Processor time per period in micro seconds.
+ * @return int TRUE if admitted, FALSE if the set would be infeasible.
+ */
+int set_realtime(pcb_t* pcb, unsigned int period_us, unsigned int budget_us);
+
+/**
+ * @brief Removes an exiting process from its processor's real-time tasks
+ * and returns its utilization. Does nothing for normal processes.
+ * 
+ * @param pcb The process.
+ */
+void clear_realtime(pcb_t* pcb);
+
+/**
+ * @brief Picks the ready real-time process with the earliest deadline.
+ * Called by next_process ahead of the ready queue.
+ * 
+ * @param cpu The calling processor's data.
+ * @return pcb_t* The process, or NULL if none is ready.
+ */
+pcb_t* pick_realtime(struct cpu_s* cpu);
+
+/**
+ * @brief Real-time part of the tick: charges the current process's budget
+ * (throttling it to its next period on overrun), releases processes whose
+ * period has started and counts late jobs as misses.
+ * 
+ * @param cpu The calling processor's data.
+ * @param current The running process.
+ * @return int TRUE if a ready real-time process has an earlier deadline
+ * than the running process.
+ */
+int realtime_tick(struct cpu_s* cpu, pcb_t* current);
+
+/**
+ * @brief Ends the calling real-time process's job for this period and
+ * sleeps until the next period starts. A job finishing after its deadline
+ * counts as a miss.
+ * 
+ * @return int TRUE, or FALSE if the caller is not a real-time process.
+ */
+int wait_period();
+
+/**
+ * @brief Gives up the processor: puts the current process at the back of
+ * its ready queue and switches to the next process with switch_process.
+ * 
+ */
+void yield();
+
+/**
+ * @brief Chooses the processor for a new process (round robin).
+ * 
+ * @return unsigned int Index of the processor.
+ */
+unsigned int assign_cpu();
+
+#endif
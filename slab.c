@@ -0,0 +1,171 @@
+/**
+ * @file slab.c
+ * @author Robert McKay
+ * @brief Implements the slab allocator for fixed size kernel objects.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "slab.h"
+#include "buffer.h"
+#include "pmm.h"
+#include "scheduler.h"
+#include "cpu.h"
+
+cache_t* caches[MAX_CACHES];
+unsigned int cache_count;
+
+void init_cache(cache_t* cache, char* name, unsigned int object_size,
+                void (*constructor)(void* object)) {
+    unsigned int header = (sizeof(slab_t) + 3) & ~3;
+
+    /* the free list link overlays a plain object, but must not overwrite a
+       constructed one */
+    object_size = (object_size + 3) & ~3;
+    if (object_size < sizeof(unsigned int)) {
+        object_size = sizeof(unsigned int);
+    }
+    cache->name = name;
+    cache->object_size = object_size;
+    cache->constructor = constructor;
+    if (constructor == NULL) {
+        cache->link_offset = 0;
+        cache->stride = object_size;
+    } else {
+        cache->link_offset = object_size;
+        cache->stride = object_size + sizeof(unsigned int);
+    }
+    cache->objects_per_slab = (PAGE_SIZE - header) / cache->stride;
+    cache->partial = NULL;
+    cache->full = NULL;
+    cache->empty = NULL;
+    cache->slabs = 0;
+    cache->in_use = 0;
+    cache->allocs = 0;
+    cache->frees = 0;
+    init_lock(&cache->lock, name);
+    if (cache_count < MAX_CACHES) {
+        caches[cache_count++] = cache;
+    }
+    register_lock_stat(&cache->lock.stat);
+}
+
+HOT void* cache_alloc(cache_t* cache) {
+    unsigned int flags = acquire_irqsave(&cache->lock);
+    slab_t* slab = cache->partial;
+    unsigned int object;
+
+    if (slab == NULL) {
+        slab = cache->empty;
+        if (slab != NULL) {
+            slab_remove(&cache->empty, slab);
+        } else {
+            slab = new_slab(cache);
+        }
+        if (slab == NULL) {
+            release_irqrestore(&cache->lock, flags);
+            return NULL;
+        }
+        slab_push(&cache->partial, slab);
+    }
+
+    /* take the most recently freed object */
+    object = slab->free;
+    slab->free = *(unsigned int*)(object + cache->link_offset);
+    slab->in_use++;
+    if (slab->in_use == cache->objects_per_slab) {
+        slab_remove(&cache->partial, slab);
+        slab_push(&cache->full, slab);
+    }
+    cache->in_use++;
+    cache->allocs++;
+    release_irqrestore(&cache->lock, flags);
+    return (void*)object;
+}
+
+HOT void cache_free(cache_t* cache, void* object) {
+    slab_t* slab = (slab_t*)((unsigned int)object & ~(PAGE_SIZE - 1));
+    unsigned int flags = acquire_irqsave(&cache->lock);
+
+    *(unsigned int*)((unsigned int)object + cache->link_offset) = slab->free;
+    slab->free = (unsigned int)object;
+    if (slab->in_use == cache->objects_per_slab) {
+        slab_remove(&cache->full, slab);
+        slab_push(&cache->partial, slab);
+    }
+    slab->in_use--;
+    cache->in_use--;
+    cache->frees++;
+
+    /* keep one empty slab, give the rest back to the page allocator */
+    if (slab->in_use == 0) {
+        slab_remove(&cache->partial, slab);
+        if (cache->empty == NULL) {
+            slab_push(&cache->empty, slab);
+        } else {
+            cache->slabs--;
+            free_page((unsigned int)slab);
+        }
+    }
+    release_irqrestore(&cache->lock, flags);
+}
+
+slab_t* new_slab(cache_t* cache) {
+    unsigned int header = (sizeof(slab_t) + 3) & ~3;
+    unsigned int object;
+    slab_t* slab = (slab_t*)alloc_page();
+    if (slab == NULL || cache->objects_per_slab == 0) {
+        free_page((unsigned int)slab);
+        return NULL;
+    }
+    slab->next = NULL;
+    slab->prev = NULL;
+    slab->cache = cache;
+    slab->in_use = 0;
+
+    /* link the objects in address order, constructing each one */
+    slab->free = NULL;
+    for (unsigned int i = cache->objects_per_slab; i > 0; i--) {
+        object = (unsigned int)slab + header + (i - 1) * cache->stride;
+        if (cache->constructor != NULL) {
+            cache->constructor((void*)object);
+        }
+        *(unsigned int*)(object + cache->link_offset) = slab->free;
+        slab->free = object;
+    }
+    cache->slabs++;
+    return slab;
+}
+
+unsigned int slab_fragmentation(cache_t* cache) {
+    /* in 16 byte units so the percentage cannot overflow */
+    unsigned int total = cache->slabs * (PAGE_SIZE / 16);
+    unsigned int used = cache->in_use * cache->object_size / 16;
+    if (total == 0) {
+        return 0;
+    }
+    return (total - used) * 100 / total;
+}
+
+void slab_push(slab_t** list, slab_t* slab) {
+    slab->prev = NULL;
+    slab->next = *list;
+    if (*list != NULL) {
+        (*list)->prev = slab;
+    }
+    *list = slab;
+}
+
+void slab_remove(slab_t** list, slab_t* slab) {
+    if (slab->prev != NULL) {
+        slab->prev->next = slab->next;
+    } else {
+        *list = slab->next;
+    }
+    if (slab->next != NULL) {
+        slab->next->prev = slab->prev;
+    }
+    slab->next = NULL;
+    slab->prev = NULL;
+}
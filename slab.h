@@ -0,0 +1,136 @@
+/**
+ * @file slab.h
+ * @author Robert McKay
+ * @brief Declares the slab allocator for fixed size kernel objects.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "lock.h"
+
+/* maximum number of caches listed in caches */
+#define MAX_CACHES 16
+
+/**
+ * @brief Header at the start of each slab page. The objects follow it.
+ *
+ */
+struct slab_s {
+    struct slab_s* next;
+    struct slab_s* prev;
+    struct cache_s* cache;
+    unsigned int free;
+    unsigned int in_use;
+};
+
+/**
+ * @brief Type definition for a slab.
+ *
+ */
+typedef struct slab_s slab_t;
+
+/**
+ * @brief Structure for a cache of objects of one type.
+ *
+ */
+struct cache_s {
+    char* name;
+    unsigned int object_size;
+    unsigned int stride;
+    unsigned int link_offset;
+    unsigned int objects_per_slab;
+    void (*constructor)(void* object);
+    slab_t* partial;
+    slab_t* full;
+    slab_t* empty;
+    unsigned int slabs;
+    unsigned int in_use;
+    unsigned int allocs;
+    unsigned int frees;
+    spinlock_t lock;
+};
+
+/**
+ * @brief Type definition for an object cache.
+ *
+ */
+typedef struct cache_s cache_t;
+
+/**
+ * @brief Every initialized cache, in initialization order.
+ *
+ */
+extern cache_t* caches[MAX_CACHES];
+
+/**
+ * @brief Number of entries in caches.
+ *
+ */
+extern unsigned int cache_count;
+
+/**
+ * @brief Initializes an empty cache. Objects must fit in one page.
+ *
+ * @param cache The cache to initialize.
+ * @param name Name reported with the cache's statistics.
+ * @param object_size Size of one object in bytes.
+ * @param constructor Called once on each object when its slab is created,
+ * freed objects must be returned in the constructed state. May be NULL.
+ */
+void init_cache(cache_t* cache, char* name, unsigned int object_size,
+                void (*constructor)(void* object));
+
+/**
+ * @brief Allocates an object, reusing the most recently freed one.
+ *
+ * @param cache The cache to allocate from.
+ * @return void* The object, NULL if out of memory.
+ */
+void* cache_alloc(cache_t* cache);
+
+/**
+ * @brief Returns an object to its cache.
+ *
+ * @param cache The cache the object was allocated from.
+ * @param object The object to free.
+ */
+void cache_free(cache_t* cache, void* object);
+
+/**
+ * @brief Allocates a page and carves it into objects. Called with the cache
+ * lock held.
+ *
+ * @param cache The cache to grow.
+ * @return slab_t* The new slab, NULL if out of memory.
+ */
+slab_t* new_slab(cache_t* cache);
+
+/**
+ * @brief Percentage of the cache's slab memory not holding live objects.
+ *
+ * @param cache The cache to measure.
+ * @return unsigned int Fragmentation from 0 to 100.
+ */
+unsigned int slab_fragmentation(cache_t* cache);
+
+/**
+ * @brief Adds a slab to the front of a list.
+ *
+ * @param list The list to add to.
+ * @param slab The slab to add.
+ */
+void slab_push(slab_t** list, slab_t* slab);
+
+/**
+ * @brief Removes a slab from a list.
+ *
+ * @param list The list holding the slab.
+ * @param slab The slab to remove.
+ */
+void slab_remove(slab_t** list, slab_t* slab);
+
+#endif
@@ -0,0 +1,204 @@
+/**
+ * @file smp.c
+ * @author Robert McKay
+ * @brief Implements per processor data and application processor start up.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "smp.h"
+#include "apic.h"
+#include "boot2.h"
+#include "buffer.h"
+#include "clock.h"
+#include "driver.h"
+#include "fpu.h"
+#include "idt.h"
+#include "paging.h"
+#include "syscall.h"
+#include "cpu.h"
+
+cpu_t cpus[MAX_CPUS];
+unsigned int cpus_online;
+
+/**
+ * @brief Index of the application processor being started.
+ *
+ */
+volatile unsigned int ap_cpu;
+
+/**
+ * @brief Top of the stack for the application processor being started.
+ * Loaded into esp by ap_protected in boot2.S.
+ *
+ */
+volatile unsigned int ap_stack;
+
+/**
+ * @brief APIC id of the application processor being started, or
+ * APIC_ID_NONE. ap_protected swaps it for APIC_ID_NONE to claim the start
+ * up, and start_ap does the same when it gives up, so a processor that
+ * wakes too late halts instead of running on a freed stack.
+ *
+ */
+volatile unsigned int ap_apic_id = APIC_ID_NONE;
+
+INIT void init_bsp() {
+    cpus_online = 1;
+    init_cpu(0, 0);
+    cpus[0].stack = (unsigned int)boot_stack_top;
+    load_cpu(0);
+}
+
+INIT void init_smp() {
+    unsigned char* source = (unsigned char*)ap_trampoline;
+    unsigned char* destination = (unsigned char*)TRAMPOLINE_ADDRESS;
+    unsigned int size = (unsigned int)ap_trampoline_end - (unsigned int)ap_trampoline;
+
+    init_idle(0);
+
+    /* application processors need the local APIC and a calibrated TSC */
+    if (lapic_eoi == NULL || tsc_khz == 0) {
+        return;
+    }
+    cpus[0].apic_id = lapic_id();
+
+    /* copy the real mode trampoline below 1 MB and give it the BSP's GDT */
+    for (unsigned int i = 0; i < size; i++) {
+        destination[i] = source[i];
+    }
+    gdt_r_t* gdtr = (gdt_r_t*)(destination + ((unsigned int)ap_gdtr - (unsigned int)ap_trampoline));
+    gdtr->limit = cpus[0].gdtr.limit;
+    gdtr->base = cpus[0].gdtr.base;
+
+    for (unsigned int i = 0; i < cpu_count && cpus_online < MAX_CPUS; i++) {
+        if (cpu_apic_ids[i] == cpus[0].apic_id) {
+            continue;
+        }
+        if (start_ap(cpus_online, cpu_apic_ids[i]) == TRUE) {
+            cpus_online++;
+        }
+    }
+}
+
+INIT void init_cpu(unsigned int id, unsigned int apic_id) {
+    cpu_t* cpu = &cpus[id];
+    cpu->self = cpu;
+    cpu->current = NULL;
+    cpu->id = id;
+    cpu->bh_active = FALSE;
+    cpu->bh_pending = 0;
+    cpu->stack = NULL;
+    cpu->apic_id = apic_id;
+    cpu->started = FALSE;
+    cpu->idle = NULL;
+    cpu->next_deadline = 0;
+    cpu->page_cache_count = 0;
+    cpu->fpu_owner = NULL;
+    cpu->fpu_live = FALSE;
+    init_lock(&cpu->rt_lock, "real-time tasks");
+    cpu->rt_tasks = NULL;
+    cpu->rt_utilization = 0;
+    cpu->tss.ss0 = KERNEL_DATA_SEL;
+    cpu->tss.esp0 = NULL;
+    cpu->tss.iomap_base = sizeof(tss_t);
+    init_queue(&cpu->ready_queue, "ready queue");
+    init_queue(&cpu->boosted_queue, "boosted queue");
+    register_lock_stat(&cpu->rt_lock.stat);
+    register_lock_stat(&cpu->ready_queue.lock.stat);
+    register_lock_stat(&cpu->boosted_queue.lock.stat);
+}
+
+void load_cpu(unsigned int id) {
+    initGDT(cpus[id].gdt, &cpus[id].gdtr, (unsigned int)&cpus[id], sizeof(cpu_t),
+            &cpus[id].tss);
+    /* SYSENTER starts below the address of tss.esp0, on its own stack */
+    cpus[id].sysenter_esp0 = (unsigned int)&cpus[id].tss.esp0;
+    init_sysenter((unsigned int)&cpus[id].sysenter_esp0);
+    init_fpu();
+}
+
+INIT int init_idle(unsigned int id) {
+    pcb_t* pcb = new_process((unsigned int)p_idle, SMALL_STACK_SIZE);
+    if (pcb == NULL) {
+        return FALSE;
+    }
+    pcb->cpu = id;
+    cpus[id].idle = pcb;
+    return TRUE;
+}
+
+/**
+ * @brief Frees the idle process of a processor that did not start, before
+ * it ever ran.
+ *
+ * @param id Index of the processor.
+ */
+INIT static void free_idle(unsigned int id) {
+    pcb_t* pcb = cpus[id].idle;
+    free_stack(pcb->stack, pcb->stack_size);
+    unsigned int flags = acquire_irqsave(&process_lock);
+    free_process(pcb);
+    release_irqrestore(&process_lock, flags);
+    cpus[id].idle = NULL;
+}
+
+INIT int start_ap(unsigned int id, unsigned int apic_id) {
+    unsigned long long timeout;
+
+    init_cpu(id, apic_id);
+    if (init_idle(id) == FALSE) {
+        return FALSE;
+    }
+    /* a page of stack until ap_main runs go */
+    ap_stack = alloc_page();
+    if (ap_stack == NULL) {
+        free_idle(id);
+        return FALSE;
+    }
+    ap_stack += PAGE_SIZE;
+    cpus[id].stack = ap_stack;
+    ap_cpu = id;
+    ap_apic_id = apic_id;
+
+    /* INIT, then up to two startup IPIs pointing at the trampoline page */
+    send_init(apic_id);
+    delay_us(INIT_DELAY_US);
+    send_startup(apic_id, TRAMPOLINE_ADDRESS >> 12);
+    delay_us(SIPI_DELAY_US);
+    if (cpus[id].started == FALSE) {
+        send_startup(apic_id, TRAMPOLINE_ADDRESS >> 12);
+    }
+
+    /* wait for ap_main to report in */
+    timeout = clock_ns() + (unsigned long long)AP_TIMEOUT_US * 1000;
+    while (cpus[id].started == FALSE && clock_ns() < timeout) {
+        asm volatile ("pause");
+    }
+
+    /* give up unless it claimed the start up, then it is already in
+       ap_main and reports in shortly */
+    if (cpus[id].started == FALSE
+        && __sync_bool_compare_and_swap(&ap_apic_id, apic_id, APIC_ID_NONE)) {
+        free_page(cpus[id].stack - PAGE_SIZE);
+        cpus[id].stack = NULL;
+        free_idle(id);
+        return FALSE;
+    }
+    while (cpus[id].started == FALSE) {
+        asm volatile ("pause");
+    }
+    return TRUE;
+}
+
+void ap_main() {
+    cpu_t* cpu = &cpus[ap_cpu];
+    load_paging();
+    load_cpu(cpu->id);
+    lidtr((unsigned int)&idtr);
+    enable_lapic();
+    init_lapic_timer();
+    cpu->started = TRUE;
+    go();
+}
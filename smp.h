@@ -0,0 +1,166 @@
+/**
+ * @file smp.h
+ * @author Robert McKay
+ * @brief Declares per processor data and application processor start up.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef SMP_H
+#define SMP_H
+
+#include "acpi.h"
+#include "cpu.h"
+#include "gdt.h"
+#include "pmm.h"
+#include "scheduler.h"
+
+/* physical page the application processors start in (SIPI vector 0x08) */
+#define TRAMPOLINE_ADDRESS 0x8000
+
+/* start up timing from the MP specification, in micro seconds */
+#define INIT_DELAY_US 10000
+#define SIPI_DELAY_US 200
+#define AP_TIMEOUT_US 100000
+
+/* stack SYSENTER starts on, only used until sysenter_entry reaches the
+   process's kernel stack by a debug trap or NMI taken on its way there */
+#define SYSENTER_STACK_SIZE 1024
+
+/* ap_apic_id when no application processor is expected to start */
+#define APIC_ID_NONE 0xffffffff
+
+/**
+ * @brief Structure for per processor data, reached through gs.
+ * The offsets of the first five fields are fixed: this_cpu and
+ * current_process read self and current, and boot2.S reads current, id,
+ * bh_active and stack (CPU_CURRENT, CPU_ID, CPU_BH_ACTIVE, CPU_STACK).
+ * Each one starts on its own cache line, so processors do not share lines
+ * through their data.
+ *
+ */
+struct cpu_s {
+    struct cpu_s* self;
+    pcb_t* current;
+    unsigned int id;
+    volatile unsigned int bh_active;
+    unsigned int stack;
+    volatile unsigned int bh_pending;
+    unsigned int apic_id;
+    volatile unsigned int started;
+    pcb_t* idle;
+    queue_t ready_queue;
+    queue_t boosted_queue;
+    unsigned long long next_deadline;
+    gdt_entry_t gdt[GDT_ENTRIES];
+    gdt_r_t gdtr;
+    tss_t tss;
+    unsigned int sysenter_stack[SYSENTER_STACK_SIZE / sizeof(unsigned int)];
+    unsigned int sysenter_esp0;
+    unsigned int page_cache_count;
+    unsigned int page_cache[PAGE_CACHE_SIZE];
+    pcb_t* fpu_owner;
+    unsigned int fpu_live;
+    spinlock_t rt_lock;
+    pcb_t* rt_tasks;
+    unsigned int rt_utilization;
+} CACHE_ALIGNED;
+
+/**
+ * @brief Type definition for per processor data.
+ *
+ */
+typedef struct cpu_s cpu_t;
+
+/**
+ * @brief Per processor data, indexed by processor number (0 is the BSP).
+ *
+ */
+extern cpu_t cpus[MAX_CPUS];
+
+/**
+ * @brief Number of processors running processes.
+ *
+ */
+extern unsigned int cpus_online;
+
+/**
+ * @brief Returns the calling processor's data.
+ *
+ * @return cpu_t* Pointer to the per processor data.
+ */
+static inline cpu_t* this_cpu() {
+    cpu_t* cpu;
+    asm volatile ("movl %%gs:0, %0" : "=r" (cpu));
+    return cpu;
+}
+
+/**
+ * @brief Returns the process running on the calling processor.
+ *
+ * @return pcb_t* Pointer to the pcb of the current process.
+ */
+static inline pcb_t* current_process() {
+    pcb_t* pcb;
+    asm volatile ("movl %%gs:4, %0" : "=r" (pcb));
+    return pcb;
+}
+
+/**
+ * @brief Sets up the bootstrap processor's data and GDT. Must run before
+ * anything that uses this_cpu.
+ *
+ */
+void init_bsp();
+
+/**
+ * @brief Creates the idle process of each processor and starts the
+ * application processors listed in the MADT.
+ *
+ */
+void init_smp();
+
+/**
+ * @brief Initializes the data of a processor.
+ *
+ * @param id Index of the processor.
+ * @param apic_id Local APIC id of the processor.
+ */
+void init_cpu(unsigned int id, unsigned int apic_id);
+
+/**
+ * @brief Loads a processor's GDT, per processor segment and TSS on the
+ * caller and points its SYSENTER stack at the TSS.
+ *
+ * @param id Index of the processor.
+ */
+void load_cpu(unsigned int id);
+
+/**
+ * @brief Creates the idle process of a processor.
+ *
+ * @param id Index of the processor.
+ * @return int TRUE if the idle process was created, FALSE otherwise.
+ */
+int init_idle(unsigned int id);
+
+/**
+ * @brief Starts an application processor with INIT-SIPI-SIPI. If it does
+ * not start, its idle process and stack are freed and it halts should it
+ * wake later.
+ *
+ * @param id Index to give the processor.
+ * @param apic_id Local APIC id of the processor.
+ * @return int TRUE if the processor started, FALSE otherwise.
+ */
+int start_ap(unsigned int id, unsigned int apic_id);
+
+/**
+ * @brief First C code run by an application processor.
+ * Called by ap_protected in boot2.S.
+ *
+ */
+void ap_main();
+
+#endif
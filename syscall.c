@@ -0,0 +1,226 @@
+/**
+ * @file syscall.c
+ * @author Robert McKay
+ * @brief Implements the system call table and the wrappers user processes
+ * call.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#include "syscall.h"
+#include "boot2.h"
+#include "buffer.h"
+#include "cpu.h"
+#include "fat.h"
+#include "gdt.h"
+#include "io.h"
+#include "paging.h"
+#include "process.h"
+#include "scheduler.h"
+#include "smp.h"
+
+syscall_t syscall_table[SYSCALL_COUNT] = {
+    syscall_null,
+    syscall_exit,
+    syscall_print,
+    syscall_println,
+    syscall_yield,
+    syscall_set_quantum,
+    syscall_wait_period,
+    syscall_open,
+    syscall_read,
+    syscall_close,
+    syscall_fork
+};
+
+USER_READ int sysenter_enabled;
+
+void init_sysenter(unsigned int stack) {
+    unsigned int regs[4];
+    cpuid(1, regs);
+    sysenter_enabled = (regs[3] & CPUID_EDX_SEP) != 0;
+    if (sysenter_enabled == FALSE) {
+        return;
+    }
+    wrmsr(IA32_SYSENTER_CS, KERNEL_CODE_SEL);
+    wrmsr(IA32_SYSENTER_ESP, stack);
+    wrmsr(IA32_SYSENTER_EIP, (unsigned int)sysenter_entry);
+}
+
+HOT unsigned int syscall_handler(unsigned int number, unsigned int arg1,
+                                 unsigned int arg2, unsigned int arg3) {
+    if (number >= SYSCALL_COUNT) {
+        return SYSCALL_ERROR;
+    }
+    return syscall_table[number](arg1, arg2, arg3);
+}
+
+unsigned int syscall_null(unsigned int arg1, unsigned int arg2, unsigned int arg3) {
+    (void)arg1;
+    (void)arg2;
+    (void)arg3;
+    return 0;
+}
+
+unsigned int syscall_exit(unsigned int code, unsigned int arg2, unsigned int arg3) {
+    (void)arg2;
+    (void)arg3;
+    exit_process(code);
+    return 0;
+}
+
+unsigned int syscall_print(unsigned int text, unsigned int length,
+                           unsigned int position) {
+    char buffer[NUM_COLS];
+    if (length > NUM_COLS || position >= NUM_ROWS * NUM_COLS
+        || user_accessible(text, length) == FALSE) {
+        return SYSCALL_ERROR;
+    }
+
+    /* copy first so the text cannot change after it was checked */
+    for (unsigned int i = 0; i < length; i++) {
+        buffer[i] = ((char*)text)[i];
+    }
+    k_print(buffer, length, position % NUM_COLS, position / NUM_COLS);
+    return 0;
+}
+
+unsigned int syscall_println(unsigned int text, unsigned int length,
+                             unsigned int arg3) {
+    char buffer[NUM_COLS + 1];
+    (void)arg3;
+    if (length > NUM_COLS || user_accessible(text, length) == FALSE) {
+        return SYSCALL_ERROR;
+    }
+    for (unsigned int i = 0; i < length; i++) {
+        buffer[i] = ((char*)text)[i];
+    }
+    buffer[length] = NULL_TERMINATOR;
+    return println_row(buffer);
+}
+
+unsigned int syscall_yield(unsigned int arg1, unsigned int arg2, unsigned int arg3) {
+    (void)arg1;
+    (void)arg2;
+    (void)arg3;
+    yield();
+    return 0;
+}
+
+unsigned int syscall_set_quantum(unsigned int min_us, unsigned int max_us,
+                                 unsigned int arg3) {
+    (void)arg3;
+    set_quantum(current_process(), min_us, max_us);
+    return 0;
+}
+
+unsigned int syscall_wait_period(unsigned int arg1, unsigned int arg2,
+                                 unsigned int arg3) {
+    (void)arg1;
+    (void)arg2;
+    (void)arg3;
+    if (wait_period() == FALSE) {
+        return SYSCALL_ERROR;
+    }
+    return 0;
+}
+
+unsigned int syscall_open(unsigned int path, unsigned int length,
+                          unsigned int arg3) {
+    char buffer[FAT_PATH_MAX];
+    (void)arg3;
+    if (length >= FAT_PATH_MAX || user_accessible(path, length) == FALSE) {
+        return SYSCALL_ERROR;
+    }
+    for (unsigned int i = 0; i < length; i++) {
+        buffer[i] = ((char*)path)[i];
+    }
+    buffer[length] = NULL_TERMINATOR;
+    return fat_open(buffer);
+}
+
+unsigned int syscall_read(unsigned int fd, unsigned int buffer,
+                          unsigned int length) {
+    if (user_writable(buffer, length) == FALSE) {
+        return SYSCALL_ERROR;
+    }
+    return fat_read(fd, (void*)buffer, length);
+}
+
+unsigned int syscall_close(unsigned int fd, unsigned int arg2, unsigned int arg3) {
+    (void)arg2;
+    (void)arg3;
+    return fat_close(fd);
+}
+
+unsigned int syscall_fork(unsigned int arg1, unsigned int arg2, unsigned int arg3) {
+    (void)arg1;
+    (void)arg2;
+    (void)arg3;
+    pcb_t* pcb = fork_process(FALSE);
+    if (pcb == NULL) {
+        return SYSCALL_ERROR;
+    }
+
+    /* the child may exit and be reaped as soon as it is started */
+    unsigned int pid = pcb->pid;
+    start_process(pcb);
+    return pid;
+}
+
+unsigned int user_syscall(unsigned int number, unsigned int arg1,
+                          unsigned int arg2, unsigned int arg3) {
+    if (sysenter_enabled) {
+        return syscall_fast(number, arg1, arg2, arg3);
+    }
+    return syscall_int(number, arg1, arg2, arg3);
+}
+
+void sys_null() {
+    user_syscall(SYS_NULL, 0, 0, 0);
+}
+
+void sys_exit(unsigned int code) {
+    user_syscall(SYS_EXIT, code, 0, 0);
+}
+
+void sys_print(char* text, int length, int column, int row) {
+    user_syscall(SYS_PRINT, (unsigned int)text, length, row * NUM_COLS + column);
+}
+
+int sys_println(char* text) {
+    return user_syscall(SYS_PRINTLN, (unsigned int)text, string_size(text), 0);
+}
+
+void sys_yield() {
+    user_syscall(SYS_YIELD, 0, 0, 0);
+}
+
+void sys_set_quantum(unsigned int min_us, unsigned int max_us) {
+    user_syscall(SYS_SET_QUANTUM, min_us, max_us, 0);
+}
+
+int sys_wait_period() {
+    return user_syscall(SYS_WAIT_PERIOD, 0, 0, 0);
+}
+
+int sys_open(char* path) {
+    return user_syscall(SYS_OPEN, (unsigned int)path, string_size(path), 0);
+}
+
+int sys_read(int fd, void* buffer, unsigned int length) {
+    return user_syscall(SYS_READ, fd, (unsigned int)buffer, length);
+}
+
+int sys_close(int fd) {
+    return user_syscall(SYS_CLOSE, fd, 0, 0);
+}
+
+int sys_fork() {
+    return user_syscall(SYS_FORK, 0, 0, 0);
+}
+
+void user_return() {
+    sys_exit(EXIT_SUCCESS);
+}
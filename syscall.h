@@ -0,0 +1,288 @@
+/**
+ * @file syscall.h
+ * @author Robert McKay
+ * @brief Declares the system call table, its int 0x80 and SYSENTER entry
+ * points, and the wrappers user processes call.
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ */
+
+#ifndef SYSCALL_H
+#define SYSCALL_H
+
+/* interrupt gate for system calls, reachable from ring 3 */
+#define SYSCALL_VECTOR 0x80
+#define SYSCALL_GATE 0xef
+
+/* model specific registers for SYSENTER */
+#define IA32_SYSENTER_CS 0x174
+#define IA32_SYSENTER_ESP 0x175
+#define IA32_SYSENTER_EIP 0x176
+
+/* system call numbers */
+#define SYS_NULL 0
+#define SYS_EXIT 1
+#define SYS_PRINT 2
+#define SYS_PRINTLN 3
+#define SYS_YIELD 4
+#define SYS_SET_QUANTUM 5
+#define SYS_WAIT_PERIOD 6
+#define SYS_OPEN 7
+#define SYS_READ 8
+#define SYS_CLOSE 9
+#define SYS_FORK 10
+#define SYSCALL_COUNT 11
+
+/* returned for an unknown call or a bad argument */
+#define SYSCALL_ERROR 0xffffffff
+
+/**
+ * @brief Type definition for a system call, taking up to three arguments.
+ *
+ */
+typedef unsigned int (*syscall_t)(unsigned int arg1, unsigned int arg2,
+                                  unsigned int arg3);
+
+/**
+ * @brief System calls indexed by number.
+ *
+ */
+extern syscall_t syscall_table[SYSCALL_COUNT];
+
+/**
+ * @brief TRUE if the processor supports SYSENTER and SYSEXIT.
+ *
+ */
+extern int sysenter_enabled;
+
+/**
+ * @brief Points the calling processor's SYSENTER MSRs at sysenter_entry.
+ * SYSENTER starts on a small per processor stack, whose top word holds the
+ * address of the esp0 field of the processor's TSS, the kernel stack of the
+ * current process.
+ *
+ * @param stack Top of the processor's SYSENTER stack.
+ */
+void init_sysenter(unsigned int esp0);
+
+/**
+ * @brief Runs a system call. Called by syscall_enter and sysenter_entry in
+ * boot2.S with the caller's eax, ebx, esi and edi.
+ *
+ * @param number The system call number.
+ * @param arg1 First argument.
+ * @param arg2 Second argument.
+ * @param arg3 Third argument.
+ * @return unsigned int The result, SYSCALL_ERROR for an unknown call.
+ */
+unsigned int syscall_handler(unsigned int number, unsigned int arg1,
+                             unsigned int arg2, unsigned int arg3);
+
+/**
+ * @brief Does nothing, to measure the cost of a system call.
+ *
+ * @return unsigned int Always 0.
+ */
+unsigned int syscall_null(unsigned int arg1, unsigned int arg2, unsigned int arg3);
+
+/**
+ * @brief Ends the calling process.
+ *
+ * @param code The exit code.
+ * @return unsigned int Does not return.
+ */
+unsigned int syscall_exit(unsigned int code, unsigned int arg2, unsigned int arg3);
+
+/**
+ * @brief Prints user text at a position on the screen.
+ *
+ * @param text Address of the text.
+ * @param length Length of the text, at most NUM_COLS.
+ * @param position row * NUM_COLS + column.
+ * @return unsigned int 0, or SYSCALL_ERROR if the text is not user memory.
+ */
+unsigned int syscall_print(unsigned int text, unsigned int length,
+                           unsigned int position);
+
+/**
+ * @brief Prints user text on the current line and moves to the next.
+ *
+ * @param text Address of the text.
+ * @param length Length of the text, at most NUM_COLS.
+ * @return unsigned int The row printed on, or SYSCALL_ERROR if the text is
+ * not user memory.
+ */
+unsigned int syscall_println(unsigned int text, unsigned int length,
+                             unsigned int arg3);
+
+/**
+ * @brief Gives up the processor to the next ready process.
+ *
+ * @return unsigned int 0.
+ */
+unsigned int syscall_yield(unsigned int arg1, unsigned int arg2, unsigned int arg3);
+
+/**
+ * @brief Limits the quantum of the calling process.
+ *
+ * @param min_us Shortest quantum in micro seconds.
+ * @param max_us Longest quantum in micro seconds.
+ * @return unsigned int 0.
+ */
+unsigned int syscall_set_quantum(unsigned int min_us, unsigned int max_us,
+                                 unsigned int arg3);
+
+/**
+ * @brief Ends the calling real-time process's job and sleeps until its
+ * next period.
+ *
+ * @return unsigned int 0, or SYSCALL_ERROR if the caller is not real-time.
+ */
+unsigned int syscall_wait_period(unsigned int arg1, unsigned int arg2,
+                                 unsigned int arg3);
+
+/**
+ * @brief Opens a file on the floppy for reading.
+ *
+ * @param path Address of the path.
+ * @param length Length of the path, less than FAT_PATH_MAX.
+ * @return unsigned int File descriptor, or SYSCALL_ERROR.
+ */
+unsigned int syscall_open(unsigned int path, unsigned int length,
+                          unsigned int arg3);
+
+/**
+ * @brief Reads from an open file into user memory.
+ *
+ * @param fd File descriptor.
+ * @param buffer Address of the buffer.
+ * @param length Bytes wanted.
+ * @return unsigned int Bytes read, or SYSCALL_ERROR.
+ */
+unsigned int syscall_read(unsigned int fd, unsigned int buffer,
+                          unsigned int length);
+
+/**
+ * @brief Closes an open file.
+ *
+ * @param fd File descriptor.
+ * @return unsigned int 0, or SYSCALL_ERROR.
+ */
+unsigned int syscall_close(unsigned int fd, unsigned int arg2, unsigned int arg3);
+
+/**
+ * @brief Duplicates the calling process, sharing its pages copy-on-write,
+ * and starts the child.
+ *
+ * @return unsigned int The child's pid in the parent, 0 in the child, or
+ * SYSCALL_ERROR.
+ */
+unsigned int syscall_fork(unsigned int arg1, unsigned int arg2, unsigned int arg3);
+
+/**
+ * @brief Makes a system call from user mode with SYSENTER if the processor
+ * supports it, otherwise with int 0x80.
+ *
+ * @param number The system call number.
+ * @param arg1 First argument.
+ * @param arg2 Second argument.
+ * @param arg3 Third argument.
+ * @return unsigned int The result of the call.
+ */
+unsigned int user_syscall(unsigned int number, unsigned int arg1,
+                          unsigned int arg2, unsigned int arg3);
+
+/**
+ * @brief User wrapper for SYS_NULL.
+ *
+ */
+void sys_null();
+
+/**
+ * @brief User wrapper for SYS_EXIT.
+ *
+ * @param code The exit code.
+ */
+void sys_exit(unsigned int code);
+
+/**
+ * @brief User wrapper for SYS_PRINT.
+ *
+ * @param text The text to print.
+ * @param length Length of the text.
+ * @param column Column of the first character.
+ * @param row Row to print on.
+ */
+void sys_print(char* text, int length, int column, int row);
+
+/**
+ * @brief User wrapper for SYS_PRINTLN.
+ *
+ * @param text Null terminated text to print.
+ * @return int The row printed on.
+ */
+int sys_println(char* text);
+
+/**
+ * @brief User wrapper for SYS_YIELD.
+ *
+ */
+void sys_yield();
+
+/**
+ * @brief User wrapper for SYS_SET_QUANTUM.
+ *
+ * @param min_us Shortest quantum in micro seconds.
+ * @param max_us Longest quantum in micro seconds.
+ */
+void sys_set_quantum(unsigned int min_us, unsigned int max_us);
+
+/**
+ * @brief User wrapper for SYS_WAIT_PERIOD.
+ *
+ * @return int 0, or -1 if the caller is not real-time.
+ */
+int sys_wait_period();
+
+/**
+ * @brief User wrapper for SYS_OPEN.
+ *
+ * @param path Null terminated path of the file.
+ * @return int File descriptor, or -1.
+ */
+int sys_open(char* path);
+
+/**
+ * @brief User wrapper for SYS_READ.
+ *
+ * @param fd File descriptor.
+ * @param buffer Receives the data.
+ * @param length Bytes wanted.
+ * @return int Bytes read, or -1.
+ */
+int sys_read(int fd, void* buffer, unsigned int length);
+
+/**
+ * @brief User wrapper for SYS_CLOSE.
+ *
+ * @param fd File descriptor.
+ * @return int 0, or -1.
+ */
+int sys_close(int fd);
+
+/**
+ * @brief User wrapper for SYS_FORK.
+ *
+ * @return int The child's pid in the parent, 0 in the child, or -1.
+ */
+int sys_fork();
+
+/**
+ * @brief Return address of a user process's entry point, exits with
+ * EXIT_SUCCESS.
+ *
+ */
+void user_return();
+
+#endif
@@ -0,0 +1,139 @@
+;---------------------------------- unlz4.asm ----------------------------------
+;
+;    Stub that starts an LZ4 compressed kernel. boot2z is this stub followed
+;    by boot2 packed in the legacy LZ4 frame format (lz4 -l), so boot1 reads
+;    fewer sectors from the floppy than for the raw boot2.
+;
+;    boot1 loads BOOT2 at IMAGE_START and jumps to the address of
+;    kernel_entry, so the stub starts at the same offset in its image. It
+;    moves itself and the packed kernel to UNLZ4_ADDRESS, unpacks the kernel
+;    to IMAGE_START in its place and jumps to kernel_entry, with UNLZ4_MAGIC
+;    in eax and the address of unlz4_info in ebx. The kernel must fit below
+;    UNLZ4_ADDRESS (448 KB), and boot2z below the EBDA (127 KB).
+;
+;    Assemble with the address of kernel_entry:
+;        nasm -DKERNEL_ENTRY=`./getaddr.sh kernel_entry` -o boot2z unlz4.asm
+;
+;    Author: Robert McKay
+;    Since: 10/19/2026
+;
+;-------------------------------------------------------------------------------
+
+%define IMAGE_START	0x10000		;Where boot1 loads BOOT2 (must match boot1.asm)
+%define UNLZ4_ADDRESS	0x80000		;Where the stub unpacks from
+%define UNLZ4_MAGIC	0x184C2102	;Legacy LZ4 frame magic (must match boot2.S)
+%define MIN_MATCH	4		;Match lengths are stored minus this
+
+%ifndef KERNEL_ENTRY
+  %error "KERNEL_ENTRY must be defined"
+%endif
+
+[BITS 32]
+	org	UNLZ4_ADDRESS
+
+image:
+	times	(KERNEL_ENTRY - IMAGE_START) db 0	;Padding up to the entry
+
+;------------------------------------ start ------------------------------------
+;    Entered from boot1 in protected mode, running at IMAGE_START until it
+;    is moved, so only absolute addresses are used.
+;-------------------------------------------------------------------------------
+start:
+	cld
+	mov	esi, IMAGE_START	;Loaded image
+	mov	edi, UNLZ4_ADDRESS	;Out of the kernel's way
+	mov	ecx, (packed_end - image + 3) / 4
+	rep movsd			;Move it
+	mov	eax, unpack
+	jmp	eax			;Continue in the copy
+
+;----------------------------------- unpack ------------------------------------
+;    Decodes each block of the frame to IMAGE_START. Each block is its size
+;    followed by sequences of a token, literals, a match offset and match.
+;    The last sequence of a block has no match.
+;-------------------------------------------------------------------------------
+unpack:
+	mov	esp, UNLZ4_ADDRESS	;Stack below the copy
+	rdtsc				;Cycles spent in the BIOS and boot1
+	mov	[unlz4_info], eax
+	mov	[unlz4_info+4], edx
+
+	mov	esi, packed
+	mov	edi, IMAGE_START	;Destination
+	lodsd				;Frame magic
+	cmp	eax, UNLZ4_MAGIC
+	jne	halt			;Not packed by lz4 -l
+
+.block:
+	cmp	esi, packed_end		;Any more blocks?
+	jae	done			;No
+	lodsd				;Block size
+	cmp	eax, UNLZ4_MAGIC	;Concatenated frame?
+	je	.block			;Yes: skip its magic
+	lea	edx, [esi+eax]		;End of block
+
+.sequence:
+	xor	eax, eax
+	lodsb				;Token
+	mov	ebx, eax
+	shr	eax, 4			;Literal length
+	call	length
+	rep movsb			;Copy literals
+	cmp	esi, edx		;Last sequence?
+	jae	.block			;Yes
+	xor	eax, eax
+	lodsw				;Match offset
+	mov	ebp, eax
+	mov	eax, ebx
+	and	eax, 0xF		;Match length
+	call	length
+	add	ecx, MIN_MATCH
+	push	esi
+	mov	esi, edi
+	sub	esi, ebp		;Match source, may overlap the destination
+	rep movsb			;Copy match a byte at a time
+	pop	esi
+	jmp	.sequence
+
+done:
+	mov	eax, UNLZ4_MAGIC	;Tell the kernel it was unpacked
+	mov	ebx, unlz4_info
+	mov	ecx, KERNEL_ENTRY
+	jmp	ecx			;Start the kernel
+
+halt:
+	hlt
+	jmp	halt
+
+;----------------------------------- length ------------------------------------
+;    Adds the extra bytes of a literal or match length, which follow when
+;    its 4 bits in the token are all set.
+;
+;    Input: eax = length from the token, esi = next byte
+;    Output: ecx = length, esi past the extra bytes, eax modified
+;-------------------------------------------------------------------------------
+length:
+	mov	ecx, eax
+	cmp	ecx, 0xF		;Extra bytes?
+	jne	.done			;No
+.more:
+	xor	eax, eax
+	lodsb
+	add	ecx, eax
+	cmp	al, 0xFF		;Another one?
+	je	.more			;Yes
+.done:
+	ret
+
+;--------------------------------- unlz4_info ----------------------------------
+;    Read by kernel_entry: TSC when unpacking started and the size of the
+;    image boot1 read.
+;-------------------------------------------------------------------------------
+align 4
+unlz4_info:
+	dd	0, 0			;TSC
+	dd	packed_end - image	;Bytes read by boot1
+
+packed:
+	incbin	"boot2.lz4"
+packed_end: